@@ -0,0 +1,144 @@
+#include "compat/asio.h"
+#include "connection.h"
+#include "output.h"
+#include "test/socket.h"
+#include "wire.h"
+#include "writer.h"
+
+#include "benchmark/benchmark.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/// Number of calls to the global operator new
+static auto allocations = std::atomic<std::size_t>{0};
+
+// The replacements are not inlined so that the compiler does not match calls to `free` against
+// `new` expressions
+[[gnu::noinline]] auto operator new(std::size_t size) -> void* {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (const auto p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] auto operator delete(void* p) noexcept -> void { std::free(p); }
+
+[[gnu::noinline]] auto operator delete(void* p, std::size_t) noexcept -> void { std::free(p); }
+
+namespace {
+
+/// Number of messages received by a connection in each iteration
+constexpr auto messages_per_iteration = 1024;
+
+/// Discards everything written to it
+class null_buffer : public std::streambuf {
+  protected:
+    auto overflow(int_type c) -> int_type override { return traits_type::not_eof(c); }
+    auto xsputn(const char*, std::streamsize n) -> std::streamsize override { return n; }
+};
+
+// These are defined at file scope as they need to outlive any connections
+auto sink_buffer = null_buffer{};
+auto sink = std::ostream{&sink_buffer};
+
+/// Encodes a stream of identical messages in wire format, including the message length header
+auto encode_stream() -> std::vector<unsigned char> {
+    const auto fields = reader::wire::message_fields{
+        1593355910240, "e74bb50f-5a1e-4742-8827-20bc80a17297", 343428, 808};
+    const auto frame_size = reader::wire_size::message_length + reader::wire::payload_size(fields);
+
+    auto stream = std::vector<unsigned char>(messages_per_iteration * frame_size);
+    for (auto frame = stream.data(); frame != stream.data() + stream.size();) {
+        frame = reader::wire::encode_frame(fields, frame);
+    }
+    return stream;
+}
+
+const auto stream = encode_stream();
+
+/// @brief Fills a socket with `stream` and closes its remote end
+auto make_socket(asio::io_context& ioc) -> test::socket {
+    auto socket = test::socket{ioc, {"bench_address", 12345}};
+
+    auto& input = socket.buffer();
+    input.commit(asio::buffer_copy(input.prepare(stream.size()), asio::buffer(stream)));
+    socket.close_remote();
+
+    return socket;
+}
+
+/// Receives `messages_per_iteration` messages over a single connection until it is closed
+auto BM_Connection(benchmark::State& state,
+                   logger::receive_mode mode,
+                   reader::json_format format,
+                   bool raw) -> void {
+    auto options = logger::connection_options{mode, format};
+    options.raw = raw;
+
+    auto ioc = asio::io_context{};
+    auto connection_allocations = std::size_t{};
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto socket = make_socket(ioc);
+        state.ResumeTiming();
+
+        const auto before = allocations.load(std::memory_order_relaxed);
+        logger::make_connection(std::move(socket), logger::Output{sink, sink}, options);
+        ioc.run();
+        ioc.restart();
+        connection_allocations += allocations.load(std::memory_order_relaxed) - before;
+    }
+
+    state.counters["allocs_per_connection"] = benchmark::Counter(
+        static_cast<double>(connection_allocations), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * messages_per_iteration);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(stream.size()));
+}
+BENCHMARK_CAPTURE(BM_Connection,
+                  message_pretty,
+                  logger::receive_mode::message,
+                  reader::json_format::pretty,
+                  false);
+BENCHMARK_CAPTURE(
+    BM_Connection, bulk_pretty, logger::receive_mode::bulk, reader::json_format::pretty, false);
+BENCHMARK_CAPTURE(
+    BM_Connection, bulk_compact, logger::receive_mode::bulk, reader::json_format::compact, false);
+BENCHMARK_CAPTURE(
+    BM_Connection, bulk_raw, logger::receive_mode::bulk, reader::json_format::pretty, true);
+
+/// Receives messages as in the logger, with records handed to a Writer thread
+auto BM_ConnectionWithWriter(benchmark::State& state) -> void {
+    auto writer = logger::Writer{sink};
+    auto ioc = asio::io_context{};
+    const auto options = logger::connection_options{logger::receive_mode::bulk};
+    auto connection_allocations = std::size_t{};
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto socket = make_socket(ioc);
+        state.ResumeTiming();
+
+        const auto before = allocations.load(std::memory_order_relaxed);
+        logger::make_connection(
+            std::move(socket), logger::Output{ioc.get_executor(), writer, sink}, options);
+        ioc.run();
+        ioc.restart();
+        connection_allocations += allocations.load(std::memory_order_relaxed) - before;
+    }
+
+    state.counters["allocs_per_connection"] = benchmark::Counter(
+        static_cast<double>(connection_allocations), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * messages_per_iteration);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(stream.size()));
+}
+BENCHMARK(BM_ConnectionWithWriter);
+
+} // namespace
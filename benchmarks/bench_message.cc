@@ -0,0 +1,208 @@
+#include "compat/asio.h"
+#include "filter.h"
+#include "message.h"
+#include "message_batch.h"
+#include "serializer.h"
+#include "test/encode.h"
+#include "wire.h"
+
+#include "benchmark/benchmark.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// A message with all fields and a UUID name, as sent by the sensor simulator
+const auto payload =
+    test::encode({1593355910240, "e74bb50f-5a1e-4742-8827-20bc80a17297", 343428, 808});
+
+auto BM_DecodeMessagePayloadLength(benchmark::State& state) -> void {
+    constexpr auto header = std::array<unsigned char, reader::wire_size::message_length>{
+        0x00, 0x00, 0x00, 0x38};
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(reader::decode_message_payload_length(asio::buffer(header)));
+    }
+}
+BENCHMARK(BM_DecodeMessagePayloadLength);
+
+auto BM_MessageConstruction(benchmark::State& state) -> void {
+    for (auto _ : state) {
+        auto message = reader::Message{asio::buffer(payload)};
+        benchmark::DoNotOptimize(message);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(payload.size()));
+}
+BENCHMARK(BM_MessageConstruction);
+
+auto BM_MessageViewConstruction(benchmark::State& state) -> void {
+    for (auto _ : state) {
+        auto message = reader::MessageView{asio::buffer(payload)};
+        benchmark::DoNotOptimize(message);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(payload.size()));
+}
+BENCHMARK(BM_MessageViewConstruction);
+
+auto BM_TryDecodeView(benchmark::State& state) -> void {
+    for (auto _ : state) {
+        auto message = reader::try_decode_view(asio::buffer(payload));
+        benchmark::DoNotOptimize(message);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(payload.size()));
+}
+BENCHMARK(BM_TryDecodeView);
+
+/// A message with a trailing byte after the humidity field
+const auto malformed_payload = [] {
+    auto data = payload;
+    data.push_back(0);
+    return data;
+}();
+
+auto BM_MessageViewConstructionMalformed(benchmark::State& state) -> void {
+    for (auto _ : state) {
+        try {
+            auto message = reader::MessageView{asio::buffer(malformed_payload)};
+            benchmark::DoNotOptimize(message);
+        } catch (const reader::bad_message_data& ex) {
+            benchmark::DoNotOptimize(ex);
+        }
+    }
+}
+BENCHMARK(BM_MessageViewConstructionMalformed);
+
+auto BM_TryDecodeViewMalformed(benchmark::State& state) -> void {
+    for (auto _ : state) {
+        auto message = reader::try_decode_view(asio::buffer(malformed_payload));
+        benchmark::DoNotOptimize(message);
+    }
+}
+BENCHMARK(BM_TryDecodeViewMalformed);
+
+auto BM_FilterMatches(benchmark::State& state, const char* expression) -> void {
+    const auto filter = reader::Filter::compile(expression);
+    if (!filter) {
+        state.SkipWithError(filter.error().c_str());
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter->matches(asio::buffer(payload)));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(payload.size()));
+}
+BENCHMARK_CAPTURE(BM_FilterMatches, name_prefix, "name ^= e74bb50f");
+BENCHMARK_CAPTURE(BM_FilterMatches,
+                  combined,
+                  "name ^= e74bb50f and (temperature > 30 or not has humidity)");
+
+auto BM_ToJson(benchmark::State& state) -> void {
+    const auto message = reader::Message{asio::buffer(payload)};
+
+    for (auto _ : state) {
+        auto j = message.as_json();
+        benchmark::DoNotOptimize(j);
+    }
+}
+BENCHMARK(BM_ToJson);
+
+auto BM_ToJsonDump(benchmark::State& state) -> void {
+    const auto message = reader::Message{asio::buffer(payload)};
+
+    for (auto _ : state) {
+        auto record = message.as_json().dump(4);
+        benchmark::DoNotOptimize(record);
+    }
+}
+BENCHMARK(BM_ToJsonDump);
+
+auto BM_WriteJson(benchmark::State& state, reader::json_format format) -> void {
+    const auto message = reader::MessageView{asio::buffer(payload)};
+    auto record = std::string{};
+
+    for (auto _ : state) {
+        record.clear();
+        reader::write_json(record, message, format);
+        benchmark::DoNotOptimize(record.data());
+    }
+}
+BENCHMARK_CAPTURE(BM_WriteJson, pretty, reader::json_format::pretty);
+BENCHMARK_CAPTURE(BM_WriteJson, compact, reader::json_format::compact);
+
+/// Frames of messages with all fields, as received by a bulk read
+const auto frames = []() {
+    constexpr auto count = 1000;
+    const auto fields =
+        reader::wire::message_fields{1593355910240, "e74bb50f-5a1e-4742-8827-20bc80a17297",
+                                     343428, 808};
+    const auto frame_size = reader::wire_size::message_length + reader::wire::payload_size(fields);
+
+    auto data = std::vector<unsigned char>(count * frame_size);
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        reader::wire::encode_frame(fields, data.data() + i * frame_size);
+    }
+    return data;
+}();
+
+/// Decodes each frame with a MessageView and reads its fields, as a per-message sink would
+auto BM_DecodeFramesMessageView(benchmark::State& state) -> void {
+    auto messages = std::int64_t{0};
+    for (auto _ : state) {
+        auto data = asio::buffer(frames);
+        while (data.size() > 0) {
+            const auto payload_length = reader::decode_message_payload_length(
+                asio::buffer(data, reader::wire_size::message_length));
+            const auto message = reader::try_decode_view(
+                asio::buffer(data + reader::wire_size::message_length, payload_length));
+            benchmark::DoNotOptimize(message->timestamp());
+            benchmark::DoNotOptimize(message->temperature());
+            benchmark::DoNotOptimize(message->humidity());
+            data += reader::wire_size::message_length + payload_length;
+            ++messages;
+        }
+    }
+    state.SetItemsProcessed(messages);
+}
+BENCHMARK(BM_DecodeFramesMessageView);
+
+auto BM_DecodeFramesMessageBatch(benchmark::State& state) -> void {
+    auto batch = reader::MessageBatch{};
+    auto messages = std::int64_t{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(batch.decode(asio::buffer(frames)));
+        benchmark::DoNotOptimize(batch.temperatures().data());
+        messages += static_cast<std::int64_t>(batch.size());
+    }
+    state.SetItemsProcessed(messages);
+}
+BENCHMARK(BM_DecodeFramesMessageBatch);
+
+auto BM_ConvertTemperatures(benchmark::State& state, reader::simd_isa isa) -> void {
+    if (!reader::supported(isa)) {
+        state.SkipWithError("instruction set not supported");
+        return;
+    }
+
+    constexpr auto count = std::size_t{4096};
+    auto packed = std::vector<unsigned char>(3 * count);
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        reader::wire::message_schema::temperature::write(
+            static_cast<std::uint32_t>(27315 + i), &packed[3 * i]);
+    }
+    auto out = std::vector<float>(count);
+
+    for (auto _ : state) {
+        reader::convert_temperatures(packed.data(), count, out.data(), isa);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(count));
+}
+BENCHMARK_CAPTURE(BM_ConvertTemperatures, scalar, reader::simd_isa::scalar);
+BENCHMARK_CAPTURE(BM_ConvertTemperatures, sse4, reader::simd_isa::sse4);
+BENCHMARK_CAPTURE(BM_ConvertTemperatures, avx2, reader::simd_isa::avx2);
+
+} // namespace
@@ -0,0 +1,55 @@
+#include "timestamp.h"
+
+#include "benchmark/benchmark.h"
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::system_clock;
+
+const auto start = system_clock::time_point{milliseconds{1593355910240}};
+
+/// Timestamps advance by one millisecond, so the cached second is almost always reused
+auto BM_FormatTimestampSameSecond(benchmark::State& state) -> void {
+    char out[reader::max_timestamp_size];
+    auto timestamp = start;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(reader::format_timestamp(timestamp, out));
+        timestamp += milliseconds{1};
+    }
+}
+BENCHMARK(BM_FormatTimestampSameSecond);
+
+/// Timestamps advance by one second, so every call converts to local time
+auto BM_FormatTimestampNewSecond(benchmark::State& state) -> void {
+    char out[reader::max_timestamp_size];
+    auto timestamp = start;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(reader::format_timestamp(timestamp, out));
+        timestamp += std::chrono::seconds{1};
+    }
+}
+BENCHMARK(BM_FormatTimestampNewSecond);
+
+/// Baseline formatting the same timestamp with `std::put_time`
+auto BM_PutTime(benchmark::State& state) -> void {
+    const auto t = system_clock::to_time_t(start);
+
+    for (auto _ : state) {
+        auto local = std::tm{};
+        ::localtime_r(&t, &local);
+
+        auto ss = std::stringstream{};
+        ss << std::put_time(&local, "%FT%T") << ".240" << std::put_time(&local, "%z");
+        benchmark::DoNotOptimize(ss);
+    }
+}
+BENCHMARK(BM_PutTime);
+
+} // namespace
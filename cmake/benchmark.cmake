@@ -0,0 +1,39 @@
+set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+add_subdirectory("${CMAKE_SOURCE_DIR}/external/benchmark" "external/benchmark")
+
+add_custom_target(build-benchmarks ALL)
+
+# Runs all benchmarks and writes the results of each to `benchmarks/<name>.json` in the build
+# directory
+add_custom_target(run-benchmarks)
+
+macro(package_add_benchmark benchmarkname)
+    add_executable(${benchmarkname} ${ARGN})
+
+    set_target_properties(${benchmarkname}
+        PROPERTIES FOLDER benchmarks)
+
+    target_include_directories(${benchmarkname}
+        PUBLIC ${PROJECT_SOURCE_DIR}/include)
+    target_include_directories(${benchmarkname}
+        SYSTEM PUBLIC ${RECORDER_EXTERNAL_INCLUDE_DIR})
+
+    target_compile_options(${benchmarkname}
+        PRIVATE ${DEFAULT_CXX_OPTIONS})
+
+    target_link_libraries(${benchmarkname}
+        benchmark::benchmark
+        benchmark::benchmark_main
+        Threads::Threads)
+
+    add_custom_target(run-${benchmarkname}
+        COMMAND ${benchmarkname}
+            --benchmark_out=${CMAKE_CURRENT_BINARY_DIR}/${benchmarkname}.json
+            --benchmark_out_format=json
+        DEPENDS ${benchmarkname})
+
+    add_dependencies(build-benchmarks ${benchmarkname})
+    add_dependencies(run-benchmarks run-${benchmarkname})
+endmacro()
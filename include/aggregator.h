@@ -0,0 +1,198 @@
+#pragma once
+
+#include "serializer.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace logger {
+
+/// Longest duration accepted by `parse_duration`, about 73 million years. Timestamps and
+/// durations within it can be added without overflow.
+constexpr auto max_duration = std::chrono::milliseconds{std::int64_t{1} << 61};
+
+/// Minimum, maximum and sum of the values of a field within a window
+struct field_rollup {
+    std::uint32_t count = 0;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+    double sum = 0;
+
+    auto add(float value) noexcept -> void {
+        ++count;
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+        sum += static_cast<double>(value);
+    }
+};
+
+/// Summary of the messages of a sensor within a window
+struct window_rollup {
+    /// Start of the window, in multiples of the window width since the epoch
+    std::int64_t index = 0;
+
+    /// Number of messages in the window
+    std::uint32_t count = 0;
+
+    field_rollup temperature;
+    field_rollup humidity;
+};
+
+/// Configures the windows of an Aggregator
+struct aggregator_options {
+    /// Widths of the windows each message is added to
+    std::vector<std::chrono::milliseconds> windows = {std::chrono::seconds{1},
+                                                      std::chrono::minutes{1}};
+
+    /// How far a message may lag behind the latest timestamp of its sensor and still be added
+    std::chrono::milliseconds lateness = std::chrono::seconds{1};
+
+    /// Layout of the JSON written for each rollup
+    reader::json_format format = reader::json_format::pretty;
+};
+
+/// Aggregates sensor messages into rollups over fixed windows, per sensor name
+///
+/// Each message is added to one window of each width, aligned to the epoch. A sensor's watermark
+/// trails the latest timestamp received from it by the allowed lateness. A window is closed and
+/// its rollup written once the watermark passes its end, and messages older than the watermark
+/// are dropped as late. Only windows between the watermark and the latest timestamp are kept
+/// open, so adding a message takes constant time for a given lateness.
+///
+/// A rollup is a JSON object with the sensor `name`, the `window` width, its `start`, the
+/// message `count`, and the `count`, `min`, `max` and `mean` of `temperature` and `humidity` if
+/// any message in the window has the field. Windows without messages are not written.
+///
+/// Sensors are spread over shards with their own lock, so that connections adding messages on
+/// different threads rarely contend. A sensor which stays idle after its windows are expired is
+/// forgotten, so that the state of sensors which stopped sending does not accumulate.
+class Aggregator {
+  public:
+    using clock_t = std::chrono::system_clock;
+    using time_point_t = std::chrono::time_point<clock_t>;
+
+    /// Receives each rollup, without a trailing newline
+    using sink_type = std::function<void(std::string_view rollup)>;
+
+    static constexpr std::size_t shard_count = 16;
+
+    /// @brief Creates an Aggregator without any open windows
+    /// @param options Configures the windows
+    /// @param sink Invoked with each rollup, from the thread closing the window
+    /// @note Window widths must be positive, and window widths and the lateness must be at most
+    ///       `max_duration`
+    Aggregator(aggregator_options options, sink_type sink);
+
+    Aggregator(const Aggregator&) = delete;
+    Aggregator& operator=(const Aggregator&) = delete;
+
+    /// @brief Adds a decoded message, such as a `reader::Message` or `reader::MessageView`
+    template <class DecodedMessage>
+    auto add(const DecodedMessage& message) -> void {
+        add(message.name(), message.timestamp(), message.temperature(), message.humidity());
+    }
+
+    /// @brief Adds the fields of a message
+    ///
+    /// As the timestamp is set by the sensor, a message with a timestamp further than
+    /// `max_duration` from the epoch is dropped and counted as late.
+    auto add(std::string_view name,
+             time_point_t timestamp,
+             std::optional<float> temperature,
+             std::optional<float> humidity) -> void;
+
+    /// @brief Writes the open windows of sensors which received no messages since the previous
+    ///        call
+    ///
+    /// Windows of a sensor are otherwise only closed by a later message of the same sensor.
+    /// The watermark of an idle sensor is advanced to the end of its last window, so this should
+    /// be called less often than the largest window width plus the allowed lateness.
+    ///
+    /// Sensors which are still idle at the next call are forgotten. A later message of a
+    /// forgotten sensor opens new windows instead of being dropped as late.
+    auto expire() -> void;
+
+    /// @brief Writes all open windows
+    auto flush() -> void;
+
+    /// @brief Number of messages dropped for being older than the watermark of their sensor, or
+    ///        for a timestamp out of range
+    auto late() const noexcept -> std::uint64_t { return late_.load(std::memory_order_relaxed); }
+
+    /// @brief Number of rollups written
+    auto written() const noexcept -> std::uint64_t {
+        return written_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Number of sensors with state, including idle sensors not yet forgotten
+    auto sensors() const -> std::size_t;
+
+  private:
+    struct sensor {
+        /// Messages older than this timestamp, in milliseconds since the epoch, are late
+        std::int64_t watermark = std::numeric_limits<std::int64_t>::min();
+
+        /// Set when a message is added, and cleared by `expire`
+        bool active = false;
+
+        /// Open windows of each width, contiguous and ordered by start
+        std::vector<std::deque<window_rollup>> windows;
+
+        /// Storage of the sensor name in its shard
+        std::list<std::string>::iterator name;
+    };
+
+    struct shard {
+        mutable std::mutex mutex;
+
+        /// Storage of the sensor names, which is not moved when names are added or removed
+        std::list<std::string> names;
+
+        /// State of each sensor, keyed by views of `names`
+        std::unordered_map<std::string_view, sensor> sensors;
+    };
+
+    /// @brief Writes and removes the windows of a sensor which end at or before `watermark`
+    /// @note Must be called with the lock of the sensor's shard held
+    auto close(std::string_view name, sensor& s, std::int64_t watermark) -> void;
+
+    /// @brief Writes the rollup of a window
+    auto emit(std::string_view name, std::size_t width, const window_rollup& window) -> void;
+
+    const aggregator_options options_;
+    const sink_type sink_;
+
+    /// Window widths in milliseconds, in the order of `options_.windows`
+    std::vector<std::int64_t> widths_;
+
+    /// Window widths formatted for rollups, in the order of `options_.windows`
+    std::vector<std::string> labels_;
+
+    std::array<shard, shard_count> shards_;
+
+    std::atomic<std::uint64_t> late_{0};
+    std::atomic<std::uint64_t> written_{0};
+};
+
+/// @brief Parses a duration such as `500ms`, `1s`, `5m` or `1h`
+/// @return The duration, or std::nullopt if `s` is not a positive number followed by a unit, or
+///         is longer than `max_duration`
+auto parse_duration(std::string_view s) -> std::optional<std::chrono::milliseconds>;
+
+/// @brief Formats a duration in the largest unit accepted by `parse_duration` which divides it
+auto format_duration(std::chrono::milliseconds duration) -> std::string;
+
+} // namespace logger
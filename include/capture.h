@@ -0,0 +1,82 @@
+#pragma once
+
+#include "compat/asio.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace logger {
+
+/// Thrown on capture segment decode error
+struct bad_capture_data : public std::length_error {
+    bad_capture_data(const char* what_arg) : length_error(what_arg) {}
+};
+
+/// Marks the start of every capture segment
+constexpr auto segment_magic = std::string_view{"RSEG"};
+
+/// Byte size of fields in a capture segment header
+namespace capture_size {
+constexpr uint32_t magic = 4;
+constexpr uint32_t receive_time = 8;
+constexpr uint32_t payload_length = 4;
+constexpr uint32_t endpoint_length = 1;
+
+/// Size of the header fields preceding the endpoint
+constexpr uint32_t fixed_header = magic + receive_time + payload_length + endpoint_length;
+
+/// Largest possible segment header
+constexpr uint32_t max_header = fixed_header + std::numeric_limits<uint8_t>::max();
+} // namespace capture_size
+
+/// Describes the messages in a capture segment
+///
+/// A capture is a sequence of segments, each consisting of a header followed by a payload of
+/// complete messages in wire format, including the message length header. The payload has the
+/// same format as a stream received from a sensor client, e.g. `tests/data/testdata.log`.
+///
+/// A segment header is encoded as:
+/// - magic: `segment_magic`
+/// - receive_time: milliseconds since the epoch, big-endian
+/// - payload_length: size of the payload, big-endian
+/// - endpoint_length: size of the endpoint field
+/// - endpoint: address and port of the sensor client, not null terminated
+struct segment_header {
+    using clock_t = std::chrono::system_clock;
+    using time_point_t = std::chrono::time_point<clock_t>;
+
+    /// Address and port of the sensor client which sent the messages
+    std::string_view endpoint;
+
+    /// Time at which the messages were received
+    time_point_t receive_time;
+
+    /// Size of the segment payload
+    uint32_t payload_length;
+};
+
+/// @brief Appends an encoded segment header to a buffer
+/// @param out A buffer to append to
+/// @param header The header to encode
+/// @note An endpoint longer than 255 characters is truncated
+auto encode_segment_header(std::string& out, const segment_header& header) -> void;
+
+/// @brief Determines the size of a segment header
+/// @param header_data A const buffer which contains the fixed size fields of a segment header
+/// @return Size of the segment header, including the endpoint
+/// @throw bad_capture_data if `header_data` size does not match `capture_size::fixed_header`
+/// @throw bad_capture_data if `header_data` does not start with `segment_magic`
+auto decode_segment_header_size(asio::const_buffer header_data) -> uint32_t;
+
+/// @brief Decodes a segment header
+/// @param header_data A const buffer which contains a complete segment header
+/// @return The decoded header, with an endpoint referring to `header_data`
+/// @throw bad_capture_data if `header_data` does not start with `segment_magic`
+/// @throw bad_capture_data if `header_data` size does not match the encoded header size
+auto decode_segment_header(asio::const_buffer header_data) -> segment_header;
+
+} // namespace logger
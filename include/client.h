@@ -0,0 +1,155 @@
+#pragma once
+
+#include "compat/asio.h"
+#include "spill_ring.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+namespace reader {
+
+/// Sends sensor data stream to a log server
+///
+/// Input is read into a ring of buffers while previously read data is written to the socket, so
+/// reads from the input stream overlap writes to the log server. Only complete messages are
+/// handed to the socket; a partial message at the end of a buffer is moved to the next buffer.
+/// All buffers ready to be sent are written with a single gather write.
+///
+/// If the connection to the log server is lost, the Client reconnects with exponential backoff.
+///
+/// Without a spill file, reading pauses while all buffers are waiting to be sent. With a spill
+/// file, buffers which cannot be sent because the log server is unreachable or not keeping up
+/// are appended to the spill file instead, so reading never pauses. The spill file is drained
+/// before any newer data is sent, preserving the order of messages.
+class Client {
+  public:
+    /// @brief Creates a Client and starts forwarding data
+    /// @param socket A socket connected to the log server
+    /// @param istream Input data stream
+    /// @param endpoints Endpoints of the log server, used to reconnect
+    /// @param spill A spill file, or nullptr to apply backpressure to the input instead
+    Client(asio::ip::tcp::socket socket,
+           asio::posix::stream_descriptor istream,
+           asio::ip::tcp::resolver::results_type endpoints,
+           std::unique_ptr<SpillRing> spill);
+
+    /// Number of buffers in the ring
+    static constexpr std::size_t ring_size = 4;
+
+    /// Size of each buffer
+    static constexpr std::size_t buffer_size = 64 * 1024;
+
+  private:
+    /// Maximum number of bytes written from the spill file at once
+    static constexpr std::size_t spill_write_size = ring_size * buffer_size;
+
+    /// Delay before the first reconnection attempt
+    static constexpr auto initial_backoff = std::chrono::milliseconds{100};
+
+    /// Maximum delay between reconnection attempts
+    static constexpr auto max_backoff = std::chrono::milliseconds{10000};
+
+    /// @brief Index of the buffer being filled by reads
+    auto current() const noexcept -> std::size_t { return (begin_ + sealed_) % ring_size; }
+
+    /// @brief Writes the spill file or all sealed buffers to the log server
+    ///
+    /// Does nothing if a write is in progress or if the log server is not connected.
+    auto async_write_data() -> void;
+
+    /// @brief Reads from the input stream into the current buffer, unless it is full
+    auto async_read_data() -> void;
+
+    /// @brief Seals the current buffer and hands sealed buffers to the socket or spill file
+    /// @param seal_current If set, the complete messages in the current buffer are sealed. If
+    ///        the input has ended, a partial message is also sealed.
+    auto forward(bool seal_current) -> void;
+
+    /// @brief Moves sealed buffers which are not being written to the spill file
+    ///
+    /// Buffers are only moved if the log server is not connected, if the spill file already
+    /// contains older data, or if the ring has no buffer to spare.
+    auto spill_pending() -> void;
+
+    /// @brief Handles a failed write by reconnecting to the log server
+    ///
+    /// Data which was being written is sent again once reconnected.
+    auto connection_lost(const std::error_code& ec) -> void;
+
+    /// @brief Reconnects to the log server after a delay
+    auto async_reconnect() -> void;
+
+    /// @brief Marks the complete messages in the current buffer as ready to be sent
+    /// @param all If set, a partial message is also sent
+    ///
+    /// A partial message is moved to the next buffer, if that buffer is not waiting to be sent.
+    auto seal(bool all) -> void;
+
+    /// Socket to remote log server
+    asio::ip::tcp::socket socket_;
+
+    /// Input data stream
+    asio::posix::stream_descriptor istream_;
+
+    /// Endpoints of the log server
+    const asio::ip::tcp::resolver::results_type endpoints_;
+
+    /// Timer delaying reconnection attempts
+    asio::steady_timer reconnect_timer_;
+
+    /// Delay before the next reconnection attempt
+    std::chrono::milliseconds backoff_ = initial_backoff;
+
+    /// Spill file for data which cannot be sent, if any
+    std::unique_ptr<SpillRing> spill_;
+
+    /// Size of each sealed buffer stored in the spill file, oldest first
+    std::deque<std::size_t> spill_chunks_;
+
+    /// Number of bytes being written from the spill file, or 0 if none
+    std::size_t spill_writing_ = 0;
+
+    /// Set while data is dropped because the spill file is full
+    bool dropping_ = false;
+
+    /// Set while the socket is connected to the log server
+    bool connected_ = true;
+
+    /// Ring of buffers for forwarding from the input data stream to the log server
+    std::array<std::vector<unsigned char>, ring_size> buffers_;
+
+    /// Number of bytes to send from each sealed buffer
+    std::array<std::size_t, ring_size> sizes_ = {};
+
+    /// Index of the oldest sealed buffer
+    std::size_t begin_ = 0;
+
+    /// Number of buffers waiting to be sent, starting at `begin_`
+    std::size_t sealed_ = 0;
+
+    /// Number of sealed buffers being written, or 0 if no write is in progress
+    std::size_t writing_ = 0;
+
+    /// Number of bytes read into the current buffer
+    std::size_t fill_ = 0;
+
+    /// Set while a read is in progress
+    bool reading_ = false;
+
+    /// Set once the input stream has ended
+    bool input_closed_ = false;
+};
+
+/// @brief Finds the complete messages at the start of a buffer
+/// @return The size of the complete messages
+///
+/// If a message length is invalid, message boundaries cannot be recovered and all data is
+/// considered complete, so that it is forwarded unchanged.
+auto complete_frames_size(const unsigned char* data, std::size_t size) noexcept -> std::size_t;
+
+} // namespace reader
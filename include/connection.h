@@ -1,18 +1,84 @@
 #pragma once
 
+#include "aggregator.h"
+#include "capture.h"
 #include "compat/asio.h"
+#include "filter.h"
+#include "handler_allocator.h"
 #include "message.h"
+#include "message_batch.h"
+#include "merger.h"
+#include "metrics.h"
+#include "name_table.h"
 #include "nonstd/expected.hpp"
+#include "output.h"
+#include "pool.h"
+#include "record_ring.h"
+#include "serializer.h"
 
-#include <exception>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
 
 namespace logger {
 
+/// Determines how a Connection reads messages from its socket
+enum class receive_mode {
+    /// Reads the header and payload of each message with separate reads
+    message,
+    /// Reads as much data as is available and decodes every complete message received
+    bulk,
+};
+
+/// Configures how a Connection reads and writes messages
+struct connection_options {
+    /// Determines how messages are read from the socket
+    receive_mode mode = receive_mode::message;
+
+    /// Layout of the JSON written for each message
+    reader::json_format format = reader::json_format::pretty;
+
+    /// Writes received messages verbatim in capture segments instead of decoding them. Messages
+    /// are always read in bulk when set.
+    /// @see encode_segment_header
+    bool raw = false;
+
+    /// If set, messages which do not match the filter are dropped before they are decoded
+    /// @note Must be guaranteed to exist for the lifetime of the connections
+    const reader::Filter* filter = nullptr;
+
+    /// Collects telemetry for each connection if set
+    /// @note Must be guaranteed to exist for the lifetime of the connections
+    Metrics* metrics = nullptr;
+
+    /// If set, the first message with a name writes a record defining an ID for the name, and
+    /// messages refer to the name by that ID. Names are written in full once the table is full.
+    /// @see reader::write_name_definition
+    /// @note Must be guaranteed to exist for the lifetime of the connections
+    NameTable* names = nullptr;
+
+    /// If set, decoded messages are also added to this aggregator
+    /// @note Must be guaranteed to exist for the lifetime of the connections
+    Aggregator* aggregator = nullptr;
+
+    /// If set, records are written through this merger in sensor timestamp order, together with
+    /// the records of other connections
+    /// @note Must be guaranteed to exist for the lifetime of the connections
+    Merger* merger = nullptr;
+
+    /// If set, records are also published to this ring once they are written
+    /// @note Must be guaranteed to exist for the lifetime of the connections
+    RecordRing* subscribers = nullptr;
+};
+
 /// An active connection to a sensor client streaming data
 /// @tparam AsyncReadSocketStream A type that extends asio::AsyncReadStream
 ///
@@ -22,75 +88,391 @@ namespace logger {
 /// - AsyncReadSocketStream::remote_endpoint().address().to_string()
 /// - AsyncReadSocketStream::remote_endpoint().port()
 ///
+/// All handlers of a Connection run on the executor of its socket. When connections are served
+/// by multiple threads, the socket should use a strand executor so that the handlers of a single
+/// Connection never run concurrently.
+///
 /// @see https://think-async.com/Asio/asio-1.16.1/doc/asio/reference/AsyncReadStream.html
 template <class AsyncReadSocketStream>
 class Connection : public std::enable_shared_from_this<Connection<AsyncReadSocketStream>> {
   public:
-    ~Connection() { err_ << status_prefix_ << "Terminating connection\n"; }
+    ~Connection() { status("Terminating connection\n"); }
 
   protected:
     /// @brief Creates a Connection from a socket
     /// @param socket A socket connected to a sensor client
-    /// @param out An ostream to write to on success
-    /// @param err An ostream to write to on failure
+    /// @param output Destination for decoded messages and status messages
+    /// @param options Configures how messages are read and written
     /// @note The Connection manages its own lifetime
-    /// @note `out` and `err` must be guaranteed to exist for the lifetime of the Connection
+    /// @note The streams used by `output` must be guaranteed to exist for the lifetime of the
+    ///       Connection
     /// @note Objects of this class must be wrapped in the shared_ptr in order to extend the
     ///       lifetime when posting async tasks. This constructor is made 'protected' so that this
     ///       class can only be created with the free function `make_connection`.
-    Connection(AsyncReadSocketStream socket, std::ostream& out, std::ostream& err)
+    Connection(AsyncReadSocketStream socket, Output output, connection_options options)
         : socket_{std::move(socket)},
-          status_prefix_{[&]() {
-              auto ss = std::stringstream{};
-              ss << "[" << socket_.remote_endpoint().address().to_string() << ":"
-                 << socket_.remote_endpoint().port() << "] ";
-              return ss.str();
-          }()},
-          out_{out},
-          err_{err} {
-        err_ << status_prefix_ << "Established connection\n";
+          status_prefix_{format_status_prefix(socket_, status_prefix_storage_)},
+          endpoint_{status_prefix_.substr(1, status_prefix_.size() - 3)},
+          output_{std::move(output)},
+          options_{options},
+          counters_{options.metrics ? options.metrics->open(std::string{endpoint_}) : nullptr},
+          merge_source_{options.merger ? std::optional{options.merger->open()} : std::nullopt} {
+        status("Established connection\n");
     }
 
     /// @brief Starts reading sensor data
-    auto start() -> void { display_message(); }
+    auto start() -> void {
+        if (options_.mode == receive_mode::bulk || options_.raw) {
+            display_messages();
+        } else {
+            display_message();
+        }
+    }
 
   private:
     static constexpr auto header_length = reader::wire_size::message_length;
-    using expected_type = nonstd::expected<reader::Message, std::exception_ptr>;
+    static constexpr std::size_t bulk_read_size = 64 * 1024;
+    using expected_type = nonstd::expected<reader::MessageView, reader::decode_error>;
 
-    /// @brief Reads a message header and writes it to `out_`
+    /// @brief Reads a message header and writes it to `output_`
     auto display_message() -> void {
-        async_receive_message([this, self = this->shared_from_this()](
-                                  const std::error_code& ec, const expected_type& message) {
-            if (ec) {
-                err_ << status_prefix_ << ec << std::endl;
-                return;
-            }
+        async_receive_message(make_custom_alloc_handler(
+            handler_memory_,
+            [this, self = this->shared_from_this()](const std::error_code& ec,
+                                                    const expected_type& message) {
+                if (ec) {
+                    display_error(ec);
+                    return;
+                }
 
-            if (message) {
-                try {
-                    out_ << message->as_json().dump(4) << std::endl;
-                } catch (const nlohmann::json::type_error& ex) {
-                    static constexpr int invalid_utf8 = 316;
-                    static constexpr auto prefix = "[json.exception.type_error.316] ";
-                    static constexpr auto prefix_view = std::string_view{prefix};
+                display(message, streambuf_.data());
+                display_message();
+            }));
+    }
 
-                    if (ex.id != invalid_utf8) {
-                        throw;
+    /// @brief Reads all available data and writes every complete message to `output_`
+    ///
+    /// A partial message at the end of the receive buffer is kept until the next read completes
+    /// it.
+    auto display_messages() -> void {
+        socket_.async_read_some(
+            streambuf_.prepare(bulk_read_size),
+            make_custom_alloc_handler(
+                handler_memory_,
+                [this, self = this->shared_from_this()](const std::error_code& ec,
+                                                        std::size_t bytes_transferred) {
+                    if (ec) {
+                        display_error(ec);
+                        return;
                     }
-                    err_ << status_prefix_ << "Unable to decode string: "
-                         << std::string_view{ex.what()}.substr(prefix_view.size()) << "\n";
-                }
-            } else {
-                try {
-                    std::rethrow_exception(message.error());
-                } catch (const reader::bad_message_data& ex) {
-                    err_ << status_prefix_ << "Unable to decode message: " << ex.what() << "\n";
-                }
+                    streambuf_.commit(bytes_transferred);
+
+                    const auto frames_size = complete_frames_size(streambuf_.data());
+                    if (!frames_size) {
+                        // Message boundaries are lost and the stream cannot be resynchronized
+                        status("Unable to decode message: message length is invalid.\n");
+                        return;
+                    }
+
+                    const auto frames = asio::buffer(streambuf_.data(), *frames_size);
+                    if (options_.raw) {
+                        capture(frames);
+                    } else {
+                        display_frames(frames);
+                    }
+                    streambuf_.consume(*frames_size);
+
+                    if (counters_) {
+                        counters_->buffered.store(streambuf_.size(), std::memory_order_relaxed);
+                    }
+
+                    display_messages();
+                }));
+    }
+
+    /// @brief Decodes complete messages kept by the filter and writes them to `output_`
+    /// @param frames A buffer containing complete messages, including the message length header
+    auto display_frames(asio::const_buffer frames) -> void {
+        if (!options_.filter) {
+            decode_frames(frames);
+            return;
+        }
+
+        // Runs of kept messages are decoded together
+        while (frames.size() > 0) {
+            const auto kept = filter_frames(frames, true);
+            decode_frames(asio::buffer(frames, kept.size));
+            frames += kept.size;
+
+            const auto dropped = filter_frames(frames, false);
+            if (counters_ && dropped.count > 0) {
+                increment(counters_->messages, dropped.count);
+                increment(counters_->bytes, dropped.size);
+                increment(counters_->filtered, dropped.count);
             }
+            frames += dropped.size;
+        }
+    }
 
-            display_message();
-        });
+    /// Complete messages at the start of a buffer
+    struct frame_run {
+        /// Size of the messages, including the message length headers
+        std::size_t size = 0;
+
+        /// Number of messages
+        std::size_t count = 0;
+    };
+
+    /// @brief Finds the messages at the start of a buffer which the filter keeps, or drops
+    /// @param frames A buffer containing complete messages, including the message length header
+    /// @param kept Whether to find messages kept or dropped by the filter
+    auto filter_frames(asio::const_buffer frames, bool kept) const noexcept -> frame_run {
+        auto run = frame_run{};
+        while (frames.size() > 0) {
+            const auto payload_length =
+                reader::decode_message_payload_length(asio::buffer(frames, header_length));
+            if (options_.filter->matches(asio::buffer(frames + header_length, payload_length)) !=
+                kept) {
+                break;
+            }
+
+            run.size += header_length + payload_length;
+            ++run.count;
+            frames += header_length + payload_length;
+        }
+        return run;
+    }
+
+    /// @brief Decodes complete messages and writes them to `output_`
+    /// @param frames A buffer containing complete messages, including the message length header
+    ///
+    /// Runs of valid messages are decoded together into `batch_`. A message which cannot be
+    /// decoded is decoded again on its own to describe why.
+    auto decode_frames(asio::const_buffer frames) -> void {
+        while (frames.size() > 0) {
+            const auto start = now();
+            const auto decoded = batch_.decode(frames);
+
+            if (counters_ && !batch_.empty()) {
+                const auto latency = (now() - start) / batch_.size();
+                counters_->latencies.decode_latency.record(latency, batch_.size());
+                increment(counters_->messages, batch_.size());
+                increment(counters_->bytes, decoded);
+            }
+
+            for (auto i = std::size_t{0}; i < batch_.size(); ++i) {
+                write(batch_[i]);
+            }
+            frames += decoded;
+
+            if (frames.size() > 0) {
+                const auto payload_length =
+                    reader::decode_message_payload_length(asio::buffer(frames, header_length));
+
+                const auto payload = asio::buffer(frames + header_length, payload_length);
+                display(decode(payload), payload);
+                frames += header_length + payload_length;
+            }
+        }
+    }
+
+    /// @brief Writes complete messages to `output_` without decoding them
+    /// @param frames A buffer containing complete messages, including the message length header
+    auto capture(asio::const_buffer frames) -> void {
+        if (frames.size() == 0) {
+            return;
+        }
+
+        record_.clear();
+        encode_segment_header(record_,
+                              {endpoint_, std::chrono::system_clock::now(),
+                               static_cast<uint32_t>(frames.size())});
+        record_.append(static_cast<const char*>(frames.data()), frames.size());
+        output_.capture(record_);
+
+        if (counters_) {
+            increment(counters_->bytes, frames.size());
+        }
+    }
+
+    /// @brief Finds the complete messages at the start of a buffer
+    /// @param data A buffer starting at a message length header
+    /// @return The size of the complete messages, or std::nullopt if a message length is invalid
+    static auto complete_frames_size(asio::const_buffer data) -> std::optional<std::size_t> {
+        auto size = std::size_t{0};
+
+        while (data.size() >= header_length) {
+            const auto payload_length =
+                reader::decode_message_payload_length(asio::buffer(data, header_length));
+
+            if (payload_length > reader::wire_size::max_payload) {
+                return std::nullopt;
+            }
+
+            if (data.size() - header_length < payload_length) {
+                break;
+            }
+
+            size += header_length + payload_length;
+            data += header_length + payload_length;
+        }
+
+        return size;
+    }
+
+    /// @brief Writes a decoded message to `output_`, or a status message if decoding failed
+    /// @param message The decoded message
+    /// @param payload The message payload, used to describe why decoding failed
+    auto display(const expected_type& message, asio::const_buffer payload) -> void {
+        if (message) {
+            write(*message);
+        } else if (message.error() == reader::decode_error::invalid_name) {
+            if (counters_) {
+                increment(counters_->string_errors);
+            }
+            status("Unable to decode string: " + reader::describe(payload, message.error()) +
+                   "\n");
+        } else {
+            if (counters_) {
+                increment(counters_->decode_errors);
+            }
+            status("Unable to decode message: " + reader::describe(payload, message.error()) +
+                   "\n");
+        }
+    }
+
+    /// @brief Writes a decoded message to `output_`
+    /// @param message A `reader::MessageView` or a row of a `reader::MessageBatch`
+    template <class DecodedMessage>
+    auto write(const DecodedMessage& message) -> void {
+        const auto start = now();
+        const auto id = options_.names ? intern(message.name()) : std::nullopt;
+        record_.clear();
+        if (id) {
+            reader::write_json(record_, message, *id, options_.format);
+        } else {
+            reader::write_json(record_, message, options_.format);
+        }
+        const auto serialized = now();
+        emit({message.name(), message.timestamp()});
+
+        if (options_.aggregator) {
+            options_.aggregator->add(message);
+        }
+
+        if (counters_) {
+            auto& latencies = counters_->latencies;
+            latencies.serialize_latency.record(serialized - start);
+            latencies.write_latency.record(now() - serialized);
+            latencies.lag.record(std::chrono::system_clock::now() - message.timestamp());
+        }
+    }
+
+    /// @brief Writes `record_` to `output_` and publishes it to subscribers
+    /// @param info Sensor name and timestamp of the record
+    ///
+    /// When records are merged, the merger writes and publishes the record once it is released.
+    auto emit(const record_info& info) -> void {
+        if (merge_source_) {
+            merge_source_->add(record_, info);
+            return;
+        }
+
+        output_.write(record_, info);
+        if (options_.subscribers) {
+            options_.subscribers->publish(record_);
+        }
+    }
+
+    /// @brief Writes a status message prefixed with the client info to `output_`
+    auto status(std::string_view message) -> void {
+        auto line = std::string{};
+        line.reserve(status_prefix_.size() + message.size());
+        line.append(status_prefix_).append(message);
+        output_.status(std::move(line));
+    }
+
+    /// @brief Writes a socket error to `output_`
+    auto display_error(const std::error_code& ec) -> void {
+        auto ss = std::stringstream{};
+        ss << status_prefix_ << ec << "\n";
+        output_.status(ss.str());
+    }
+
+    /// @brief Formats the prefix of status messages for a client
+    /// @param socket A socket connected to a sensor client
+    /// @param storage Storage for the prefix
+    /// @return The prefix, referring to `storage` and truncated to fit
+    static auto format_status_prefix(const AsyncReadSocketStream& socket,
+                                     std::array<char, 64>& storage) -> std::string_view {
+        const auto& endpoint = socket.remote_endpoint();
+        const auto length = std::snprintf(storage.data(),
+                                          storage.size(),
+                                          "[%s:%u] ",
+                                          endpoint.address().to_string().c_str(),
+                                          static_cast<unsigned>(endpoint.port()));
+
+        return {storage.data(), std::min(static_cast<std::size_t>(length), storage.size() - 1)};
+    }
+
+    /// @brief Decodes a message payload
+    auto decode(asio::const_buffer payload) noexcept -> expected_type {
+        const auto start = now();
+        const auto message = reader::try_decode_view(payload);
+
+        if (counters_) {
+            counters_->latencies.decode_latency.record(now() - start);
+            increment(counters_->messages);
+            increment(counters_->bytes, header_length + payload.size());
+        }
+
+        return message;
+    }
+
+    /// @brief Evaluates the filter on a message payload, counting the message if it is dropped
+    /// @return Whether the message is kept
+    auto keep(asio::const_buffer payload) noexcept -> bool {
+        if (!options_.filter || options_.filter->matches(payload)) {
+            return true;
+        }
+
+        if (counters_) {
+            increment(counters_->messages);
+            increment(counters_->bytes, header_length + payload.size());
+            increment(counters_->filtered);
+        }
+        return false;
+    }
+
+    /// @brief Finds the ID of a name, writing a definition record if the name is new
+    /// @return The ID, or std::nullopt if the name table is full
+    ///
+    /// A sensor client usually sends a single name, so the last name is compared first to avoid
+    /// hashing it for every message.
+    auto intern(std::string_view name) -> std::optional<name_id> {
+        if (!last_name_ || last_name_->name != name) {
+            const auto define = [this](name_id id, std::string_view interned) {
+                record_.clear();
+                reader::write_name_definition(record_, id, interned, options_.format);
+                emit({interned, std::nullopt});
+            };
+            last_name_ = options_.names->intern(name, define);
+        }
+
+        return last_name_ ? std::optional<name_id>{last_name_->id} : std::nullopt;
+    }
+
+    /// @brief Reads the clock used to measure latencies, if metrics are collected
+    auto now() const noexcept -> std::chrono::steady_clock::time_point {
+        using clock = std::chrono::steady_clock;
+        return counters_ ? clock::now() : clock::time_point{};
+    }
+
+    /// @brief The result passed to the completion handler of a failed read
+    ///
+    /// The handler checks the error code first, so the decode error is never read.
+    static auto no_message() noexcept -> expected_type {
+        return nonstd::make_unexpected(reader::decode_error::too_small);
     }
 
 #include <asio/yield.hpp>
@@ -99,7 +481,10 @@ class Connection : public std::enable_shared_from_this<Connection<AsyncReadSocke
     /// @param token A token that determines the handler invoked when the asynchronous operation is
     /// completed
     ///
-    /// Reads a message header followed by a message payload.
+    /// Reads a message header followed by a message payload. Messages which do not match the
+    /// filter are dropped and the next message is read. Intermediate handlers run on the
+    /// executor of the socket. The message view passed to the completion handler refers to the
+    /// internal receive buffer and is only valid until the next call.
     template <class CompletionToken>
     auto async_receive_message(CompletionToken&& token) {
         return asio::async_compose<CompletionToken,
@@ -108,41 +493,41 @@ class Connection : public std::enable_shared_from_this<Connection<AsyncReadSocke
                                                     const std::error_code& error = {},
                                                     std::size_t bytes_transferred = 0) mutable {
                 reenter(coro) {
-                    assert(conn->streambuf_.size() == 0);
-                    yield asio::async_read(
-                        conn->socket_, conn->streambuf_.prepare(header_length), std::move(self));
-                    if (error) {
-                        return self.complete(error,
-                                             nonstd::make_unexpected<std::exception_ptr>({}));
-                    }
-                    conn->streambuf_.commit(header_length);
-
-                    yield {
-                        const auto payload_length =
-                            reader::decode_message_payload_length(conn->streambuf_.data());
-                        conn->streambuf_.consume(header_length);
-                        asio::async_read(conn->socket_,
-                                         conn->streambuf_.prepare(payload_length),
-                                         std::move(self));
-                    }
-                    if (error) {
-                        return self.complete(error,
-                                             nonstd::make_unexpected<std::exception_ptr>({}));
-                    }
-                    conn->streambuf_.commit(bytes_transferred);
+                    while (true) {
+                        // Release the previous message. It is kept until now as it is referenced
+                        // by the message view passed to the completion handler.
+                        conn->streambuf_.consume(conn->streambuf_.size());
+                        yield asio::async_read(conn->socket_,
+                                               conn->streambuf_.prepare(header_length),
+                                               std::move(self));
+                        if (error) {
+                            return self.complete(error, no_message());
+                        }
+                        conn->streambuf_.commit(header_length);
 
-                    auto message = [](auto buffer) noexcept -> expected_type {
-                        try {
-                            return reader::Message{buffer};
-                        } catch (...) {
-                            return nonstd::make_unexpected(std::current_exception());
+                        yield {
+                            const auto payload_length =
+                                reader::decode_message_payload_length(conn->streambuf_.data());
+                            conn->streambuf_.consume(header_length);
+                            asio::async_read(conn->socket_,
+                                             conn->streambuf_.prepare(payload_length),
+                                             std::move(self));
                         }
-                    }(conn->streambuf_.data());
-                    conn->streambuf_.consume(conn->streambuf_.size());
-                    self.complete(error, std::move(message));
+                        if (error) {
+                            return self.complete(error, no_message());
+                        }
+                        conn->streambuf_.commit(bytes_transferred);
+
+                        if (conn->keep(conn->streambuf_.data())) {
+                            break;
+                        }
+                    }
+
+                    self.complete(error, conn->decode(conn->streambuf_.data()));
                 }
             },
-            token);
+            token,
+            socket_);
     }
 
 #include <asio/unyield.hpp>
@@ -153,35 +538,76 @@ class Connection : public std::enable_shared_from_this<Connection<AsyncReadSocke
     /// Internal storage for receiving encoded messages
     asio::streambuf streambuf_;
 
+    /// Storage for `status_prefix_`, so that creating a Connection does not allocate strings
+    std::array<char, 64> status_prefix_storage_{};
+
     /// Prefix for status messages containing client info
-    const std::string status_prefix_;
+    const std::string_view status_prefix_;
+
+    /// Address and port of the remote sensor client, referring to `status_prefix_`
+    const std::string_view endpoint_;
+
+    /// Destination for sensor messages and status/error messages
+    Output output_;
+
+    /// Configures how messages are read and written
+    const connection_options options_;
+
+    /// Internal storage for serializing messages, reused to avoid allocation
+    std::string record_;
+
+    /// Messages decoded by the last bulk read, reused to avoid allocation
+    reader::MessageBatch batch_;
+
+    /// Telemetry counters of this connection, if metrics are collected
+    const std::shared_ptr<connection_counters> counters_;
 
-    /// Output stream to write sensor messages to
-    std::ostream& out_;
+    /// Source of the records of this connection, if records are merged
+    std::optional<Merger::source> merge_source_;
 
-    /// Output stream to write status/error messages to
-    std::ostream& err_;
+    /// The name of the last message, if names are interned and the name was assigned an ID
+    std::optional<interned_name> last_name_;
+
+    /// Memory reused by the handlers of successive reads
+    handler_memory handler_memory_;
 };
 
 /// @brief Constructs a connection from a socket
 /// @tparam AsyncReadSocketStream A type that extends asio::AsyncReadStream
 /// @param socket A socket connected to a sensor client
-/// @param out An ostream to write to on success
-/// @param err An ostream to write to on failure
+/// @param output Destination for decoded messages and status messages
+/// @param options Configures how messages are read and written
 /// @note The spawned Connection manages its own lifetime
-/// @note `out` and `err` must be guaranteed to exist for the lifetime of the Connection
+/// @note The streams used by `output` must be guaranteed to exist for the lifetime of the
+///       Connection
 /// @see Connection
 /// @see https://think-async.com/Asio/asio-1.16.1/doc/asio/reference/AsyncReadStream.html
 template <class AsyncReadSocketStream>
-auto make_connection(AsyncReadSocketStream socket, std::ostream& out, std::ostream& err) {
+auto make_connection(AsyncReadSocketStream socket, Output output, connection_options options = {}) {
     struct helper : Connection<AsyncReadSocketStream> {
-        helper(AsyncReadSocketStream socket, std::ostream& out, std::ostream& err)
-            : Connection<AsyncReadSocketStream>{std::move(socket), out, err} {}
+        helper(AsyncReadSocketStream socket, Output output, connection_options options)
+            : Connection<AsyncReadSocketStream>{std::move(socket), std::move(output), options} {}
 
         using Connection<AsyncReadSocketStream>::start;
     };
 
-    std::make_shared<helper>(std::move(socket), out, err)->start();
+    // Connections are allocated from a pool, together with their shared_ptr control block
+    std::allocate_shared<helper>(
+        pool_allocator<helper>{}, std::move(socket), std::move(output), options)
+        ->start();
+}
+
+/// @brief Constructs a connection from a socket
+/// @tparam AsyncReadSocketStream A type that extends asio::AsyncReadStream
+/// @param socket A socket connected to a sensor client
+/// @param out An ostream to write to on success
+/// @param err An ostream to write to on failure
+/// @note The spawned Connection manages its own lifetime
+/// @note `out` and `err` must be guaranteed to exist for the lifetime of the Connection
+/// @note `out` and `err` are written to directly, without synchronization
+template <class AsyncReadSocketStream>
+auto make_connection(AsyncReadSocketStream socket, std::ostream& out, std::ostream& err) {
+    make_connection(std::move(socket), Output{out, err});
 }
 
 } // namespace logger
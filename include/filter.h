@@ -0,0 +1,96 @@
+#pragma once
+
+#include "compat/asio.h"
+#include "nonstd/expected.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reader {
+
+/// A predicate on sensor data messages, evaluated on the payload before it is decoded
+///
+/// A filter is compiled from an expression of conditions on the fields of a message:
+/// - `name = <string>`: the name is exactly `string`
+/// - `name ^= <string>`: the name starts with `string`
+/// - `temperature <op> <°C>`, `humidity <op> <%>`: the message has the field and its value
+///   compares with the number, where `op` is one of `<`, `<=`, `>` or `>=`
+/// - `timestamp <op> <timestamp>`: the timestamp compares with an ISO 8601 date and time, such as
+///   `2020-06-28T16:51:50.240+0200`
+/// - `has temperature`, `has humidity`: the message has the field
+///
+/// Strings are a single word or enclosed in double quotes, with `\"` and `\\` as escapes.
+/// Conditions are combined with `not`, `and` and `or`, in decreasing order of precedence, and
+/// grouped with parentheses, e.g. `name ^= kitchen- and (temperature > 30 or not has humidity)`.
+///
+/// The expression is compiled to a postfix program. Bounds on temperature and humidity are
+/// converted to wire units, as the largest range of encoded values which decode to a matching
+/// value, so evaluating a condition only reads and compares the encoded field. Conditions are
+/// evaluated on a stack of bits, so a filter does not allocate once compiled.
+class Filter {
+  public:
+    /// @brief Compiles a filter expression
+    /// @return The filter, or a description of why the expression is invalid
+    static auto compile(std::string_view expression) -> nonstd::expected<Filter, std::string>;
+
+    /// @brief Evaluates the filter on a message payload
+    /// @param payload The payload, without the message length header
+    /// @return Whether the message is kept
+    /// @note Payloads which cannot be decoded are kept, so that the decoder reports them
+    auto matches(asio::const_buffer payload) const noexcept -> bool;
+
+    /// Largest number of nested conditions of an expression
+    static constexpr std::size_t max_depth = 64;
+
+  private:
+    enum class opcode : std::uint8_t {
+        /// Pushes whether the name equals the string
+        name_equals,
+        /// Pushes whether the name starts with the string
+        name_prefix,
+        /// Pushes whether the timestamp is in the range, with its sign bit flipped so that it
+        /// orders as the signed value it is decoded to
+        timestamp_in,
+        /// Pushes whether the message has a temperature in the range, in wire units
+        temperature_in,
+        /// Pushes whether the message has a humidity in the range, in wire units
+        humidity_in,
+        /// Pushes whether the message has a temperature
+        has_temperature,
+        /// Pushes whether the message has a humidity
+        has_humidity,
+        /// Negates the top of the stack
+        negate,
+        /// Replaces the two values on top of the stack with their conjunction
+        both,
+        /// Replaces the two values on top of the stack with their disjunction
+        either,
+    };
+
+    struct instruction {
+        opcode op;
+
+        /// Offset and size of the string in `strings_`
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+
+        /// Inclusive range of values, which is empty if `low > high`
+        std::uint64_t low = 0;
+        std::uint64_t high = 0;
+    };
+
+    /// Compiles an expression
+    class parser;
+
+    Filter() = default;
+
+    std::vector<instruction> program_;
+
+    /// Strings compared with the name, concatenated
+    std::string strings_;
+};
+
+} // namespace reader
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace logger {
+
+/// Memory reused for the handlers of successive asynchronous operations
+///
+/// Asio allocates memory for every asynchronous operation and releases it before the completion
+/// handler is invoked. When an object only has a single operation in flight at a time, the same
+/// memory can be handed to the next operation, so a chain of operations does not allocate.
+///
+/// If the memory is in use or is too small, allocation falls back to the heap.
+///
+/// @note Not thread-safe. Operations using the same handler_memory must not be in flight
+///       concurrently, which holds for a chain of operations on a strand.
+/// @see https://think-async.com/Asio/asio-1.16.1/src/examples/cpp11/allocation/server.cpp
+class handler_memory {
+  public:
+    handler_memory() = default;
+    handler_memory(const handler_memory&) = delete;
+    handler_memory& operator=(const handler_memory&) = delete;
+
+    auto allocate(std::size_t size) -> void* {
+        if (!in_use_ && size <= sizeof(storage_)) {
+            in_use_ = true;
+            return &storage_;
+        }
+
+        return ::operator new(size);
+    }
+
+    auto deallocate(void* pointer) noexcept -> void {
+        if (pointer == &storage_) {
+            in_use_ = false;
+        } else {
+            ::operator delete(pointer);
+        }
+    }
+
+  private:
+    /// Storage large enough for the operations of a Connection
+    std::aligned_storage_t<1024> storage_;
+
+    /// Set while the storage is allocated to an operation
+    bool in_use_ = false;
+};
+
+/// Allocator associated with a handler, allocating from a handler_memory
+/// @tparam T Type of the allocated objects
+template <class T>
+class handler_allocator {
+  public:
+    using value_type = T;
+
+    explicit handler_allocator(handler_memory& memory) noexcept : memory_{&memory} {}
+
+    template <class U>
+    handler_allocator(const handler_allocator<U>& other) noexcept : memory_{other.memory_} {}
+
+    auto allocate(std::size_t n) const -> T* {
+        return static_cast<T*>(memory_->allocate(sizeof(T) * n));
+    }
+
+    auto deallocate(T* p, std::size_t) const noexcept -> void { memory_->deallocate(p); }
+
+    auto operator==(const handler_allocator& other) const noexcept -> bool {
+        return memory_ == other.memory_;
+    }
+
+    auto operator!=(const handler_allocator& other) const noexcept -> bool {
+        return memory_ != other.memory_;
+    }
+
+  private:
+    template <class>
+    friend class handler_allocator;
+
+    handler_memory* memory_;
+};
+
+/// Wraps a handler so that operations completing with it allocate from a handler_memory
+/// @tparam Handler A completion handler
+template <class Handler>
+class custom_alloc_handler {
+  public:
+    using allocator_type = handler_allocator<Handler>;
+
+    custom_alloc_handler(handler_memory& memory, Handler handler)
+        : memory_{memory}, handler_{std::move(handler)} {}
+
+    auto get_allocator() const noexcept -> allocator_type { return allocator_type{memory_}; }
+
+    template <class... Args>
+    auto operator()(Args&&... args) -> void {
+        handler_(std::forward<Args>(args)...);
+    }
+
+  private:
+    handler_memory& memory_;
+    Handler handler_;
+};
+
+/// @brief Wraps a handler so that operations completing with it allocate from `memory`
+/// @param memory Memory reused by the operations
+/// @param handler A completion handler
+/// @note `memory` must outlive the operations
+template <class Handler>
+auto make_custom_alloc_handler(handler_memory& memory, Handler&& handler) {
+    return custom_alloc_handler<std::decay_t<Handler>>{memory, std::forward<Handler>(handler)};
+}
+
+} // namespace logger
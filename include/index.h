@@ -0,0 +1,170 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace logger {
+
+/// Thrown on index decode error
+struct bad_index_data : public std::length_error {
+    bad_index_data(const char* what_arg) : length_error(what_arg) {}
+};
+
+/// Marks the start of an index file
+constexpr auto index_magic = std::string_view{"RIDX"};
+
+/// Describes a record written to the logger output, used to index it
+struct record_info {
+    using clock_t = std::chrono::system_clock;
+    using time_point_t = std::chrono::time_point<clock_t>;
+
+    /// Sensor name of the record
+    std::string_view name;
+
+    /// Sensor timestamp of the record, if it has one
+    std::optional<time_point_t> timestamp;
+};
+
+/// A contiguous range of records in the logger output
+struct index_block {
+    /// Offset of the first record from the start of the output
+    std::uint64_t offset = 0;
+
+    /// Size of the block, which ends at the start of the next block
+    std::uint64_t size = 0;
+
+    /// Earliest and latest sensor timestamps of the records in the block, in milliseconds since
+    /// the epoch. `min_timestamp > max_timestamp` if no record has a timestamp.
+    std::int64_t min_timestamp = std::numeric_limits<std::int64_t>::max();
+    std::int64_t max_timestamp = std::numeric_limits<std::int64_t>::min();
+
+    /// Number of records in the block
+    std::uint32_t records = 0;
+
+    /// IDs of the sensor names in the block, in order of first appearance
+    std::vector<std::uint32_t> names;
+};
+
+/// Builds a sparse index of the records written to the logger output
+///
+/// Records are grouped into blocks of about `block_size` bytes, which always start at a record.
+/// For each block, the index stores its offset and size, the range of record timestamps, and the
+/// sensor names of its records. A query only needs to read the blocks which can contain matching
+/// records.
+///
+/// The index is encoded as a sequence of entries, so that it can be appended to while the
+/// output is written:
+/// - magic: `index_magic`, at the start of the index only
+/// - name entry: tag `N`, name ID (4 bytes), name size (1 byte), name. IDs are assigned in order,
+///   starting at 0. A name entry precedes the first block containing the name.
+/// - block entry: tag `B`, offset (8 bytes), size (8 bytes), minimum and maximum timestamp
+///   (8 bytes each), number of records (4 bytes), number of names (4 bytes), name IDs (4 bytes
+///   each)
+///
+/// Numbers are big-endian.
+///
+/// @note Not thread-safe
+class IndexBuilder {
+  public:
+    static constexpr std::size_t default_block_size = 256 * 1024;
+
+    /// @brief Creates an index of an empty output
+    /// @param block_size Size after which a new block is started
+    explicit IndexBuilder(std::size_t block_size = default_block_size);
+
+    /// @brief Adds a record to the index
+    /// @param offset Offset of the record from the start of the output
+    /// @param info Sensor name and timestamp of the record
+    /// @note Records must be added in the order they are written
+    auto add(std::uint64_t offset, const record_info& info) -> void;
+
+    /// @brief Ends the current block
+    /// @param end Size of the output
+    auto finish(std::uint64_t end) -> void;
+
+    /// @brief Moves the encoded entries added since the last call to `out`
+    /// @param out A buffer to append to
+    auto take(std::string& out) -> void;
+
+  private:
+    /// @brief Encodes the current block and starts a new block at `offset`
+    auto seal(std::uint64_t offset) -> void;
+
+    /// @brief Finds the ID of a name, encoding a name entry if the name is new
+    auto name_id(std::string_view name) -> std::uint32_t;
+
+    const std::size_t block_size_;
+
+    /// Entries not yet taken
+    std::string pending_;
+
+    /// The block records are currently added to
+    index_block block_;
+
+    /// Set once a record has been added to `block_`
+    bool block_started_ = false;
+
+    /// Number of blocks encoded, which is also the number of the current block
+    std::uint32_t block_number_ = 0;
+
+    /// Storage of the names seen so far
+    std::deque<std::string> names_;
+
+    /// IDs of the names seen so far, keyed by views of `names_`
+    std::unordered_map<std::string_view, std::uint32_t> ids_;
+
+    /// Number of the last block containing each name, indexed by ID
+    std::vector<std::uint32_t> last_block_;
+};
+
+/// A decoded index
+class Index {
+  public:
+    using time_point_t = record_info::time_point_t;
+
+    /// @brief Decodes an index
+    /// @param data The encoded index
+    /// @throw bad_index_data if `data` does not start with `index_magic`
+    /// @throw bad_index_data if `data` contains an unknown entry
+    /// @note An incomplete entry at the end of `data`, such as one being written, is ignored
+    explicit Index(std::string_view data);
+
+    /// @brief All blocks, in the order of the output
+    auto blocks() const noexcept -> const std::vector<index_block>& { return blocks_; }
+
+    /// @brief End of the last block, after which records are not indexed
+    auto end() const noexcept -> std::uint64_t;
+
+    /// @brief Finds the blocks which may contain matching records
+    /// @param name If set, only blocks containing records with this name are returned
+    /// @param from Earliest timestamp of matching records
+    /// @param to Latest timestamp of matching records
+    /// @return The blocks, in the order of the output
+    ///
+    /// Blocks containing no records with a timestamp are only matched by name. The first block
+    /// containing a name contains the name definition written by `logger --dictionary`, which
+    /// later records refer to by ID. If `name` is set, its first block is always returned.
+    /// Otherwise, the first block of each name in a matching block is also returned.
+    auto find(std::optional<std::string_view> name, time_point_t from, time_point_t to) const
+        -> std::vector<const index_block*>;
+
+  private:
+    std::vector<index_block> blocks_;
+
+    /// Numbers of the blocks containing each name, in increasing order
+    std::unordered_map<std::string, std::vector<std::uint32_t>> postings_;
+
+    /// Number of the first block containing each name, indexed by ID
+    std::vector<std::uint32_t> first_block_;
+};
+
+} // namespace logger
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace reader {
+
+/// A read-only memory mapping of a file
+///
+/// The file descriptor is closed once the file is mapped, so the mapping does not hold a file
+/// open. The contents are undefined if the file is truncated while mapped.
+class MappedFile {
+  public:
+    /// @brief Maps a file into memory
+    /// @param path Path of the file to map
+    /// @throw std::system_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path) {
+        const auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::system_error{errno, std::generic_category(), path};
+        }
+
+        struct ::stat st {};
+        if (::fstat(fd, &st) == -1) {
+            const auto error = errno;
+            ::close(fd);
+            throw std::system_error{error, std::generic_category(), path};
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+
+        // Empty files cannot be mapped
+        if (size_ > 0) {
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        const auto error = errno;
+        ::close(fd);
+
+        if (data_ == MAP_FAILED) {
+            throw std::system_error{error, std::generic_category(), path};
+        }
+    }
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// @brief Contents of the file
+    auto data() const noexcept -> std::string_view {
+        return {static_cast<const char*>(data_), size_};
+    }
+
+  private:
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace reader
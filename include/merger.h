@@ -0,0 +1,220 @@
+#pragma once
+
+#include "index.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logger {
+
+/// Merges the records of many sources, such as connections, into sensor timestamp order
+///
+/// Each source buffers its records in a run sorted by timestamp. A sensor sending in order only
+/// appends to its run. The watermark trails the latest timestamp added by the reorder window,
+/// and records at or before it are released by a k-way merge: a heap holds each non-empty run
+/// keyed by its earliest record, so releasing a record takes logarithmic time in the number of
+/// sources. Records with equal timestamps are released in the order they were added.
+///
+/// A record older than one already released cannot be placed in order. It is written
+/// immediately and counted as late. So that a sensor with a clock far ahead cannot hold the
+/// watermark ahead of all other sensors, a record more than the reorder window ahead of the
+/// system clock is also written immediately, counted as late, and does not advance the
+/// watermark.
+///
+/// Records without a timestamp, such as name definitions, are written immediately. As other
+/// records are only ever delayed, a record following such a record is still written after it.
+///
+/// Records are handed to the sink outside the lock, by one thread at a time in the order they
+/// were released, so that sources keep adding records while the sink writes. The storage of
+/// written records is reused for records added later.
+class Merger {
+  public:
+    using clock_t = record_info::clock_t;
+    using time_point_t = record_info::time_point_t;
+
+    /// Receives each record in order, without a trailing newline
+    using sink_type = std::function<void(std::string_view record, const record_info& info)>;
+
+    /// Receives the number of late records written since the previous report, and the furthest
+    /// any of them was behind the records already released
+    using late_handler_type =
+        std::function<void(std::uint64_t count, std::chrono::milliseconds behind)>;
+
+  private:
+    struct entry {
+        time_point_t timestamp;
+
+        /// Order in which the record was added, breaking ties between equal timestamps
+        std::uint64_t sequence;
+
+        /// The record followed by the sensor name
+        std::string data;
+        std::size_t record_size;
+    };
+
+    /// A record waiting to be handed to the sink
+    struct released_record {
+        /// The record followed by the sensor name
+        std::string data;
+        std::size_t record_size;
+        std::optional<time_point_t> timestamp;
+    };
+
+    struct run {
+        /// Buffered records, ordered by timestamp and sequence
+        std::deque<entry> entries;
+
+        /// Identifies the current heap node of the run. Nodes are not updated when a record is
+        /// inserted before the earliest one, but replaced by a node with a new generation.
+        std::uint64_t generation = 0;
+    };
+
+  public:
+    /// A source of records, such as a connection
+    ///
+    /// Records added after the source is destroyed are still released in order.
+    class source {
+      public:
+        /// @brief Buffers a record until it can be released in order
+        /// @param record The record, without a trailing newline
+        /// @param info Sensor name and timestamp of the record
+        auto add(std::string_view record, const record_info& info) -> void {
+            merger_->add(run_, record, info);
+        }
+
+      private:
+        friend class Merger;
+
+        source(Merger& merger, std::shared_ptr<run> r) : merger_{&merger}, run_{std::move(r)} {}
+
+        Merger* merger_;
+        std::shared_ptr<run> run_;
+    };
+
+    /// @brief Creates a Merger without any sources
+    /// @param window How far a record may lag behind the latest timestamp and still be written
+    ///        in order
+    /// @param sink Invoked with each record, from a thread adding records or expiring, without
+    ///        any lock held
+    /// @param on_late Invoked by `expire` and `flush` if late records were written since the
+    ///        previous report, if set
+    Merger(std::chrono::milliseconds window, sink_type sink, late_handler_type on_late = {});
+
+    Merger(const Merger&) = delete;
+    Merger& operator=(const Merger&) = delete;
+
+    /// @brief Creates a source of records
+    auto open() -> source;
+
+    /// @brief Releases all records if none were added since the previous call, and reports late
+    ///        records
+    ///
+    /// Records are otherwise only released when later records arrive, so this should be called
+    /// about once per reorder window.
+    auto expire() -> void;
+
+    /// @brief Releases all records, and returns once they are written
+    auto flush() -> void;
+
+    /// @brief Number of records buffered
+    auto buffered() const noexcept -> std::uint64_t {
+        return buffered_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Number of records written out of order
+    auto late() const noexcept -> std::uint64_t { return late_.load(std::memory_order_relaxed); }
+
+  private:
+    /// A run in the heap, keyed by its earliest record when the node was created
+    struct node {
+        time_point_t timestamp;
+        std::uint64_t sequence;
+        std::uint64_t generation;
+        std::shared_ptr<run> r;
+    };
+
+    auto add(const std::shared_ptr<run>& r, std::string_view record, const record_info& info)
+        -> void;
+
+    /// @brief Adds a heap node for the earliest record of a run, replacing any previous node
+    /// @note Must be called with `mutex_` held
+    auto push(const std::shared_ptr<run>& r) -> void;
+
+    /// @brief Queues the records at or before `watermark` to be written, in order
+    /// @note Must be called with `mutex_` held
+    auto release(time_point_t watermark) -> void;
+
+    /// @brief Queues a record to be written without buffering it
+    /// @note Must be called with `mutex_` held
+    auto write(std::string_view record, const record_info& info) -> void;
+
+    /// @brief Writes the queued records, unless another thread is already writing them
+    /// @param lock A lock of `mutex_`, which is released while the sink is invoked
+    auto drain(std::unique_lock<std::mutex>& lock) -> void;
+
+    /// @brief Invokes the late handler if late records were written since the previous report
+    /// @param lock A lock of `mutex_`, which is released
+    auto report_late(std::unique_lock<std::mutex>& lock) -> void;
+
+    /// @brief Storage for a record, reusing the storage of a written record if there is one
+    /// @note Must be called with `mutex_` held
+    auto storage() -> std::string;
+
+    /// Largest number of written records whose storage is kept for reuse
+    static constexpr std::size_t max_spare = 4096;
+
+    const std::chrono::milliseconds window_;
+    const sink_type sink_;
+    const late_handler_type on_late_;
+
+    std::mutex mutex_;
+
+    /// Signalled once the queued records are written
+    std::condition_variable drained_;
+
+    /// Min-heap of runs with buffered records
+    std::vector<node> heap_;
+
+    /// Records released but not yet handed to the sink, in order
+    std::vector<released_record> queued_;
+
+    /// Records being handed to the sink by the thread writing them
+    std::vector<released_record> writing_;
+
+    /// Set while a thread is writing queued records
+    bool draining_ = false;
+
+    /// Storage of written records, kept for reuse
+    std::vector<std::string> spare_;
+
+    std::uint64_t sequence_ = 0;
+
+    /// Latest timestamp added
+    std::optional<time_point_t> latest_;
+
+    /// Timestamp of the last record released
+    std::optional<time_point_t> released_;
+
+    /// Set when a record is added, and cleared by `expire`
+    bool active_ = false;
+
+    /// Late records written since the previous report, and the furthest any was behind
+    std::uint64_t unreported_late_ = 0;
+    std::chrono::milliseconds unreported_behind_{0};
+
+    std::atomic<std::uint64_t> buffered_{0};
+    std::atomic<std::uint64_t> late_{0};
+};
+
+} // namespace logger
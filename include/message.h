@@ -2,12 +2,15 @@
 
 #include "aux.h"
 #include "compat/asio.h"
+#include "nonstd/expected.hpp"
+#include "wire.h"
 
 #include <chrono>
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace reader {
 
@@ -16,15 +19,99 @@ struct bad_message_data : public std::length_error {
     bad_message_data(const char* what_arg) : length_error(what_arg) {}
 };
 
+/// Thrown when a string field is not valid UTF-8 and cannot be encoded as JSON
+struct bad_string_data : public std::invalid_argument {
+    bad_string_data(const std::string& what_arg) : invalid_argument(what_arg) {}
+};
+
+/// Reason a message cannot be decoded
+enum class decode_error {
+    /// The payload is smaller than the message minimum size
+    too_small,
+    /// The name size results in overrun of the payload
+    name_overrun,
+    /// The payload contains unused bytes after the last field
+    unused_bytes,
+    /// The name is not valid UTF-8
+    invalid_name,
+};
+
+/// @brief Describes why a message cannot be decoded
+/// @param wire_data The message payload which could not be decoded
+/// @param error The reason returned by `try_decode_view` or `try_decode`
+/// @return The description used by the exception thrown when constructing a MessageView from
+///         `wire_data`
+auto describe(asio::const_buffer wire_data, decode_error error) -> std::string;
+
 /// Byte size of fields in wire format
+/// @see wire::message_schema
 namespace wire_size {
-constexpr uint32_t message_length = 4;
-constexpr uint32_t timestamp = 8;
-constexpr uint32_t nlen = 1;
-constexpr uint32_t temperature = 3;
-constexpr uint32_t humidity = 2;
+constexpr uint32_t message_length = wire::message_schema::length::size;
+constexpr uint32_t timestamp = wire::message_schema::timestamp::size;
+constexpr uint32_t nlen = wire::message_schema::name::size_type::size;
+constexpr uint32_t temperature = wire::message_schema::temperature::size;
+constexpr uint32_t humidity = wire::message_schema::humidity::size;
+
+/// Largest possible message payload, which excludes the message length field
+constexpr uint32_t max_payload = wire::message_schema::max_payload;
 } // namespace wire_size
 
+/// A non-owning view of a sensor data message in wire format
+///
+/// A MessageView validates the layout of a message and the encoding of its name on construction
+/// but does not copy it. Fields are decoded from the underlying buffer when they are accessed, so
+/// constructing a valid MessageView does not allocate.
+///
+/// @note The buffer must be guaranteed to exist for the lifetime of the MessageView
+class MessageView {
+  public:
+    using clock_t = std::chrono::system_clock;
+    using time_point_t = std::chrono::time_point<clock_t>;
+
+    /// @brief Constructs a view of a message in wire format
+    /// @param wire_data A const buffer which contains the message payload
+    /// @throw bad_message_data if `wire_data` is too small to contain a message
+    /// @throw bad_message_data if the decoded name has a size inconsistent with the message
+    /// @throw bad_message_data if `wire_size` contains unused bytes after decoding
+    /// @throw bad_string_data if the name is not valid UTF-8, with the same description as
+    ///        `nlohmann::json::dump`
+    /// @note The payload is not expected to contain the message length header
+    explicit MessageView(asio::const_buffer wire_data);
+
+    auto timestamp() const noexcept -> time_point_t;
+    auto name() const noexcept -> std::string_view;
+    auto temperature() const noexcept -> std::optional<float>;
+    auto humidity() const noexcept -> std::optional<float>;
+
+    /// @brief Creates a JSON representation of the message
+    /// @return A JSON object
+    auto as_json() const -> nlohmann::json;
+
+  private:
+    friend auto try_decode_view(asio::const_buffer wire_data) noexcept
+        -> nonstd::expected<MessageView, decode_error>;
+
+    /// @brief Constructs a view of a message whose layout has already been validated
+    MessageView(const unsigned char* data, wire::message_layout layout) noexcept;
+
+    /// Start of the message payload
+    const unsigned char* data_;
+
+    /// Size of the name and the optional fields present
+    wire::message_layout layout_;
+};
+
+/// @brief Constructs a view of a message in wire format without throwing
+/// @param wire_data A const buffer which contains the message payload
+/// @return The message view, or the reason the message cannot be decoded
+///
+/// Validates the same conditions as the MessageView constructor, so that malformed messages cost
+/// no more to reject than valid messages cost to accept.
+///
+/// @note The buffer must be guaranteed to exist for the lifetime of the MessageView
+auto try_decode_view(asio::const_buffer wire_data) noexcept
+    -> nonstd::expected<MessageView, decode_error>;
+
 /// Represents a sensor data message
 class Message {
   public:
@@ -36,9 +123,13 @@ class Message {
     /// @throw bad_message_data if `wire_data` is too small to contain a message
     /// @throw bad_message_data if the decoded name has a size inconsistent with the message
     /// @throw bad_message_data if `wire_size` contains unused bytes after decoding
+    /// @throw bad_string_data if the name is not valid UTF-8
     /// @note The payload is not expected to contain the message length header
     explicit Message(asio::const_buffer wire_data);
 
+    /// @brief Constructs a message by copying the fields of a message view
+    explicit Message(const MessageView& view);
+
     auto timestamp() const noexcept -> time_point_t { return timestamp_; }
     auto name() const noexcept -> const std::string& { return name_; }
     auto temperature() const noexcept -> std::optional<float> { return temperature_; }
@@ -49,20 +140,24 @@ class Message {
     auto as_json() const -> nlohmann::json;
 
   private:
-    auto set_timestamp(asio::const_buffer wire_data) -> void;
-    auto set_name(asio::const_buffer wire_data) -> void;
-    auto set_temperature(asio::const_buffer wire_data) -> void;
-    auto set_humidity(asio::const_buffer wire_data) -> void;
-
     time_point_t timestamp_;
     std::string name_;
     std::optional<float> temperature_;
     std::optional<float> humidity_;
 };
 
+/// @brief Constructs a message by decoding bytes in wire format without throwing
+/// @param wire_data A const buffer to decode which contains the message payload
+/// @return The message, or the reason the message cannot be decoded
+/// @see try_decode_view
+auto try_decode(asio::const_buffer wire_data) -> nonstd::expected<Message, decode_error>;
+
 /// @brief Writes a `Message` to an output stream
 auto operator<<(std::ostream& out, const Message& message) -> std::ostream&;
 
+/// @brief Writes a `MessageView` to an output stream
+auto operator<<(std::ostream& out, const MessageView& message) -> std::ostream&;
+
 /// @brief Decodes the message length from wire data
 /// @param wire_data A const buffer to decode, containing `wire_size::message_length` bytes
 /// @throw bad_message_data if the size of the provided buffer does not match message length
@@ -78,4 +173,7 @@ auto decode_message_payload_length(asio::const_buffer wire_data) -> uint32_t;
 /// @brief Convert a Message to JSON
 void to_json(nlohmann::json& j, const Message& message);
 
+/// @brief Convert a MessageView to JSON
+void to_json(nlohmann::json& j, const MessageView& message);
+
 } // namespace reader
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "compat/asio.h"
+#include "simd.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace reader {
+
+/// @brief Converts temperatures in hundredths of K to °C
+/// @param packed `count` temperatures in wire format, each a 3-byte big-endian integer
+/// @param count Number of temperatures
+/// @param[out] out Space for `count` temperatures
+/// @param isa Implementation used to convert, which must be supported by the running CPU
+///
+/// Results are identical to `MessageView::temperature` for every implementation.
+auto convert_temperatures(const unsigned char* packed,
+                          std::size_t count,
+                          float* out,
+                          simd_isa isa) noexcept -> void;
+
+/// @brief Converts relative humidities in ‰ to %
+/// @param packed `count` humidities in wire format, each a 2-byte big-endian integer
+/// @param count Number of humidities
+/// @param[out] out Space for `count` humidities
+/// @param isa Implementation used to convert, which must be supported by the running CPU
+///
+/// Results are identical to `MessageView::humidity` for every implementation.
+auto convert_humidities(const unsigned char* packed,
+                        std::size_t count,
+                        float* out,
+                        simd_isa isa) noexcept -> void;
+
+/// A batch of sensor data messages decoded from a buffer of frames, stored by field
+///
+/// Decoding validates each frame and gathers its fields into columns: timestamps, the offsets and
+/// sizes of names, and the temperatures and humidities in wire format with a bitmap of the
+/// messages which have them. The units of whole columns are then converted with vectorized
+/// kernels, instead of one field at a time as with MessageView.
+///
+/// Names are not copied and refer to the decoded buffer. The storage of a batch is reused by the
+/// next call to `decode`, so decoding does not allocate once the batch has grown to fit.
+///
+/// @note The decoded buffer must be guaranteed to exist while the messages of the batch are used
+class MessageBatch {
+  public:
+    using clock_t = std::chrono::system_clock;
+    using time_point_t = std::chrono::time_point<clock_t>;
+
+    /// A message of a batch, with the accessors of MessageView
+    class row {
+      public:
+        auto timestamp() const noexcept -> time_point_t;
+        auto name() const noexcept -> std::string_view;
+        auto temperature() const noexcept -> std::optional<float>;
+        auto humidity() const noexcept -> std::optional<float>;
+
+      private:
+        friend class MessageBatch;
+
+        row(const MessageBatch& batch, std::size_t index) noexcept
+            : batch_{&batch}, index_{index} {}
+
+        const MessageBatch* batch_;
+        std::size_t index_;
+    };
+
+    /// @brief Creates an empty batch converting units with the fastest implementation supported
+    ///        by the running CPU
+    MessageBatch();
+
+    /// @brief Creates an empty batch converting units with a specific implementation
+    /// @note `isa` must be supported by the running CPU
+    explicit MessageBatch(simd_isa isa) noexcept;
+
+    /// @brief Decodes consecutive frames, replacing the messages of the batch
+    /// @param frames A buffer starting at a message length header
+    /// @return The number of bytes decoded
+    ///
+    /// Decoding stops at the end of `frames`, at an incomplete frame, or at a frame which cannot
+    /// be decoded, which starts at the returned offset. The reason it cannot be decoded is given
+    /// by `try_decode_view`.
+    auto decode(asio::const_buffer frames) -> std::size_t;
+
+    /// @brief Number of messages in the batch
+    auto size() const noexcept -> std::size_t { return timestamps_.size(); }
+
+    auto empty() const noexcept -> bool { return timestamps_.empty(); }
+
+    /// @brief The message at `index`
+    /// @note `index` must be less than `size()`
+    auto operator[](std::size_t index) const noexcept -> row { return {*this, index}; }
+
+    /// @brief Timestamps of the messages, in milliseconds since the epoch
+    auto timestamps() const noexcept -> const std::vector<std::int64_t>& { return timestamps_; }
+
+    /// @brief Temperatures of the messages in °C, unspecified for messages without one
+    auto temperatures() const noexcept -> const std::vector<float>& { return temperatures_; }
+
+    /// @brief Relative humidities of the messages in %, unspecified for messages without one
+    auto humidities() const noexcept -> const std::vector<float>& { return humidities_; }
+
+    /// @brief Checks if the message at `index` has a temperature
+    auto has_temperature(std::size_t index) const noexcept -> bool {
+        return test(temperature_present_, index);
+    }
+
+    /// @brief Checks if the message at `index` has a humidity
+    auto has_humidity(std::size_t index) const noexcept -> bool {
+        return test(humidity_present_, index);
+    }
+
+  private:
+    static constexpr std::size_t bitmap_word_bits = 64;
+
+    static auto test(const std::vector<std::uint64_t>& bitmap, std::size_t index) noexcept
+        -> bool {
+        return (bitmap[index / bitmap_word_bits] >> (index % bitmap_word_bits)) & 1;
+    }
+
+    /// @brief Resizes the columns to hold `count` messages
+    auto resize(std::size_t count) -> void;
+
+    /// @brief Stores the fields of a valid payload in the columns
+    /// @param index Index of the message, less than the size of the columns
+    auto store(std::size_t index,
+               const unsigned char* payload,
+               std::uint8_t name_size,
+               std::uint8_t present) noexcept -> void;
+
+    simd_isa isa_;
+
+    /// Start of the decoded buffer
+    const unsigned char* data_ = nullptr;
+
+    std::vector<std::int64_t> timestamps_;
+
+    /// Offset of each name from `data_`
+    std::vector<std::size_t> name_offsets_;
+    std::vector<std::uint8_t> name_sizes_;
+
+    /// Fields in wire format, zero for messages without the field
+    std::vector<unsigned char> packed_temperatures_;
+    std::vector<unsigned char> packed_humidities_;
+
+    std::vector<float> temperatures_;
+    std::vector<float> humidities_;
+
+    /// Bit `i % 64` of word `i / 64` is set if message `i` has the field
+    std::vector<std::uint64_t> temperature_present_;
+    std::vector<std::uint64_t> humidity_present_;
+};
+
+} // namespace reader
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace logger {
+
+/// A histogram of non-negative integer values, such as latencies in nanoseconds
+///
+/// Values are counted in buckets whose width doubles every `sub_buckets` buckets, in the manner
+/// of an HdrHistogram. Values are exact below `sub_buckets` and otherwise within a relative
+/// error of `1 / sub_buckets`.
+///
+/// Recording a value is a relaxed atomic increment, so values may be recorded concurrently from
+/// any thread without locking. A concurrent read may observe a partially recorded value.
+/// Histograms updated on a hot path should not be shared between threads; they can be merged
+/// when read instead.
+class Histogram {
+  public:
+    static constexpr unsigned sub_bucket_bits = 4;
+    static constexpr std::size_t sub_buckets = std::size_t{1} << sub_bucket_bits;
+    static constexpr std::size_t bucket_count = (65 - sub_bucket_bits) * sub_buckets;
+
+    /// @brief Counts a value
+    /// @param n Number of times the value is counted
+    auto record(std::uint64_t value, std::uint64_t n = 1) noexcept -> void;
+
+    /// @brief Counts a duration, in nanoseconds
+    /// @param n Number of times the duration is counted
+    /// @note Negative durations are counted as 0
+    template <class Rep, class Period>
+    auto record(std::chrono::duration<Rep, Period> value, std::uint64_t n = 1) noexcept -> void {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(value).count();
+        record(static_cast<std::uint64_t>(ns < 0 ? 0 : ns), n);
+    }
+
+    /// @brief Counts the values recorded by another histogram
+    auto merge(const Histogram& other) noexcept -> void;
+
+    /// @brief Number of values recorded
+    auto count() const noexcept -> std::uint64_t { return count_.load(std::memory_order_relaxed); }
+
+    /// @brief Largest value recorded
+    auto max() const noexcept -> std::uint64_t { return max_.load(std::memory_order_relaxed); }
+
+    /// @brief Finds the value below which a fraction of the recorded values fall
+    /// @param fraction Fraction of values, between 0 and 1
+    /// @return The largest value equivalent to the value at `fraction`, or 0 if no values have
+    ///         been recorded
+    auto percentile(double fraction) const noexcept -> std::uint64_t;
+
+  private:
+    /// @brief Index of the bucket containing a value
+    static auto bucket_index(std::uint64_t value) noexcept -> std::size_t;
+
+    /// @brief Largest value contained in a bucket
+    static auto bucket_max(std::size_t index) noexcept -> std::uint64_t;
+
+    std::array<std::atomic<std::uint64_t>, bucket_count> counts_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+/// Latency histograms of the messages written by the logger
+struct latency_histograms {
+    /// Time to decode a message, in nanoseconds
+    Histogram decode_latency;
+
+    /// Time to serialize a decoded message, in nanoseconds
+    Histogram serialize_latency;
+
+    /// Time to hand a serialized record to the output, in nanoseconds
+    Histogram write_latency;
+
+    /// Time from the sensor timestamp of a message until it is written, in nanoseconds
+    Histogram lag;
+
+    /// @brief Counts the values recorded by other histograms
+    auto merge(const latency_histograms& other) noexcept -> void {
+        decode_latency.merge(other.decode_latency);
+        serialize_latency.merge(other.serialize_latency);
+        write_latency.merge(other.write_latency);
+        lag.merge(other.lag);
+    }
+};
+
+/// Counters of the messages received on a single connection
+///
+/// Each connection updates only its own counters and histograms, so they are not shared between
+/// the threads serving different connections.
+/// @see increment
+struct connection_counters {
+    /// Address and port of the remote sensor client
+    const std::string endpoint;
+
+    /// Number of messages received
+    std::atomic<std::uint64_t> messages{0};
+
+    /// Number of bytes received in complete messages
+    std::atomic<std::uint64_t> bytes{0};
+
+    /// Number of messages which could not be decoded
+    std::atomic<std::uint64_t> decode_errors{0};
+
+    /// Number of messages rejected because a string is not valid UTF-8
+    std::atomic<std::uint64_t> string_errors{0};
+
+    /// Number of messages dropped by the filter before they were decoded
+    std::atomic<std::uint64_t> filtered{0};
+
+    /// Number of bytes received but not yet processed
+    std::atomic<std::uint64_t> buffered{0};
+
+    /// Latencies of the messages received
+    latency_histograms latencies{};
+};
+
+/// @brief Adds to a counter updated by a single thread
+///
+/// Avoids the cost of an atomic read-modify-write, while readers on other threads still observe
+/// whole values.
+inline auto increment(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) noexcept -> void {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/// Telemetry collected by the logger
+///
+/// Tracks counters and latency histograms for each open connection, totals over all
+/// connections, and gauges such as queue depths. All values can be updated from any thread
+/// without locking. Opening or closing a connection and reporting take a lock.
+class Metrics {
+  public:
+    /// @brief Registers a connection
+    /// @param endpoint Address and port of the remote sensor client
+    /// @return Counters for the connection. Once released, they are added to the totals of
+    ///         closed connections.
+    /// @note The Metrics must outlive the returned counters
+    auto open(std::string endpoint) -> std::shared_ptr<connection_counters>;
+
+    /// @brief Registers a gauge reported with the metrics
+    /// @param name Name of the gauge
+    /// @param read Returns the current value of the gauge, and may be called from any thread
+    auto gauge(std::string name, std::function<std::uint64_t()> read) -> void;
+
+    /// @brief Merges the latency histograms of all open and closed connections
+    auto latencies() const -> std::unique_ptr<latency_histograms>;
+
+    /// @brief Writes all metrics as plain text, one metric per line
+    auto report(std::ostream& out) const -> void;
+
+  private:
+    /// @brief Adds the counters of a connection to the totals of closed connections
+    auto close(const connection_counters& counters) -> void;
+
+    /// @brief Merges the latency histograms of all open and closed connections
+    /// @note Must be called with `mutex_` held
+    auto merged_latencies() const -> std::unique_ptr<latency_histograms>;
+
+    /// Guards the registered connections, the closed totals and the gauges
+    mutable std::mutex mutex_;
+
+    /// Counters of open connections
+    std::vector<const connection_counters*> connections_;
+
+    /// Totals of closed connections
+    std::uint64_t closed_ = 0;
+    std::uint64_t closed_messages_ = 0;
+    std::uint64_t closed_bytes_ = 0;
+    std::uint64_t closed_decode_errors_ = 0;
+    std::uint64_t closed_string_errors_ = 0;
+    std::uint64_t closed_filtered_ = 0;
+    latency_histograms closed_latencies_;
+
+    /// Registered gauges
+    std::vector<std::pair<std::string, std::function<std::uint64_t()>>> gauges_;
+};
+
+} // namespace logger
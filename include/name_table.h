@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace logger {
+
+/// Compact identifier of an interned sensor name
+using name_id = std::uint32_t;
+
+/// A name stored in a NameTable
+struct interned_name {
+    name_id id;
+
+    /// The name, referring to storage owned by the NameTable
+    std::string_view name;
+};
+
+/// Maps sensor names to compact IDs, shared by all connections
+///
+/// IDs are assigned in the order names are first seen, starting at 0. Interned names are stored
+/// once and never removed, so views of them remain valid for the lifetime of the table. Once
+/// `capacity` names are interned, new names are not assigned an ID.
+///
+/// Names are spread over shards with their own lock, so that connections looking up names on
+/// different threads rarely contend. Lookups of known names only take a shared lock and do not
+/// allocate.
+class NameTable {
+  public:
+    static constexpr std::size_t shard_count = 16;
+
+    /// @brief Creates an empty table
+    /// @param capacity Maximum number of names interned
+    explicit NameTable(std::size_t capacity) : capacity_{capacity} {}
+
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    /// @brief Finds an interned name
+    /// @return The interned name, or std::nullopt if `name` has not been interned
+    auto find(std::string_view name) const -> std::optional<interned_name> {
+        const auto& s = shard_for(name);
+
+        const auto lock = std::shared_lock<std::shared_mutex>{s.mutex};
+        return find(s, name);
+    }
+
+    /// @brief Finds an interned name, interning it if it has not been seen before
+    /// @param name The name to intern
+    /// @param define Invoked as `define(id, interned)` when `name` is interned
+    /// @return The interned name, or std::nullopt if `name` is new and the table is full
+    ///
+    /// `define` is invoked before the new ID can be found by any other thread, so that a
+    /// definition written by `define` precedes any use of the ID by other connections.
+    template <class Define>
+    auto intern(std::string_view name, Define&& define) -> std::optional<interned_name> {
+        if (const auto found = find(name)) {
+            return found;
+        }
+
+        auto& s = shard_for(name);
+
+        const auto lock = std::unique_lock<std::shared_mutex>{s.mutex};
+
+        // Interned by another thread after the shared lock was released
+        if (const auto found = find(s, name)) {
+            return found;
+        }
+
+        auto id = size_.load(std::memory_order_relaxed);
+        do {
+            if (id == capacity_) {
+                return std::nullopt;
+            }
+        } while (!size_.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+
+        const auto interned = interned_name{static_cast<name_id>(id), s.names.emplace_back(name)};
+        std::invoke(std::forward<Define>(define), interned.id, interned.name);
+        s.ids.emplace(interned.name, interned.id);
+
+        return interned;
+    }
+
+    /// @brief Lists the interned names
+    /// @return The interned names, ordered by ID
+    ///
+    /// A name interned concurrently is either listed, or its definition is written after the
+    /// names are listed.
+    auto names() const -> std::vector<interned_name> {
+        auto out = std::vector<interned_name>{};
+        for (const auto& s : shards_) {
+            const auto lock = std::shared_lock<std::shared_mutex>{s.mutex};
+            for (const auto& [name, id] : s.ids) {
+                out.push_back({id, name});
+            }
+        }
+
+        std::sort(out.begin(), out.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.id < rhs.id;
+        });
+        return out;
+    }
+
+    /// @brief The number of interned names
+    auto size() const noexcept -> std::size_t { return size_.load(std::memory_order_relaxed); }
+
+  private:
+    struct shard {
+        mutable std::shared_mutex mutex;
+
+        /// Storage of the interned names, which is not moved when names are added
+        std::deque<std::string> names;
+
+        /// IDs of the interned names, keyed by views of `names`
+        std::unordered_map<std::string_view, name_id> ids;
+    };
+
+    auto shard_for(std::string_view name) const -> const shard& {
+        return shards_[std::hash<std::string_view>{}(name) % shard_count];
+    }
+
+    auto shard_for(std::string_view name) -> shard& {
+        return shards_[std::hash<std::string_view>{}(name) % shard_count];
+    }
+
+    /// @note Must be called with the lock of `s` held
+    static auto find(const shard& s, std::string_view name) -> std::optional<interned_name> {
+        const auto it = s.ids.find(name);
+        if (it == s.ids.end()) {
+            return std::nullopt;
+        }
+        return interned_name{it->second, it->first};
+    }
+
+    std::array<shard, shard_count> shards_;
+
+    const std::size_t capacity_;
+
+    /// Number of interned names, which is also the next ID
+    std::atomic<std::size_t> size_{0};
+};
+
+} // namespace logger
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "compat/asio.h"
+#include "writer.h"
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace logger {
+
+/// Destination for sensor records and status messages written by connections
+///
+/// Connections format a complete record or status line before handing it to an Output, so a
+/// single write never interleaves with a write from another connection.
+///
+/// When constructed with an executor, writes are dispatched to a strand of that executor. This
+/// serializes access to the output streams across threads without a global lock: an uncontended
+/// write runs inline on the calling thread, while a contended write is queued and executed by the
+/// thread currently running the strand.
+///
+/// When constructed with a Writer, records are handed to the Writer instead of being written to
+/// a stream, so that connection handlers never block on file I/O. Status messages are still
+/// written on the strand.
+class Output {
+  public:
+    using executor_type = asio::io_context::executor_type;
+
+    /// @brief Creates an Output that writes directly to the output streams
+    /// @param out An ostream to write sensor records to
+    /// @param err An ostream to write status messages to
+    /// @note Only suitable when all connections run on a single thread
+    Output(std::ostream& out, std::ostream& err) : out_{&out}, err_{err} {}
+
+    /// @brief Creates an Output that serializes writes on a strand
+    /// @param executor Executor used to create the strand
+    /// @param out An ostream to write sensor records to
+    /// @param err An ostream to write status messages to
+    Output(executor_type executor, std::ostream& out, std::ostream& err)
+        : strand_{asio::make_strand(executor)}, out_{&out}, err_{err} {}
+
+    /// @brief Creates an Output that serializes writes on a strand and batches records
+    /// @param executor Executor used to create the strand
+    /// @param writer A Writer to hand sensor records to
+    /// @param err An ostream to write status messages to
+    /// @note `writer` must be guaranteed to exist for the lifetime of the Output
+    Output(executor_type executor, Writer& writer, std::ostream& err)
+        : strand_{asio::make_strand(executor)}, writer_{&writer}, err_{err} {}
+
+    /// @brief Writes a sensor record, followed by a newline
+    ///
+    /// A Writer synchronizes appends itself, so records are handed to it directly without copying.
+    auto write(std::string_view record) -> void {
+        if (writer_) {
+            writer_->write(record);
+            return;
+        }
+
+        // The record is only copied if the write may be deferred
+        if (!strand_) {
+            *out_ << record << std::endl;
+            return;
+        }
+
+        run([out = out_, record = std::string{record}]() { *out << record << std::endl; });
+    }
+
+    /// @brief Writes a sensor record, followed by a newline
+    /// @param record The record to write
+    /// @param info Sensor name and timestamp of the record, used if the Writer indexes records
+    auto write(std::string_view record, const record_info& info) -> void {
+        if (writer_) {
+            writer_->write(record, info);
+            return;
+        }
+
+        write(record);
+    }
+
+    /// @brief Writes data verbatim, without a trailing newline
+    ///
+    /// Used for binary records, so the output stream is flushed to keep records whole if the
+    /// process is interrupted.
+    auto capture(std::string_view data) -> void {
+        if (writer_) {
+            writer_->append(data);
+            return;
+        }
+
+        if (!strand_) {
+            out_->write(data.data(), static_cast<std::streamsize>(data.size()));
+            out_->flush();
+            return;
+        }
+
+        run([out = out_, data = std::string{data}]() {
+            out->write(data.data(), static_cast<std::streamsize>(data.size()));
+            out->flush();
+        });
+    }
+
+    /// @brief Writes a status message
+    auto status(std::string message) -> void {
+        run([&err = err_, message = std::move(message)]() { err << message; });
+    }
+
+  private:
+    template <class F>
+    auto run(F&& f) -> void {
+        if (strand_) {
+            asio::dispatch(*strand_, std::forward<F>(f));
+        } else {
+            f();
+        }
+    }
+
+    /// Strand serializing writes, if connections run on multiple threads
+    std::optional<asio::strand<executor_type>> strand_;
+
+    /// Output stream to write sensor records to, if not using a Writer
+    std::ostream* out_ = nullptr;
+
+    /// Writer to hand sensor records to
+    Writer* writer_ = nullptr;
+
+    /// Output stream to write status/error messages to
+    std::ostream& err_;
+};
+
+} // namespace logger
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace logger {
+
+/// A free list of fixed-size blocks, carved from slabs of `slab_blocks` blocks
+/// @tparam Size Size of each block
+/// @tparam Align Alignment of each block
+///
+/// Released blocks are kept for reuse instead of being returned to the heap, so once the pool has
+/// grown to the peak number of blocks in use, allocating and releasing blocks does not call
+/// malloc. Slabs are never freed.
+///
+/// Blocks may be allocated and released from any thread.
+template <std::size_t Size, std::size_t Align>
+class block_pool {
+  public:
+    static constexpr std::size_t slab_blocks = 64;
+
+    static auto allocate() -> void* {
+        const auto lock = std::lock_guard<std::mutex>{mutex_};
+        if (free_ == nullptr) {
+            grow();
+        }
+
+        const auto block = free_;
+        free_ = free_->next;
+        return block;
+    }
+
+    static auto deallocate(void* pointer) noexcept -> void {
+        const auto block = static_cast<node*>(pointer);
+
+        const auto lock = std::lock_guard<std::mutex>{mutex_};
+        block->next = free_;
+        free_ = block;
+    }
+
+  private:
+    union node {
+        node* next;
+        std::aligned_storage_t<Size, Align> storage;
+    };
+
+    /// @brief Allocates a slab and adds its blocks to the free list
+    /// @note Must be called with `mutex_` held
+    static auto grow() -> void {
+        const auto slab = new node[slab_blocks];
+        for (auto i = std::size_t{}; i < slab_blocks; ++i) {
+            slab[i].next = (i + 1 < slab_blocks) ? &slab[i + 1] : free_;
+        }
+        free_ = slab;
+    }
+
+    static inline std::mutex mutex_;
+    static inline node* free_ = nullptr;
+};
+
+/// Allocator handing out single objects from a block_pool shared by all objects of the same
+/// size and alignment
+/// @tparam T Type of the allocated objects
+///
+/// Used with `std::allocate_shared`, which rebinds the allocator to its control block type.
+/// Allocations of more than one object are forwarded to the heap.
+template <class T>
+class pool_allocator {
+  public:
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+
+    template <class U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+
+    auto allocate(std::size_t n) const -> T* {
+        if (n != 1) {
+            return std::allocator<T>{}.allocate(n);
+        }
+        return static_cast<T*>(pool::allocate());
+    }
+
+    auto deallocate(T* p, std::size_t n) const noexcept -> void {
+        if (n != 1) {
+            std::allocator<T>{}.deallocate(p, n);
+            return;
+        }
+        pool::deallocate(p);
+    }
+
+    template <class U>
+    auto operator==(const pool_allocator<U>&) const noexcept -> bool {
+        return true;
+    }
+
+    template <class U>
+    auto operator!=(const pool_allocator<U>&) const noexcept -> bool {
+        return false;
+    }
+
+  private:
+    using pool = block_pool<sizeof(T), alignof(T)>;
+};
+
+} // namespace logger
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "index.h"
+#include "timestamp.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace logger {
+
+/// Selects records by sensor name and timestamp
+struct query_options {
+    /// Name of the records, or any name if unset
+    std::optional<std::string> name;
+
+    /// Earliest timestamp of the records
+    record_info::time_point_t from = record_info::time_point_t::min();
+
+    /// Latest timestamp of the records
+    record_info::time_point_t to = record_info::time_point_t::max();
+};
+
+/// Finds records in the output of `logger --index`, reading only the blocks which may contain
+/// them
+class Query {
+  public:
+    Query(std::string_view log,
+          const Index& index,
+          query_options options,
+          std::ostream& out,
+          std::ostream& err)
+        : log_{log}, index_{index}, options_{std::move(options)}, out_{out}, err_{err} {}
+
+    /// @brief Writes all matching records, in the order of the log
+    auto run() -> void {
+        const auto blocks = index_.find(options_.name, options_.from, options_.to);
+
+        // Adjacent blocks are scanned as a single range
+        auto scanned = std::uint64_t{0};
+        for (auto it = blocks.cbegin(); it != blocks.cend();) {
+            const auto begin = (*it)->offset;
+            auto end = begin + (*it)->size;
+            for (++it; it != blocks.cend() && (*it)->offset == end; ++it) {
+                end += (*it)->size;
+            }
+
+            scanned += scan(begin, end);
+        }
+
+        // Records written after the last block was indexed, e.g. if the logger is still running
+        scanned += scan(index_.end(), log_.size());
+
+        err_ << "Scanned " << blocks.size() << " of " << index_.blocks().size() << " blocks, "
+             << scanned << " of " << log_.size() << " bytes\n";
+    }
+
+  private:
+    /// @brief Writes the matching records of a range of the log
+    /// @return The number of bytes scanned
+    auto scan(std::uint64_t begin, std::uint64_t end) -> std::uint64_t {
+        if (begin >= log_.size()) {
+            return 0;
+        }
+
+        auto range = log_.substr(begin, end - begin);
+        const auto size = range.size();
+
+        while (!range.empty()) {
+            const auto record = next_record(range);
+            if (matches(record)) {
+                out_ << record << '\n';
+            }
+        }
+
+        return size;
+    }
+
+    /// @brief Removes the first record from a range of the log
+    /// @return The record, without the trailing newline
+    static auto next_record(std::string_view& range) -> std::string_view {
+        // Pretty records span lines, from a line `{` to a line `}`. Compact records are a single
+        // line.
+        const auto end = [&range]() {
+            const auto pretty = range.substr(0, 2) == "{\n";
+            const auto found = pretty ? range.find("\n}\n") : range.find('\n');
+            if (found == std::string_view::npos) {
+                return range.size();
+            }
+            return pretty ? found + 2 : found;
+        }();
+
+        const auto record = range.substr(0, end);
+        range.remove_prefix(std::min(end + 1, range.size()));
+        return record;
+    }
+
+    /// @brief Checks if a record matches the query
+    ///
+    /// Name definitions written by `logger --dictionary` are matched by name only, and are
+    /// remembered to find the name of later records. Records with fields of an unexpected type
+    /// are not matched.
+    auto matches(std::string_view record) -> bool {
+        const auto json = nlohmann::json::parse(record, nullptr, false);
+        if (json.is_discarded() || !json.is_object()) {
+            return false;
+        }
+
+        const auto id = json.find("id");
+        const auto name = json.find("name");
+        const auto name_id = json.find("name_id");
+        const auto has_id = id != json.end() && id->is_number_unsigned();
+        const auto has_name = name != json.end() && name->is_string();
+
+        if (has_id && has_name) {
+            const auto& defined = names_[id->get<std::uint32_t>()] = name->get<std::string>();
+            return !options_.name || *options_.name == defined;
+        }
+
+        if (options_.name) {
+            if (has_name ? name->get_ref<const std::string&>() != *options_.name
+                         : (name_id == json.end() || !name_id->is_number_unsigned() ||
+                            names_[name_id->get<std::uint32_t>()] != *options_.name)) {
+                return false;
+            }
+        }
+
+        const auto timestamp = json.find("timestamp");
+        if (timestamp == json.end() || !timestamp->is_string()) {
+            return false;
+        }
+        const auto t = reader::parse_timestamp(timestamp->get_ref<const std::string&>());
+        return t && *t >= options_.from && *t <= options_.to;
+    }
+
+    const std::string_view log_;
+    const Index& index_;
+    const query_options options_;
+    std::ostream& out_;
+    std::ostream& err_;
+
+    /// Names defined by `logger --dictionary`, by ID
+    std::unordered_map<std::uint32_t, std::string> names_;
+};
+
+} // namespace logger
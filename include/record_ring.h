@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logger {
+
+/// Configures a RecordRing
+struct record_ring_options {
+    /// Records are appended to a chunk until it holds at least this many bytes
+    std::size_t chunk_size = 64 * 1024;
+
+    /// Number of chunks kept for readers that have not read them yet, at least 1
+    std::size_t capacity = 256;
+};
+
+/// A bounded ring of serialized records, read by any number of readers with their own cursor
+///
+/// Published records are appended, followed by a newline, to an open chunk. A chunk is sealed
+/// once it reaches the chunk size, or as soon as a reader is waiting for records, so that
+/// readers which keep up receive records without delay while readers which lag behind receive
+/// them in large chunks. Sealed chunks are immutable and reference counted, so a record is
+/// serialized once and every reader sends the same chunk without copying it.
+///
+/// Publishing never waits for readers. Once the ring is full, the oldest chunk is dropped and a
+/// reader still behind it skips ahead to the oldest chunk kept. Chunks always end with a whole
+/// record, so a reader which skips ahead still reads whole records.
+class RecordRing {
+  public:
+    /// A sealed chunk of records
+    using chunk = std::shared_ptr<const std::string>;
+
+    /// Position of a chunk, counted from the first chunk sealed
+    using sequence = std::uint64_t;
+
+    /// Invoked once a chunk is sealed after a reader found no chunk to read
+    using waiter = std::function<void()>;
+
+    explicit RecordRing(record_ring_options options = {});
+
+    RecordRing(const RecordRing&) = delete;
+    RecordRing& operator=(const RecordRing&) = delete;
+
+    /// @brief Appends a record, followed by a newline
+    /// @note Waiters are invoked on the calling thread, after the record is appended
+    auto publish(std::string_view record) -> void;
+
+    /// @brief Cursor of a reader which only reads records published from now on
+    auto end() -> sequence;
+
+    /// @brief Reads the chunks following a cursor
+    ///
+    /// A reader which reads up to the last chunk also seals and reads the open chunk.
+    ///
+    /// @param[in,out] cursor The sequence of the next chunk to read, advanced past the chunks read
+    /// @param[out] out Appended with the chunks read
+    /// @param max_chunks Largest number of chunks to read
+    /// @param on_ready If no chunk is read, invoked once a chunk has been sealed
+    /// @return The number of chunks skipped, as they were dropped before they were read
+    auto read(sequence& cursor, std::vector<chunk>& out, std::size_t max_chunks, waiter on_ready)
+        -> std::uint64_t;
+
+    /// @brief Number of chunks skipped by all readers, as they were dropped before they were read
+    auto skipped() const noexcept -> std::uint64_t {
+        return skipped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    /// @brief Moves the open chunk to the ring
+    /// @note Must be called with `mutex_` held and a non-empty open chunk
+    auto seal() -> void;
+
+    const record_ring_options options_;
+
+    std::mutex mutex_;
+
+    /// Sealed chunks, the first of which has sequence `begin_`
+    std::deque<chunk> chunks_;
+    sequence begin_ = 0;
+
+    /// Records not yet sealed
+    std::string open_;
+
+    /// Readers waiting for the next chunk
+    std::vector<waiter> waiters_;
+
+    std::atomic<std::uint64_t> skipped_{0};
+};
+
+} // namespace logger
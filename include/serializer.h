@@ -0,0 +1,73 @@
+#pragma once
+
+#include "message.h"
+#include "message_batch.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace reader {
+
+/// Layout of the JSON written by `write_json`
+enum class json_format {
+    /// A single line without whitespace, suitable for newline delimited JSON
+    compact,
+    /// Fields on separate lines, indented by four spaces
+    pretty,
+};
+
+/// @brief Appends a JSON representation of a message to a buffer
+/// @param out A buffer to append to
+/// @param message The message to write
+/// @param format The layout of the JSON object
+///
+/// Writes the message directly, without creating a `nlohmann::json` object. The output is
+/// identical to `as_json().dump()` for `json_format::compact` and to `as_json().dump(4)` for
+/// `json_format::pretty`. No trailing newline is written.
+///
+/// The message name is not validated again, as messages with a name that is not valid UTF-8 are
+/// rejected on decode.
+///
+/// @note Once `out` has sufficient capacity, this function does not allocate
+auto write_json(std::string& out, const MessageView& message, json_format format) -> void;
+
+/// @copydoc write_json(std::string&, const MessageView&, json_format)
+auto write_json(std::string& out, const Message& message, json_format format) -> void;
+
+/// @copydoc write_json(std::string&, const MessageView&, json_format)
+auto write_json(std::string& out, const MessageBatch::row& message, json_format format) -> void;
+
+/// @brief Appends a JSON representation of a message to a buffer, referring to its name by ID
+/// @param out A buffer to append to
+/// @param message The message to write
+/// @param name_id ID of the message name, defined by a record written with
+///        `write_name_definition`
+/// @param format The layout of the JSON object
+///
+/// Identical to `write_json(out, message, format)`, except that the `name` member is replaced
+/// by a `name_id` member holding `name_id`.
+auto write_json(std::string& out,
+                const MessageView& message,
+                std::uint32_t name_id,
+                json_format format) -> void;
+
+/// @copydoc write_json(std::string&, const MessageView&, std::uint32_t, json_format)
+auto write_json(std::string& out,
+                const MessageBatch::row& message,
+                std::uint32_t name_id,
+                json_format format) -> void;
+
+/// @brief Appends a JSON record defining the ID of a sensor name
+/// @param out A buffer to append to
+/// @param name_id ID of the name
+/// @param name The name, which must be valid UTF-8
+/// @param format The layout of the JSON object
+///
+/// Writes an object with the members `id` and `name`. No trailing newline is written.
+auto write_name_definition(std::string& out,
+                           std::uint32_t name_id,
+                           std::string_view name,
+                           json_format format) -> void;
+
+} // namespace reader
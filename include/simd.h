@@ -0,0 +1,48 @@
+#pragma once
+
+#include <initializer_list>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+/// Defined if vectorized kernels for x86-64 are compiled, selected at runtime with `simd_isa`
+#define RECORDER_SIMD_X86 1
+#endif
+
+namespace reader {
+
+/// Instruction set used by a vectorized kernel
+enum class simd_isa {
+    /// Portable implementation, processing one element at a time
+    scalar,
+    /// SSE4.1, processing 16 bytes at a time
+    sse4,
+    /// AVX2, processing 32 bytes at a time
+    avx2,
+};
+
+/// @brief Checks if an instruction set is supported by the running CPU
+inline auto supported(simd_isa isa) noexcept -> bool {
+    switch (isa) {
+    case simd_isa::scalar:
+        return true;
+#ifdef RECORDER_SIMD_X86
+    case simd_isa::sse4:
+        return __builtin_cpu_supports("sse4.1");
+    case simd_isa::avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/// @brief Finds the fastest instruction set supported by the running CPU
+inline auto best_simd_isa() noexcept -> simd_isa {
+    for (const auto isa : {simd_isa::avx2, simd_isa::sse4}) {
+        if (supported(isa)) {
+            return isa;
+        }
+    }
+    return simd_isa::scalar;
+}
+
+} // namespace reader
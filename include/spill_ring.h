@@ -0,0 +1,67 @@
+#pragma once
+
+#include "compat/asio.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+namespace reader {
+
+/// A bounded FIFO of bytes stored in a memory-mapped file
+///
+/// Data is appended at the back and consumed from the front, wrapping around at the end of the
+/// file. The file is mapped shared, so stored data is backed by the page cache and written to
+/// disk by the kernel instead of occupying process memory.
+///
+/// @note The file is truncated when a SpillRing is created. Stored data does not persist across
+///       restarts.
+class SpillRing {
+  public:
+    /// @brief Creates a spill file and maps it into memory
+    /// @param path Path of the file, which is created or truncated
+    /// @param capacity Maximum number of bytes stored
+    /// @throw std::system_error if the file cannot be created or mapped
+    SpillRing(const std::string& path, std::size_t capacity);
+
+    /// @brief Unmaps and closes the spill file
+    ~SpillRing();
+
+    SpillRing(const SpillRing&) = delete;
+    SpillRing& operator=(const SpillRing&) = delete;
+
+    auto capacity() const noexcept -> std::size_t { return capacity_; }
+    auto size() const noexcept -> std::size_t { return size_; }
+    auto empty() const noexcept -> bool { return size_ == 0; }
+
+    /// @brief Appends data to the back of the ring
+    /// @return false if there is not enough space, in which case nothing is appended
+    auto push(asio::const_buffer data) noexcept -> bool;
+
+    /// @brief Refers to data at the front of the ring
+    /// @param max Maximum number of bytes referred to
+    /// @return Up to two buffers, the second of which is empty unless the data wraps around
+    /// @note The buffers are valid until the referred data is popped
+    auto front(std::size_t max) const noexcept -> std::array<asio::const_buffer, 2>;
+
+    /// @brief Removes data from the front of the ring
+    /// @param n Number of bytes to remove, which must not exceed `size()`
+    auto pop(std::size_t n) noexcept -> void;
+
+  private:
+    /// File descriptor of the spill file
+    int fd_ = -1;
+
+    /// Start of the mapping
+    unsigned char* data_ = nullptr;
+
+    const std::size_t capacity_;
+
+    /// Offset of the front of the ring
+    std::size_t head_ = 0;
+
+    /// Number of bytes stored
+    std::size_t size_ = 0;
+};
+
+} // namespace reader
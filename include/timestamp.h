@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace reader {
+
+/// Maximum number of characters written by `format_timestamp`
+constexpr std::size_t max_timestamp_size = 64;
+
+/// @brief Formats a timestamp as an ISO 8601 date and time in the local timezone
+/// @param timestamp The timestamp to format
+/// @param out A buffer with space for at least `max_timestamp_size` characters
+/// @return A pointer past the last character written
+///
+/// Timestamps are formatted with millisecond precision and a UTC offset, e.g.
+/// `2020-06-28T16:51:50.240+0200`. The output is the same as formatting with `std::put_time` and
+/// `"%FT%T"` and `"%z"`.
+///
+/// The formatted date, time and UTC offset of the most recently formatted second are cached per
+/// thread, so formatting timestamps within the same second only writes the milliseconds. This
+/// function is thread-safe.
+///
+/// @note The output is not null terminated
+/// @note Changes to the local timezone are not applied to a second that is already cached
+auto format_timestamp(std::chrono::system_clock::time_point timestamp, char* out) -> char*;
+
+/// @brief Parses an ISO 8601 date and time, such as one written by `format_timestamp`
+/// @param s A date and time `YYYY-MM-DDTHH:MM:SS`, optionally followed by up to three digits of
+///        fractional seconds and a UTC offset `Z`, `+hhmm` or `+hh:mm`
+/// @return The timestamp, or std::nullopt if `s` is not in this format
+///
+/// A timestamp without a UTC offset is interpreted in the local timezone.
+auto parse_timestamp(std::string_view s) -> std::optional<std::chrono::system_clock::time_point>;
+
+} // namespace reader
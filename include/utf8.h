@@ -0,0 +1,24 @@
+#pragma once
+
+#include "simd.h"
+
+#include <string>
+#include <string_view>
+
+namespace reader {
+
+/// @brief Checks that a string is valid UTF-8
+///
+/// Uses the fastest implementation supported by the running CPU, selected on first use.
+auto is_valid_utf8(std::string_view s) noexcept -> bool;
+
+/// @brief Checks that a string is valid UTF-8 with a specific implementation
+/// @note `isa` must be supported by the running CPU
+auto is_valid_utf8(std::string_view s, simd_isa isa) noexcept -> bool;
+
+/// @brief Describes the first invalid byte of a string
+/// @return A description identical to the one used by `nlohmann::json::dump`, or an empty
+///         string if `s` is valid UTF-8
+auto describe_invalid_utf8(std::string_view s) -> std::string;
+
+} // namespace reader
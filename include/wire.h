@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace reader {
+
+/// Schema of the sensor data wire format, from which the message decoder and encoder are derived
+namespace wire {
+
+/// An unsigned integer of `Size` bytes, most significant byte first
+///
+/// Reads and writes are written byte by byte without branches, which compilers reduce to a
+/// single load or store and a byte swap.
+template <std::size_t Size>
+struct big_endian {
+    static_assert(Size > 0 && Size <= 8, "`Size` must fit in a 64-bit integer");
+
+    static constexpr std::size_t size = Size;
+
+    /// The smallest unsigned integer type holding `Size` bytes
+    using value_type = std::conditional_t<
+        (Size == 1),
+        std::uint8_t,
+        std::conditional_t<(Size <= 2),
+                           std::uint16_t,
+                           std::conditional_t<(Size <= 4), std::uint32_t, std::uint64_t>>>;
+
+    /// Largest value which can be encoded
+    static constexpr value_type max =
+        static_cast<value_type>(std::numeric_limits<std::uint64_t>::max() >> (64 - 8 * Size));
+
+    static constexpr auto read(const unsigned char* p) noexcept -> value_type {
+        auto value = std::uint64_t{0};
+        for (auto i = std::size_t{0}; i < Size; ++i) {
+            value = (value << 8) | p[i];
+        }
+        return static_cast<value_type>(value);
+    }
+
+    /// @note Bits of `value` above `Size` bytes are not written
+    static constexpr auto write(value_type value, unsigned char* p) noexcept -> unsigned char* {
+        for (auto i = std::size_t{0}; i < Size; ++i) {
+            p[Size - 1 - i] = static_cast<unsigned char>(std::uint64_t{value} >> (8 * i));
+        }
+        return p + Size;
+    }
+};
+
+/// A sequence of bytes prefixed with its size
+template <class Size>
+struct length_prefixed {
+    using size_type = Size;
+
+    /// Largest number of bytes which can be encoded
+    static constexpr std::size_t max_size = Size::max;
+
+    static constexpr auto read_size(const unsigned char* p) noexcept -> std::size_t {
+        return Size::read(p);
+    }
+
+    /// @note `value` must have at most `max_size` bytes
+    static auto write(std::string_view value, unsigned char* p) noexcept -> unsigned char* {
+        p = Size::write(static_cast<typename Size::value_type>(value.size()), p);
+        std::memcpy(p, value.data(), value.size());
+        return p + value.size();
+    }
+};
+
+namespace detail {
+
+/// Marks a size which does not match any combination of trailing fields
+constexpr auto no_mask = std::numeric_limits<std::uint8_t>::max();
+
+/// @brief Computes the offset of each trailing field, and their total size, for each combination
+///        of fields
+template <std::size_t N>
+constexpr auto trailing_offsets(const std::array<std::size_t, N>& sizes) {
+    auto offsets = std::array<std::array<std::size_t, N + 1>, (std::size_t{1} << N)>{};
+    for (auto mask = std::size_t{0}; mask < offsets.size(); ++mask) {
+        auto offset = std::size_t{0};
+        for (auto i = std::size_t{0}; i < N; ++i) {
+            offsets[mask][i] = offset;
+            offset += ((mask >> i) & 1) ? sizes[i] : 0;
+        }
+        offsets[mask][N] = offset;
+    }
+    return offsets;
+}
+
+/// @brief Computes the combination of trailing fields of each size
+template <std::size_t MaxSize, class Offsets>
+constexpr auto trailing_masks(const Offsets& offsets) {
+    auto masks = std::array<std::uint8_t, MaxSize + 1>{};
+    for (auto& mask : masks) {
+        mask = no_mask;
+    }
+    for (auto mask = std::size_t{0}; mask < offsets.size(); ++mask) {
+        masks[offsets[mask].back()] = static_cast<std::uint8_t>(mask);
+    }
+    return masks;
+}
+
+/// @brief Checks that every combination of trailing fields has a distinct size
+template <class Masks>
+constexpr auto unambiguous(const Masks& masks, std::size_t combinations) {
+    auto found = std::size_t{0};
+    for (const auto mask : masks) {
+        found += (mask != no_mask) ? 1 : 0;
+    }
+    return found == combinations;
+}
+
+} // namespace detail
+
+/// Optional fields at the end of a message, whose presence is determined by the number of bytes
+/// remaining
+///
+/// Fields appear in order but any of them may be omitted. The sizes of all combinations of fields
+/// must differ, so that the number of remaining bytes identifies the fields present. A field is
+/// identified by its position in `Fields`, and a combination of fields by a mask with bit `i` set
+/// if field `i` is present.
+template <class... Fields>
+class trailing {
+  public:
+    static constexpr std::size_t count = sizeof...(Fields);
+    static_assert(count < 8, "presence masks are stored in a byte");
+
+    using mask_type = std::uint8_t;
+
+    /// Size of the fields, indexed by position
+    static constexpr std::array<std::size_t, count> sizes = {Fields::size...};
+
+    /// Size of all fields
+    static constexpr std::size_t max_size = (Fields::size + ... + 0);
+
+    /// @brief Finds the fields present in `size` bytes
+    /// @return The mask of present fields, or std::nullopt if no combination of fields has
+    ///         exactly `size` bytes
+    static constexpr auto present(std::size_t size) noexcept -> std::optional<mask_type> {
+        if (size > max_size || masks_[size] == detail::no_mask) {
+            return std::nullopt;
+        }
+        return masks_[size];
+    }
+
+    /// @brief Offset of field `I` from the start of the trailing fields
+    /// @param mask The fields present
+    template <std::size_t I>
+    static constexpr auto offset(mask_type mask) noexcept -> std::size_t {
+        return offsets_[mask][I];
+    }
+
+    /// @brief Size of the present fields
+    static constexpr auto size(mask_type mask) noexcept -> std::size_t {
+        return offsets_[mask][count];
+    }
+
+  private:
+    static constexpr auto offsets_ = detail::trailing_offsets(sizes);
+    static constexpr auto masks_ = detail::trailing_masks<max_size>(offsets_);
+
+    static_assert(detail::unambiguous(masks_, offsets_.size()),
+                  "each combination of trailing fields must have a distinct size");
+};
+
+/// Layout of a message frame
+///
+/// A frame is a message length header followed by the message payload:
+/// - timestamp: milliseconds since the epoch
+/// - name: UTF-8, prefixed with its size
+/// - temperature (optional): hundredths of K
+/// - humidity (optional): tenths of a percent relative humidity
+struct message_schema {
+    /// Size of the frame, including the header
+    using length = big_endian<4>;
+
+    using timestamp = big_endian<8>;
+    using name = length_prefixed<big_endian<1>>;
+    using temperature = big_endian<3>;
+    using humidity = big_endian<2>;
+
+    using trailing_fields = trailing<temperature, humidity>;
+    static constexpr std::size_t temperature_field = 0;
+    static constexpr std::size_t humidity_field = 1;
+
+    /// Offset of the name size from the start of the payload
+    static constexpr std::size_t name_offset = timestamp::size;
+
+    /// Offset of the name from the start of the payload
+    static constexpr std::size_t name_data_offset = name_offset + name::size_type::size;
+
+    /// Smallest possible payload, with an empty name and no optional fields
+    static constexpr std::size_t min_payload = name_data_offset;
+
+    /// Largest possible payload
+    static constexpr std::size_t max_payload =
+        name_data_offset + name::max_size + trailing_fields::max_size;
+};
+
+/// The layout of a valid payload
+struct message_layout {
+    /// Size of the name
+    std::uint8_t name_size = 0;
+
+    /// Trailing fields present
+    message_schema::trailing_fields::mask_type present = 0;
+};
+
+/// Result of validating a payload layout
+enum class layout_error {
+    /// The payload is smaller than `message_schema::min_payload`
+    too_small,
+    /// The name size results in overrun of the payload
+    name_overrun,
+    /// The bytes after the name do not match any combination of trailing fields
+    unused_bytes,
+};
+
+/// @brief Determines the layout of a payload
+/// @param data The payload, without the message length header
+/// @param size Size of the payload
+/// @param[out] layout Set to the layout of the payload if it is valid
+/// @return std::nullopt if the payload is valid, or the reason it is not
+inline auto validate(const unsigned char* data, std::size_t size, message_layout& layout) noexcept
+    -> std::optional<layout_error> {
+    using schema = message_schema;
+
+    if (size < schema::min_payload) {
+        return layout_error::too_small;
+    }
+
+    const auto name_size = schema::name::read_size(data + schema::name_offset);
+    const auto remaining = size - schema::min_payload;
+    if (remaining < name_size) {
+        return layout_error::name_overrun;
+    }
+
+    const auto present = schema::trailing_fields::present(remaining - name_size);
+    if (!present) {
+        return layout_error::unused_bytes;
+    }
+
+    layout.name_size = static_cast<std::uint8_t>(name_size);
+    layout.present = *present;
+    return std::nullopt;
+}
+
+/// Fields of a message in wire units
+struct message_fields {
+    /// Milliseconds since the epoch
+    std::uint64_t timestamp = 0;
+
+    /// Name of the sensor, which is truncated to `message_schema::name::max_size` bytes
+    std::string_view name;
+
+    /// Hundredths of K, of which the lower 3 bytes are encoded
+    std::optional<std::uint32_t> temperature;
+
+    /// Tenths of a percent relative humidity
+    std::optional<std::uint16_t> humidity;
+};
+
+/// @brief Size of the payload encoding `fields`
+constexpr auto payload_size(const message_fields& fields) noexcept -> std::size_t {
+    using schema = message_schema;
+    return schema::name_data_offset + std::min(fields.name.size(), schema::name::max_size) +
+           (fields.temperature ? schema::temperature::size : 0) +
+           (fields.humidity ? schema::humidity::size : 0);
+}
+
+/// @brief Encodes a message payload, without the message length header
+/// @param fields The fields to encode
+/// @param out A buffer with space for at least `payload_size(fields)` bytes
+/// @return A pointer past the last byte written
+inline auto encode(const message_fields& fields, unsigned char* out) noexcept -> unsigned char* {
+    using schema = message_schema;
+
+    out = schema::timestamp::write(fields.timestamp, out);
+    out = schema::name::write(fields.name.substr(0, schema::name::max_size), out);
+    if (fields.temperature) {
+        out = schema::temperature::write(*fields.temperature, out);
+    }
+    if (fields.humidity) {
+        out = schema::humidity::write(*fields.humidity, out);
+    }
+    return out;
+}
+
+/// @brief Encodes a message frame, consisting of the message length header and the payload
+/// @param fields The fields to encode
+/// @param out A buffer with space for at least `message_schema::length::size +
+///        payload_size(fields)` bytes
+/// @return A pointer past the last byte written
+inline auto encode_frame(const message_fields& fields, unsigned char* out) noexcept
+    -> unsigned char* {
+    using schema = message_schema;
+
+    const auto length = schema::length::size + payload_size(fields);
+    out = schema::length::write(static_cast<schema::length::value_type>(length), out);
+    return encode(fields, out);
+}
+
+} // namespace wire
+} // namespace reader
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "index.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace logger {
+
+/// Writes records to an output stream from a dedicated thread
+///
+/// Records are appended to a front buffer by the producer. The writer thread swaps the front
+/// buffer with a back buffer and writes the back buffer to the output stream once the front buffer
+/// exceeds a size threshold or once a time threshold elapses, whichever comes first. A producer
+/// never waits on I/O; it only contends with the writer thread for the duration of a buffer swap.
+///
+/// Both buffers retain their capacity after a swap, so steady-state operation does not allocate.
+/// If the output stream cannot keep up, the front buffer grows until the back buffer has been
+/// written.
+///
+/// When constructed with an IndexBuilder, records written with a `record_info` are added to the
+/// index as they are appended, and the index is written to its own stream after the records it
+/// refers to. Offsets in the index are relative to the first byte written by the Writer.
+class Writer {
+  public:
+    static constexpr std::size_t default_flush_size = 64 * 1024;
+    static constexpr auto default_flush_interval = std::chrono::milliseconds{100};
+
+    /// @brief Creates a Writer and starts the writer thread
+    /// @param out An ostream to write records to
+    /// @param flush_size Number of buffered bytes which triggers a write
+    /// @param flush_interval Maximum time a record is buffered before it is written
+    /// @note `out` must be guaranteed to exist for the lifetime of the Writer
+    explicit Writer(std::ostream& out,
+                    std::size_t flush_size = default_flush_size,
+                    std::chrono::milliseconds flush_interval = default_flush_interval);
+
+    /// @brief Creates a Writer which indexes records and starts the writer thread
+    /// @param out An ostream to write records to
+    /// @param index_out An ostream to write the index to
+    /// @param index Builds the index of the records
+    /// @param flush_size Number of buffered bytes which triggers a write
+    /// @param flush_interval Maximum time a record is buffered before it is written
+    /// @note `out`, `index_out` and `index` must be guaranteed to exist for the lifetime of the
+    ///       Writer
+    Writer(std::ostream& out,
+           std::ostream& index_out,
+           IndexBuilder& index,
+           std::size_t flush_size = default_flush_size,
+           std::chrono::milliseconds flush_interval = default_flush_interval);
+
+    /// @brief Writes any buffered records and stops the writer thread
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    /// @brief Appends a record, followed by a newline, to the front buffer
+    auto write(std::string_view record) -> void;
+
+    /// @brief Appends a record, followed by a newline, to the front buffer and indexes it
+    /// @param record The record to write
+    /// @param info Sensor name and timestamp of the record, added to the index if there is one
+    auto write(std::string_view record, const record_info& info) -> void;
+
+    /// @brief Appends data verbatim to the front buffer
+    /// @note Unlike `write`, no newline is appended
+    auto append(std::string_view data) -> void;
+
+    /// @brief Blocks until all records appended before this call have been written
+    auto flush() -> void;
+
+    /// @brief Number of bytes appended but not yet handed to the writer thread
+    /// @note May be called from any thread
+    auto queued() const noexcept -> std::size_t { return queued_.load(std::memory_order_relaxed); }
+
+  private:
+    /// @brief Appends a record, followed by a newline, and indexes it if `info` is set
+    auto write_record(std::string_view record, const record_info* info) -> void;
+
+    /// @brief Checks if the last append caused the front buffer to reach the size threshold
+    /// @param appended Number of bytes appended
+    /// @note Must be called with `mutex_` held
+    auto crossed_threshold(std::size_t appended) const noexcept -> bool;
+
+    /// @brief Writer thread loop
+    auto run() -> void;
+
+    /// Output stream to write records to
+    std::ostream& out_;
+
+    /// Output stream to write the index to, if indexing
+    std::ostream* index_out_ = nullptr;
+
+    /// Builds the index of the records, if indexing
+    IndexBuilder* index_ = nullptr;
+
+    /// Number of bytes appended since the Writer was created
+    std::uint64_t appended_ = 0;
+
+    /// Index entries written by the writer thread
+    std::string index_back_;
+
+    /// Number of buffered bytes which triggers a write
+    const std::size_t flush_size_;
+
+    /// Maximum time a record is buffered before it is written
+    const std::chrono::milliseconds flush_interval_;
+
+    /// Guards the front buffer and the flush state
+    std::mutex mutex_;
+
+    /// Signals the writer thread that a write is requested
+    std::condition_variable write_requested_;
+
+    /// Signals waiting producers that a flush has completed
+    std::condition_variable flush_completed_;
+
+    /// Buffer appended to by the producer
+    std::string front_;
+
+    /// Buffer written to the output stream by the writer thread
+    std::string back_;
+
+    /// Size of the front buffer, readable without holding `mutex_`
+    std::atomic<std::size_t> queued_{0};
+
+    /// Number of flushes requested with `flush()`
+    std::uint64_t flushes_requested_ = 0;
+
+    /// Number of requested flushes which have completed
+    std::uint64_t flushes_completed_ = 0;
+
+    /// Set when the Writer is destroyed
+    bool stop_ = false;
+
+    /// Thread writing the back buffer
+    std::thread thread_;
+};
+
+} // namespace logger
@@ -0,0 +1,244 @@
+#include "aggregator.h"
+
+#include "timestamp.h"
+
+#include <algorithm>
+#include <charconv>
+#include <nlohmann/json.hpp>
+#include <utility>
+
+namespace logger {
+
+namespace {
+
+/// Units accepted by `parse_duration`, from largest to smallest
+constexpr std::array<std::pair<std::string_view, std::int64_t>, 4> duration_units = {{
+    {"h", 60 * 60 * 1000},
+    {"m", 60 * 1000},
+    {"s", 1000},
+    {"ms", 1},
+}};
+
+/// Rounds a division towards negative infinity, so that windows before the epoch are aligned
+auto floor_div(std::int64_t a, std::int64_t b) noexcept -> std::int64_t {
+    const auto q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+/// @brief Converts milliseconds since the epoch to a time point, saturating at the whole seconds
+///        within the range of the system clock, so that the time point can be formatted
+auto to_time_point(std::int64_t ms) noexcept -> Aggregator::time_point_t {
+    using std::chrono::seconds;
+    using time_point_t = Aggregator::time_point_t;
+    const auto min = std::chrono::ceil<seconds>(time_point_t::min().time_since_epoch());
+    const auto max = std::chrono::floor<seconds>(time_point_t::max().time_since_epoch());
+    return time_point_t{std::clamp(std::chrono::milliseconds{ms},
+                                   std::chrono::milliseconds{min},
+                                   std::chrono::milliseconds{max})};
+}
+
+auto make_window(std::int64_t index) -> window_rollup {
+    auto window = window_rollup{};
+    window.index = index;
+    return window;
+}
+
+auto to_json(const field_rollup& field) -> nlohmann::json {
+    return {{"count", field.count},
+            {"min", field.min},
+            {"max", field.max},
+            {"mean", field.sum / field.count}};
+}
+
+} // namespace
+
+Aggregator::Aggregator(aggregator_options options, sink_type sink)
+    : options_{std::move(options)}, sink_{std::move(sink)} {
+    for (const auto width : options_.windows) {
+        widths_.push_back(width.count());
+        labels_.push_back(format_duration(width));
+    }
+}
+
+auto Aggregator::add(std::string_view name,
+                     time_point_t timestamp,
+                     std::optional<float> temperature,
+                     std::optional<float> humidity) -> void {
+    const auto t =
+        std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch())
+            .count();
+
+    // Keeps window arithmetic on the timestamp from overflowing, if the system clock has a
+    // duration coarse enough to represent timestamps beyond it
+    if (t < -max_duration.count() || t > max_duration.count()) {
+        late_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& sh = shards_[std::hash<std::string_view>{}(name) % shard_count];
+    const auto lock = std::lock_guard<std::mutex>{sh.mutex};
+
+    auto it = sh.sensors.find(name);
+    if (it == sh.sensors.end()) {
+        auto stored = sh.names.emplace(sh.names.end(), name);
+        it = sh.sensors.emplace(*stored, sensor{}).first;
+        it->second.windows.resize(widths_.size());
+        it->second.name = stored;
+    }
+    auto& s = it->second;
+
+    if (t < s.watermark) {
+        late_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    s.active = true;
+
+    const auto watermark = t - options_.lateness.count();
+    if (watermark > s.watermark) {
+        s.watermark = watermark;
+        close(it->first, s, watermark);
+    }
+
+    for (auto i = std::size_t{0}; i < widths_.size(); ++i) {
+        auto& open = s.windows[i];
+        const auto index = floor_div(t, widths_[i]);
+
+        // Open windows are kept contiguous so that a window is found by its offset from the
+        // first. Only windows after the watermark are open, which bounds the number added here.
+        if (open.empty()) {
+            open.push_back(make_window(index));
+        }
+        while (index < open.front().index) {
+            open.push_front(make_window(open.front().index - 1));
+        }
+        while (index > open.back().index) {
+            open.push_back(make_window(open.back().index + 1));
+        }
+
+        auto& window = open[static_cast<std::size_t>(index - open.front().index)];
+        ++window.count;
+        if (temperature) {
+            window.temperature.add(*temperature);
+        }
+        if (humidity) {
+            window.humidity.add(*humidity);
+        }
+    }
+}
+
+auto Aggregator::expire() -> void {
+    for (auto& sh : shards_) {
+        const auto lock = std::lock_guard<std::mutex>{sh.mutex};
+        for (auto it = sh.sensors.begin(); it != sh.sensors.end();) {
+            auto& [name, s] = *it;
+            if (!s.active) {
+                const auto closed = std::all_of(s.windows.cbegin(), s.windows.cend(),
+                                                [](const auto& open) { return open.empty(); });
+
+                // The sensor stayed idle since its windows were closed by the previous call
+                if (closed) {
+                    const auto stored = s.name;
+                    it = sh.sensors.erase(it);
+                    sh.names.erase(stored);
+                    continue;
+                }
+
+                auto end = s.watermark;
+                for (auto i = std::size_t{0}; i < widths_.size(); ++i) {
+                    if (!s.windows[i].empty()) {
+                        end = std::max(end, (s.windows[i].back().index + 1) * widths_[i]);
+                    }
+                }
+                s.watermark = end;
+                close(name, s, end);
+            }
+            s.active = false;
+            ++it;
+        }
+    }
+}
+
+auto Aggregator::flush() -> void {
+    for (auto& sh : shards_) {
+        const auto lock = std::lock_guard<std::mutex>{sh.mutex};
+        for (auto& [name, s] : sh.sensors) {
+            s.active = false;
+        }
+    }
+    expire();
+}
+
+auto Aggregator::sensors() const -> std::size_t {
+    auto count = std::size_t{0};
+    for (const auto& sh : shards_) {
+        const auto lock = std::lock_guard<std::mutex>{sh.mutex};
+        count += sh.sensors.size();
+    }
+    return count;
+}
+
+auto Aggregator::close(std::string_view name, sensor& s, std::int64_t watermark) -> void {
+    for (auto i = std::size_t{0}; i < widths_.size(); ++i) {
+        auto& open = s.windows[i];
+        while (!open.empty() && (open.front().index + 1) * widths_[i] <= watermark) {
+            if (open.front().count > 0) {
+                emit(name, i, open.front());
+            }
+            open.pop_front();
+        }
+    }
+}
+
+auto Aggregator::emit(std::string_view name, std::size_t width, const window_rollup& window)
+    -> void {
+    auto start = std::array<char, reader::max_timestamp_size>{};
+    const auto start_end =
+        reader::format_timestamp(to_time_point(window.index * widths_[width]), start.data());
+
+    auto rollup = nlohmann::json{{"name", name},
+                                 {"window", labels_[width]},
+                                 {"start", std::string_view{start.data(),
+                                                            static_cast<std::size_t>(
+                                                                start_end - start.data())}},
+                                 {"count", window.count}};
+    if (window.temperature.count > 0) {
+        rollup["temperature"] = to_json(window.temperature);
+    }
+    if (window.humidity.count > 0) {
+        rollup["humidity"] = to_json(window.humidity);
+    }
+
+    sink_(options_.format == reader::json_format::pretty ? rollup.dump(4) : rollup.dump());
+    written_.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto parse_duration(std::string_view s) -> std::optional<std::chrono::milliseconds> {
+    auto value = std::int64_t{};
+    const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (ec != std::errc{} || value <= 0) {
+        return std::nullopt;
+    }
+
+    const auto unit = s.substr(static_cast<std::size_t>(end - s.data()));
+    for (const auto& [suffix, ms] : duration_units) {
+        if (unit == suffix) {
+            if (value > max_duration.count() / ms) {
+                return std::nullopt;
+            }
+            return std::chrono::milliseconds{value * ms};
+        }
+    }
+    return std::nullopt;
+}
+
+auto format_duration(std::chrono::milliseconds duration) -> std::string {
+    const auto ms = duration.count();
+    for (const auto& [suffix, unit] : duration_units) {
+        if (ms % unit == 0) {
+            return std::to_string(ms / unit).append(suffix);
+        }
+    }
+    return std::to_string(ms).append("ms");
+}
+
+} // namespace logger
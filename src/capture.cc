@@ -0,0 +1,64 @@
+#include "capture.h"
+
+#include "compat/endian.h"
+
+#include <cstring>
+
+namespace logger {
+
+auto encode_segment_header(std::string& out, const segment_header& header) -> void {
+    const auto endpoint = header.endpoint.substr(0, std::numeric_limits<uint8_t>::max());
+
+    const auto receive_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        header.receive_time.time_since_epoch());
+
+    const auto receive_time = htobe64(static_cast<uint64_t>(receive_time_ms.count()));
+    const auto payload_length = htobe32(header.payload_length);
+
+    out.append(segment_magic);
+    out.append(reinterpret_cast<const char*>(&receive_time), capture_size::receive_time);
+    out.append(reinterpret_cast<const char*>(&payload_length), capture_size::payload_length);
+    out.push_back(static_cast<char>(endpoint.size()));
+    out.append(endpoint);
+}
+
+auto decode_segment_header_size(asio::const_buffer header_data) -> uint32_t {
+    if (header_data.size() != capture_size::fixed_header) {
+        throw bad_capture_data{"`header_data` size does not match segment header size."};
+    }
+
+    const auto bytes = static_cast<const unsigned char*>(header_data.data());
+    if (std::memcmp(bytes, segment_magic.data(), capture_size::magic) != 0) {
+        throw bad_capture_data{"`header_data` does not start a capture segment."};
+    }
+
+    return capture_size::fixed_header + bytes[capture_size::fixed_header - 1];
+}
+
+auto decode_segment_header(asio::const_buffer header_data) -> segment_header {
+    if (header_data.size() < capture_size::fixed_header ||
+        header_data.size() !=
+            decode_segment_header_size(asio::buffer(header_data, capture_size::fixed_header))) {
+        throw bad_capture_data{"`header_data` size does not match segment header size."};
+    }
+
+    const auto bytes = static_cast<const unsigned char*>(header_data.data());
+
+    auto receive_time = uint64_t{};
+    std::memcpy(&receive_time, bytes + capture_size::magic, capture_size::receive_time);
+
+    auto payload_length = uint32_t{};
+    std::memcpy(&payload_length,
+                bytes + capture_size::magic + capture_size::receive_time,
+                capture_size::payload_length);
+
+    return {
+        {reinterpret_cast<const char*>(bytes + capture_size::fixed_header),
+         header_data.size() - capture_size::fixed_header},
+        segment_header::time_point_t{
+            std::chrono::milliseconds{static_cast<int64_t>(be64toh(receive_time))}},
+        be32toh(payload_length),
+    };
+}
+
+} // namespace logger
@@ -0,0 +1,237 @@
+#include "client.h"
+
+#include "compat/endian.h"
+#include "message.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace reader {
+
+using asio::ip::tcp;
+
+Client::Client(tcp::socket socket,
+               asio::posix::stream_descriptor istream,
+               tcp::resolver::results_type endpoints,
+               std::unique_ptr<SpillRing> spill)
+    : socket_{std::move(socket)},
+      istream_{std::move(istream)},
+      endpoints_{std::move(endpoints)},
+      reconnect_timer_{socket_.get_executor()},
+      spill_{std::move(spill)} {
+    for (auto& buffer : buffers_) {
+        buffer.resize(buffer_size);
+    }
+    async_read_data();
+}
+
+auto Client::async_write_data() -> void {
+    if (!connected_ || writing_ > 0 || spill_writing_ > 0) {
+        return;
+    }
+
+    if (spill_ && !spill_->empty()) {
+        // Only whole chunks are written, so that a write ends on a message boundary and a
+        // reconnected log server never receives a partial message
+        auto size = spill_chunks_.front();
+        for (auto i = std::size_t{1};
+             i < spill_chunks_.size() && size + spill_chunks_[i] <= spill_write_size;
+             ++i) {
+            size += spill_chunks_[i];
+        }
+        const auto buffers = spill_->front(size);
+        spill_writing_ = size;
+
+        asio::async_write(socket_, buffers, [this](std::error_code ec, std::size_t) {
+            if (ec) {
+                connection_lost(ec);
+                return;
+            }
+
+            spill_->pop(spill_writing_);
+            for (auto popped = std::size_t{0}; popped < spill_writing_;) {
+                popped += spill_chunks_.front();
+                spill_chunks_.pop_front();
+            }
+            spill_writing_ = 0;
+
+            // Seal data read while the write was in progress
+            forward(true);
+        });
+        return;
+    }
+
+    if (sealed_ == 0) {
+        return;
+    }
+
+    auto buffers = std::vector<asio::const_buffer>{};
+    for (auto i = std::size_t{}; i < sealed_; ++i) {
+        const auto index = (begin_ + i) % ring_size;
+        buffers.push_back(asio::buffer(buffers_[index].data(), sizes_[index]));
+    }
+    writing_ = sealed_;
+
+    asio::async_write(socket_, buffers, [this](std::error_code ec, std::size_t) {
+        if (ec) {
+            connection_lost(ec);
+            return;
+        }
+
+        // Release the written buffers
+        begin_ = (begin_ + writing_) % ring_size;
+        sealed_ -= writing_;
+        writing_ = 0;
+
+        // Seal data read while the write was in progress. This also seals a full buffer which
+        // could not be sealed while every other buffer was waiting to be sent.
+        forward(true);
+    });
+}
+
+auto Client::async_read_data() -> void {
+    if (reading_ || input_closed_ || fill_ == buffer_size || sealed_ == ring_size) {
+        // Resumed once a write releases a buffer
+        return;
+    }
+
+    reading_ = true;
+    istream_.async_read_some(
+        asio::buffer(buffers_[current()].data() + fill_, buffer_size - fill_),
+        [this](std::error_code ec, std::size_t bytes_transferred) {
+            reading_ = false;
+
+            if (ec) {
+                // Send any remaining data, including a partial message
+                input_closed_ = true;
+                forward(true);
+                return;
+            }
+            fill_ += bytes_transferred;
+
+            // Data is sent immediately if the socket is idle, otherwise it is batched
+            forward(writing_ == 0 || fill_ == buffer_size);
+        });
+}
+
+auto Client::forward(bool seal_current) -> void {
+    if (seal_current) {
+        spill_pending();
+        seal(input_closed_);
+    }
+    spill_pending();
+
+    async_write_data();
+    async_read_data();
+}
+
+auto Client::spill_pending() -> void {
+    const auto pending = sealed_ - writing_;
+    if (!spill_ || pending == 0) {
+        return;
+    }
+
+    if (connected_ && spill_->empty() && spill_writing_ == 0 && sealed_ + 1 < ring_size) {
+        return;
+    }
+
+    for (auto i = writing_; i < sealed_; ++i) {
+        const auto index = (begin_ + i) % ring_size;
+        const auto data = asio::buffer(buffers_[index].data(), sizes_[index]);
+
+        if (spill_->push(data)) {
+            spill_chunks_.push_back(data.size());
+            dropping_ = false;
+        } else {
+            if (!dropping_) {
+                std::cerr << "Spill file is full. Dropping data until space is available.\n";
+            }
+            dropping_ = true;
+        }
+    }
+
+    // Move the partial message to the new current buffer
+    const auto from = current();
+    sealed_ = writing_;
+    std::memmove(buffers_[current()].data(), buffers_[from].data(), fill_);
+}
+
+auto Client::connection_lost(const std::error_code& ec) -> void {
+    std::cerr << "Lost connection to log server: " << ec.message() << "\n";
+
+    auto ignored = asio::error_code{};
+    socket_.close(ignored);
+
+    connected_ = false;
+    writing_ = 0;
+    spill_writing_ = 0;
+
+    forward(false);
+    async_reconnect();
+}
+
+auto Client::async_reconnect() -> void {
+    reconnect_timer_.expires_after(backoff_);
+    reconnect_timer_.async_wait([this](std::error_code ec) {
+        if (ec) {
+            return;
+        }
+
+        asio::async_connect(
+            socket_, endpoints_, [this](std::error_code connect_ec, const tcp::endpoint&) {
+                if (connect_ec) {
+                    backoff_ = std::min(backoff_ * 2, max_backoff);
+                    async_reconnect();
+                    return;
+                }
+
+                std::cerr << "Reconnected to log server\n";
+                connected_ = true;
+                backoff_ = initial_backoff;
+                forward(false);
+            });
+    });
+}
+
+auto Client::seal(bool all) -> void {
+    const auto index = current();
+    const auto size = all ? fill_ : complete_frames_size(buffers_[index].data(), fill_);
+
+    if (size == 0 || (size < fill_ && sealed_ + 1 == ring_size)) {
+        return;
+    }
+
+    const auto next = (index + 1) % ring_size;
+    std::memcpy(buffers_[next].data(), buffers_[index].data() + size, fill_ - size);
+
+    sizes_[index] = size;
+    fill_ -= size;
+    ++sealed_;
+}
+
+auto complete_frames_size(const unsigned char* data, std::size_t size) noexcept -> std::size_t {
+    constexpr auto header_length = wire_size::message_length;
+
+    auto offset = std::size_t{};
+    while (size - offset >= header_length) {
+        auto message_length = uint32_t{};
+        std::memcpy(&message_length, data + offset, header_length);
+        message_length = be32toh(message_length);
+
+        if (message_length < header_length ||
+            message_length - header_length > wire_size::max_payload) {
+            return size;
+        }
+
+        if (size - offset < message_length) {
+            break;
+        }
+        offset += message_length;
+    }
+
+    return offset;
+}
+
+} // namespace reader
@@ -0,0 +1,149 @@
+#include "capture.h"
+#include "compat/asio.h"
+#include "message.h"
+#include "serializer.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+/// Converts a capture written by `logger --raw` to JSON records
+class Decoder {
+  public:
+    Decoder(std::istream& in, std::ostream& out, std::ostream& err, reader::json_format format)
+        : in_{in}, out_{out}, err_{err}, format_{format} {}
+
+    /// @brief Decodes all segments in the input stream
+    /// @return false if the capture is truncated or malformed
+    auto run() -> bool {
+        while (in_.peek() != std::char_traits<char>::eof()) {
+            header_.resize(logger::capture_size::fixed_header);
+            if (!read(header_, 0)) {
+                err_ << "Unable to decode capture: segment header is truncated.\n";
+                return false;
+            }
+
+            try {
+                header_.resize(logger::decode_segment_header_size(asio::buffer(header_)));
+                if (!read(header_, logger::capture_size::fixed_header)) {
+                    err_ << "Unable to decode capture: segment header is truncated.\n";
+                    return false;
+                }
+
+                const auto header = logger::decode_segment_header(asio::buffer(header_));
+                payload_.resize(header.payload_length);
+                if (!read(payload_, 0)) {
+                    err_ << "Unable to decode capture: segment payload is truncated.\n";
+                    return false;
+                }
+
+                display_frames(header.endpoint);
+            } catch (const logger::bad_capture_data& ex) {
+                err_ << "Unable to decode capture: " << ex.what() << "\n";
+                return false;
+            }
+        }
+
+        out_.flush();
+        return true;
+    }
+
+  private:
+    /// @brief Fills `buffer` from the input stream, starting at `offset`
+    /// @return false if the input stream ends before `buffer` is filled
+    auto read(std::vector<char>& buffer, std::size_t offset) -> bool {
+        const auto size = static_cast<std::streamsize>(buffer.size() - offset);
+        return static_cast<bool>(in_.read(buffer.data() + offset, size));
+    }
+
+    /// @brief Writes each message of the current segment payload as JSON
+    auto display_frames(std::string_view endpoint) -> void {
+        constexpr auto header_length = reader::wire_size::message_length;
+
+        auto frames = asio::const_buffer{asio::buffer(payload_)};
+        while (frames.size() > 0) {
+            try {
+                if (frames.size() < header_length) {
+                    throw reader::bad_message_data{"message length is truncated."};
+                }
+
+                const auto payload_length =
+                    reader::decode_message_payload_length(asio::buffer(frames, header_length));
+                if (frames.size() - header_length < payload_length) {
+                    throw reader::bad_message_data{"message is truncated."};
+                }
+
+                // Advance past the message first, as a name that is not valid UTF-8 only skips
+                // this message
+                const auto payload = asio::buffer(frames + header_length, payload_length);
+                frames += header_length + payload_length;
+
+                const auto message = reader::MessageView{payload};
+
+                record_.clear();
+                reader::write_json(record_, message, format_);
+                out_ << record_ << '\n';
+            } catch (const reader::bad_string_data& ex) {
+                err_ << "[" << endpoint << "] Unable to decode string: " << ex.what() << "\n";
+            } catch (const reader::bad_message_data& ex) {
+                // Message boundaries are lost for the rest of the segment
+                err_ << "[" << endpoint << "] Unable to decode message: " << ex.what() << "\n";
+                return;
+            }
+        }
+    }
+
+    std::istream& in_;
+    std::ostream& out_;
+    std::ostream& err_;
+    const reader::json_format format_;
+
+    /// Current segment header
+    std::vector<char> header_;
+
+    /// Current segment payload
+    std::vector<char> payload_;
+
+    /// Reused buffer for formatting records
+    std::string record_;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    constexpr auto usage = "usage: decoder [--ndjson] [<capture>]\n";
+
+    auto format = reader::json_format::pretty;
+    auto args = std::vector<const char*>{};
+    for (auto i = 1; i < argc; ++i) {
+        const auto arg = std::string_view{argv[i]};
+        if (arg == "--ndjson") {
+            format = reader::json_format::compact;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() > 1) {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    std::ios_base::sync_with_stdio(false);
+
+    auto file = std::ifstream{};
+    if (!args.empty()) {
+        file.open(args[0], std::ios::binary);
+        if (!file) {
+            std::cerr << "Unable to open " << args[0] << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto& in = args.empty() ? std::cin : file;
+    return Decoder{in, std::cout, std::cerr, format}.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
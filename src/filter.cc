@@ -0,0 +1,547 @@
+#include "filter.h"
+
+#include "message_batch.h"
+#include "timestamp.h"
+#include "wire.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+
+namespace reader {
+
+namespace {
+
+using schema = wire::message_schema;
+
+enum class comparison { less, less_equal, greater, greater_equal };
+
+/// An inclusive range of encoded values, which is empty if `low > high`
+struct range {
+    std::uint64_t low;
+    std::uint64_t high;
+};
+
+constexpr auto empty_range = range{1, 0};
+
+/// @brief Decodes a temperature as MessageView does
+auto decode_temperature(std::uint64_t encoded) noexcept -> float {
+    unsigned char packed[schema::temperature::size];
+    schema::temperature::write(static_cast<schema::temperature::value_type>(encoded), packed);
+
+    auto value = 0.0f;
+    convert_temperatures(packed, 1, &value, simd_isa::scalar);
+    return value;
+}
+
+/// @brief Decodes a humidity as MessageView does
+auto decode_humidity(std::uint64_t encoded) noexcept -> float {
+    unsigned char packed[schema::humidity::size];
+    schema::humidity::write(static_cast<schema::humidity::value_type>(encoded), packed);
+
+    auto value = 0.0f;
+    convert_humidities(packed, 1, &value, simd_isa::scalar);
+    return value;
+}
+
+/// @brief Finds the encoded values which decode to a value comparing with a bound
+/// @param decode Decodes a value, and never decreases as the encoded value increases
+/// @param max Largest encoded value
+template <class Decode>
+auto encoded_range(Decode decode, std::uint64_t max, comparison c, float bound) -> range {
+    // The first encoded value which decodes to a value at least, or above, the bound
+    const auto first = [&decode, max, bound](bool inclusive) {
+        auto low = std::uint64_t{0};
+        auto high = max + 1;
+        while (low < high) {
+            const auto mid = low + (high - low) / 2;
+            const auto value = decode(mid);
+            if (inclusive ? value >= bound : value > bound) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return low;
+    };
+
+    switch (c) {
+        case comparison::less: {
+            const auto end = first(true);
+            return end == 0 ? empty_range : range{0, end - 1};
+        }
+        case comparison::less_equal: {
+            const auto end = first(false);
+            return end == 0 ? empty_range : range{0, end - 1};
+        }
+        case comparison::greater:
+            return {first(false), max};
+        case comparison::greater_equal:
+            return {first(true), max};
+    }
+    return empty_range;
+}
+
+/// Flips the sign bit of an encoded timestamp, so that encoded timestamps order as the signed
+/// milliseconds since the epoch they are decoded to
+constexpr auto timestamp_bias = std::uint64_t{1} << 63;
+
+/// @brief Finds the biased encoded timestamps comparing with a bound
+/// @param bound Milliseconds since the epoch
+/// @see timestamp_bias
+auto timestamp_range(comparison c, std::int64_t bound) -> range {
+    constexpr auto max = std::numeric_limits<std::uint64_t>::max();
+
+    const auto biased = static_cast<std::uint64_t>(bound) ^ timestamp_bias;
+    switch (c) {
+        case comparison::less:
+            return biased == 0 ? empty_range : range{0, biased - 1};
+        case comparison::less_equal:
+            return {0, biased};
+        case comparison::greater:
+            return biased == max ? empty_range : range{biased + 1, max};
+        case comparison::greater_equal:
+            return {biased, max};
+    }
+    return empty_range;
+}
+
+} // namespace
+
+class Filter::parser {
+  public:
+    parser(std::string_view expression, Filter& filter) : expression_{expression}, filter_{filter} {}
+
+    /// @brief Compiles the expression to the program of the filter
+    /// @return Whether the expression is valid. Otherwise, `error` describes why it is not.
+    auto parse() -> bool {
+        if (!parse_or()) {
+            return false;
+        }
+        if (peek().kind != token_kind::end) {
+            return fail("expected `and`, `or` or the end of the expression");
+        }
+        return true;
+    }
+
+    auto error() const noexcept -> const std::string& { return error_; }
+
+  private:
+    enum class token_kind {
+        end,
+        open,
+        close,
+        /// A comparison operator
+        op,
+        word,
+        /// A string in double quotes, without the quotes and escapes
+        string,
+        /// A string missing its closing quote
+        unterminated,
+    };
+
+    struct token {
+        token_kind kind;
+        std::string text;
+
+        /// Position of the token in the expression, starting from 1
+        std::size_t column;
+    };
+
+    auto parse_or() -> bool {
+        if (!parse_and()) {
+            return false;
+        }
+        while (is_keyword(peek(), "or")) {
+            take();
+            if (!parse_and() || !emit(opcode::either)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto parse_and() -> bool {
+        if (!parse_unary()) {
+            return false;
+        }
+        while (is_keyword(peek(), "and")) {
+            take();
+            if (!parse_unary() || !emit(opcode::both)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto parse_unary() -> bool {
+        // Limits the recursion of parentheses and negations
+        if (nesting_ == max_depth) {
+            return fail("expression is nested too deeply");
+        }
+
+        ++nesting_;
+        const auto parsed = parse_operand();
+        --nesting_;
+        return parsed;
+    }
+
+    auto parse_operand() -> bool {
+        if (is_keyword(peek(), "not")) {
+            take();
+            return parse_unary() && emit(opcode::negate);
+        }
+
+        if (peek().kind == token_kind::open) {
+            take();
+            if (!parse_or()) {
+                return false;
+            }
+            if (peek().kind != token_kind::close) {
+                return fail("expected `)`");
+            }
+            take();
+            return true;
+        }
+
+        return parse_condition();
+    }
+
+    auto parse_condition() -> bool {
+        if (peek().kind != token_kind::word) {
+            return fail("expected a condition");
+        }
+
+        const auto field = peek().text;
+        if (field == "has") {
+            take();
+            if (is_keyword(peek(), "temperature")) {
+                take();
+                return emit(opcode::has_temperature);
+            }
+            if (is_keyword(peek(), "humidity")) {
+                take();
+                return emit(opcode::has_humidity);
+            }
+            return fail("expected `temperature` or `humidity`");
+        }
+
+        if (field == "name") {
+            take();
+            const auto op = peek().kind == token_kind::op ? peek().text : std::string{};
+            if (op != "=" && op != "^=") {
+                return fail("expected `=` or `^=`");
+            }
+            take();
+
+            if (peek().kind != token_kind::word && peek().kind != token_kind::string) {
+                return fail("expected a name");
+            }
+            const auto name = take().text;
+            return emit(op == "=" ? opcode::name_equals : opcode::name_prefix, name);
+        }
+
+        if (field != "temperature" && field != "humidity" && field != "timestamp") {
+            return fail("expected a condition");
+        }
+        take();
+
+        const auto c = parse_comparison();
+        if (!c) {
+            return fail("expected `<`, `<=`, `>` or `>=`");
+        }
+        take();
+
+        const auto& value = peek();
+        if (field == "timestamp") {
+            const auto timestamp =
+                value.kind == token_kind::word ? parse_timestamp(value.text) : std::nullopt;
+            if (!timestamp) {
+                return fail("expected a date and time");
+            }
+            take();
+
+            const auto bound = std::chrono::duration_cast<std::chrono::milliseconds>(
+                timestamp->time_since_epoch());
+            return emit(opcode::timestamp_in, timestamp_range(*c, bound.count()));
+        }
+
+        const auto bound = value.kind == token_kind::word ? parse_number(value.text) : std::nullopt;
+        if (!bound) {
+            return fail("expected a number");
+        }
+        take();
+
+        return field == "temperature"
+                   ? emit(opcode::temperature_in,
+                          encoded_range(decode_temperature, schema::temperature::max, *c, *bound))
+                   : emit(opcode::humidity_in,
+                          encoded_range(decode_humidity, schema::humidity::max, *c, *bound));
+    }
+
+    auto parse_comparison() -> std::optional<comparison> {
+        if (peek().kind != token_kind::op) {
+            return std::nullopt;
+        }
+
+        const auto& op = peek().text;
+        if (op == "<") {
+            return comparison::less;
+        }
+        if (op == "<=") {
+            return comparison::less_equal;
+        }
+        if (op == ">") {
+            return comparison::greater;
+        }
+        if (op == ">=") {
+            return comparison::greater_equal;
+        }
+        return std::nullopt;
+    }
+
+    /// @brief Parses a finite number, which is compared with the decoded value as a float
+    static auto parse_number(const std::string& s) -> std::optional<float> {
+        char* end = nullptr;
+        const auto value = std::strtof(s.c_str(), &end);
+        if (end != s.c_str() + s.size() || !std::isfinite(value)) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    /// @brief Appends a condition on a range of values to the program
+    auto emit(opcode op, range values = {}) -> bool {
+        return append({op, 0, 0, values.low, values.high});
+    }
+
+    /// @brief Appends a condition on the name to the program
+    auto emit(opcode op, const std::string& name) -> bool {
+        const auto offset = static_cast<std::uint32_t>(filter_.strings_.size());
+        filter_.strings_.append(name);
+        return append({op, offset, static_cast<std::uint32_t>(name.size()), 0, 0});
+    }
+
+    /// @brief Appends an instruction, tracking the depth of the stack it is evaluated on
+    auto append(const instruction& i) -> bool {
+        switch (i.op) {
+            case opcode::name_equals:
+            case opcode::name_prefix:
+            case opcode::timestamp_in:
+            case opcode::temperature_in:
+            case opcode::humidity_in:
+            case opcode::has_temperature:
+            case opcode::has_humidity:
+                if (depth_ == max_depth) {
+                    return fail("expression is nested too deeply");
+                }
+                ++depth_;
+                break;
+            case opcode::negate:
+                break;
+            case opcode::both:
+            case opcode::either:
+                --depth_;
+                break;
+        }
+
+        filter_.program_.push_back(i);
+        return true;
+    }
+
+    static auto is_keyword(const token& t, std::string_view keyword) -> bool {
+        return t.kind == token_kind::word && t.text == keyword;
+    }
+
+    /// @brief Sets the error, describing where in the expression it occurred
+    /// @return false
+    auto fail(std::string_view message) -> bool {
+        const auto& at = peek();
+        if (at.kind == token_kind::unterminated) {
+            error_ = "unterminated string at column " + std::to_string(at.column);
+        } else if (at.kind == token_kind::end) {
+            error_ = std::string{message} + " at the end of the expression";
+        } else {
+            error_ = std::string{message} + " at column " + std::to_string(at.column);
+        }
+        return false;
+    }
+
+    auto peek() -> const token& {
+        if (!next_) {
+            next_ = lex();
+        }
+        return *next_;
+    }
+
+    auto take() -> token {
+        peek();
+        auto t = std::move(*next_);
+        next_.reset();
+        return t;
+    }
+
+    auto lex() -> token {
+        while (position_ < expression_.size() && is_space(expression_[position_])) {
+            ++position_;
+        }
+
+        const auto start = position_;
+        const auto column = start + 1;
+        if (position_ == expression_.size()) {
+            return {token_kind::end, {}, column};
+        }
+
+        const auto c = expression_[position_];
+        if (c == '(' || c == ')') {
+            ++position_;
+            return {c == '(' ? token_kind::open : token_kind::close, {}, column};
+        }
+
+        if (is_operator(start)) {
+            const auto with_equals =
+                position_ + 1 < expression_.size() && expression_[position_ + 1] == '=';
+            position_ += with_equals ? 2u : 1u;
+            return {token_kind::op, std::string{expression_.substr(start, position_ - start)},
+                    column};
+        }
+
+        if (c == '"') {
+            auto text = std::string{};
+            for (++position_; position_ < expression_.size(); ++position_) {
+                const auto s = expression_[position_];
+                if (s == '"') {
+                    ++position_;
+                    return {token_kind::string, std::move(text), column};
+                }
+                if (s == '\\' && position_ + 1 < expression_.size() &&
+                    (expression_[position_ + 1] == '"' || expression_[position_ + 1] == '\\')) {
+                    ++position_;
+                }
+                text.push_back(expression_[position_]);
+            }
+            return {token_kind::unterminated, {}, column};
+        }
+
+        while (position_ < expression_.size() && !is_space(expression_[position_]) &&
+               expression_[position_] != '(' && expression_[position_] != ')' &&
+               expression_[position_] != '"' && !is_operator(position_)) {
+            ++position_;
+        }
+        return {token_kind::word, std::string{expression_.substr(start, position_ - start)},
+                column};
+    }
+
+    /// @brief Checks whether a comparison operator starts at a position
+    auto is_operator(std::size_t position) const noexcept -> bool {
+        const auto c = expression_[position];
+        return c == '<' || c == '>' || c == '=' ||
+               (c == '^' && position + 1 < expression_.size() && expression_[position + 1] == '=');
+    }
+
+    static auto is_space(char c) noexcept -> bool {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    const std::string_view expression_;
+    Filter& filter_;
+
+    std::size_t position_ = 0;
+    std::optional<token> next_;
+
+    /// Number of parentheses and negations enclosing the current condition
+    std::size_t nesting_ = 0;
+
+    /// Number of values on the stack after the instructions emitted so far
+    std::size_t depth_ = 0;
+
+    std::string error_;
+};
+
+auto Filter::compile(std::string_view expression) -> nonstd::expected<Filter, std::string> {
+    auto filter = Filter{};
+    auto p = parser{expression, filter};
+    if (!p.parse()) {
+        return nonstd::make_unexpected(p.error());
+    }
+    return filter;
+}
+
+auto Filter::matches(asio::const_buffer payload) const noexcept -> bool {
+    const auto data = static_cast<const unsigned char*>(payload.data());
+
+    auto layout = wire::message_layout{};
+    if (wire::validate(data, payload.size(), layout)) {
+        return true;
+    }
+
+    const auto name = std::string_view{
+        reinterpret_cast<const char*>(data + schema::name_data_offset), layout.name_size};
+    const auto trailing = data + schema::name_data_offset + layout.name_size;
+    const auto has_temperature = ((layout.present >> schema::temperature_field) & 1) != 0;
+    const auto has_humidity = ((layout.present >> schema::humidity_field) & 1) != 0;
+
+    const auto strings = std::string_view{strings_};
+    const auto in = [](const instruction& i, std::uint64_t value) {
+        return i.low <= value && value <= i.high;
+    };
+
+    // Bit 0 is the top of the stack
+    auto stack = std::uint64_t{0};
+    const auto push = [&stack](bool value) { stack = (stack << 1) | (value ? 1 : 0); };
+
+    for (const auto& i : program_) {
+        switch (i.op) {
+            case opcode::name_equals:
+                push(name == strings.substr(i.offset, i.size));
+                break;
+            case opcode::name_prefix:
+                push(name.substr(0, i.size) == strings.substr(i.offset, i.size));
+                break;
+            case opcode::timestamp_in:
+                push(in(i, schema::timestamp::read(data) ^ timestamp_bias));
+                break;
+            case opcode::temperature_in:
+                push(has_temperature &&
+                     in(i,
+                        schema::temperature::read(
+                            trailing + schema::trailing_fields::offset<schema::temperature_field>(
+                                           layout.present))));
+                break;
+            case opcode::humidity_in:
+                push(has_humidity &&
+                     in(i,
+                        schema::humidity::read(
+                            trailing + schema::trailing_fields::offset<schema::humidity_field>(
+                                           layout.present))));
+                break;
+            case opcode::has_temperature:
+                push(has_temperature);
+                break;
+            case opcode::has_humidity:
+                push(has_humidity);
+                break;
+            case opcode::negate:
+                stack ^= 1;
+                break;
+            case opcode::both: {
+                const auto top = stack & 1;
+                stack >>= 1;
+                stack &= top | ~std::uint64_t{1};
+                break;
+            }
+            case opcode::either: {
+                const auto top = stack & 1;
+                stack >>= 1;
+                stack |= top;
+                break;
+            }
+        }
+    }
+
+    return (stack & 1) != 0;
+}
+
+} // namespace reader
@@ -0,0 +1,255 @@
+#include "index.h"
+
+#include "compat/endian.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace logger {
+
+namespace {
+
+constexpr auto name_tag = 'N';
+constexpr auto block_tag = 'B';
+
+/// Byte size of the fixed fields of a block entry, including the tag
+constexpr std::size_t block_entry_size = 1 + 8 + 8 + 8 + 8 + 4 + 4;
+
+auto append_u32(std::string& out, std::uint32_t value) -> void {
+    const auto be = htobe32(value);
+    out.append(reinterpret_cast<const char*>(&be), sizeof(be));
+}
+
+auto append_u64(std::string& out, std::uint64_t value) -> void {
+    const auto be = htobe64(value);
+    out.append(reinterpret_cast<const char*>(&be), sizeof(be));
+}
+
+/// Reads big-endian numbers from the front of a buffer
+class entry_reader {
+  public:
+    explicit entry_reader(std::string_view data) : data_{data} {}
+
+    auto remaining() const noexcept -> std::size_t { return data_.size(); }
+
+    auto u8() -> std::uint8_t { return static_cast<std::uint8_t>(bytes(1).front()); }
+
+    auto u32() -> std::uint32_t {
+        auto be = std::uint32_t{};
+        std::memcpy(&be, bytes(sizeof(be)).data(), sizeof(be));
+        return be32toh(be);
+    }
+
+    auto u64() -> std::uint64_t {
+        auto be = std::uint64_t{};
+        std::memcpy(&be, bytes(sizeof(be)).data(), sizeof(be));
+        return be64toh(be);
+    }
+
+    auto bytes(std::size_t n) -> std::string_view {
+        const auto b = data_.substr(0, n);
+        data_.remove_prefix(n);
+        return b;
+    }
+
+  private:
+    std::string_view data_;
+};
+
+auto to_milliseconds(record_info::time_point_t timestamp) -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+IndexBuilder::IndexBuilder(std::size_t block_size)
+    : block_size_{block_size}, pending_{index_magic} {}
+
+auto IndexBuilder::add(std::uint64_t offset, const record_info& info) -> void {
+    if (!block_started_) {
+        block_.offset = offset;
+        block_started_ = true;
+    } else if (offset - block_.offset >= block_size_) {
+        seal(offset);
+    }
+
+    const auto id = name_id(info.name);
+    if (last_block_[id] != block_number_) {
+        last_block_[id] = block_number_;
+        block_.names.push_back(id);
+    }
+
+    if (info.timestamp) {
+        const auto ms = to_milliseconds(*info.timestamp);
+        block_.min_timestamp = std::min(block_.min_timestamp, ms);
+        block_.max_timestamp = std::max(block_.max_timestamp, ms);
+    }
+    ++block_.records;
+}
+
+auto IndexBuilder::finish(std::uint64_t end) -> void {
+    if (block_started_) {
+        seal(end);
+        block_started_ = false;
+    }
+}
+
+auto IndexBuilder::take(std::string& out) -> void {
+    out.append(pending_);
+    pending_.clear();
+}
+
+auto IndexBuilder::seal(std::uint64_t offset) -> void {
+    block_.size = offset - block_.offset;
+
+    pending_.push_back(block_tag);
+    append_u64(pending_, block_.offset);
+    append_u64(pending_, block_.size);
+    append_u64(pending_, static_cast<std::uint64_t>(block_.min_timestamp));
+    append_u64(pending_, static_cast<std::uint64_t>(block_.max_timestamp));
+    append_u32(pending_, block_.records);
+    append_u32(pending_, static_cast<std::uint32_t>(block_.names.size()));
+    for (const auto id : block_.names) {
+        append_u32(pending_, id);
+    }
+
+    // The list of names keeps its capacity for the next block
+    auto names = std::move(block_.names);
+    names.clear();
+    block_ = index_block{};
+    block_.offset = offset;
+    block_.names = std::move(names);
+    ++block_number_;
+}
+
+auto IndexBuilder::name_id(std::string_view name) -> std::uint32_t {
+    const auto it = ids_.find(name);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+
+    // Names are limited to 255 bytes by the wire format
+    const auto& stored = names_.emplace_back(name.substr(0, 255));
+    const auto id = static_cast<std::uint32_t>(last_block_.size());
+    ids_.emplace(stored, id);
+    last_block_.push_back(std::numeric_limits<std::uint32_t>::max());
+
+    pending_.push_back(name_tag);
+    append_u32(pending_, id);
+    pending_.push_back(static_cast<char>(stored.size()));
+    pending_.append(stored);
+
+    return id;
+}
+
+Index::Index(std::string_view data) {
+    if (data.substr(0, index_magic.size()) != index_magic) {
+        throw bad_index_data{"index does not start with the index magic."};
+    }
+
+    auto reader = entry_reader{data.substr(index_magic.size())};
+    auto names = std::vector<std::string>{};
+
+    while (reader.remaining() > 0) {
+        const auto tag = static_cast<char>(reader.u8());
+
+        if (tag == name_tag) {
+            if (reader.remaining() < 5) {
+                break;
+            }
+            const auto id = reader.u32();
+            const auto size = reader.u8();
+            if (reader.remaining() < size) {
+                break;
+            }
+            if (id != names.size()) {
+                throw bad_index_data{"name entries are out of order."};
+            }
+            names.emplace_back(reader.bytes(size));
+            first_block_.push_back(std::numeric_limits<std::uint32_t>::max());
+        } else if (tag == block_tag) {
+            if (reader.remaining() < block_entry_size - 1) {
+                break;
+            }
+            auto block = index_block{};
+            block.offset = reader.u64();
+            block.size = reader.u64();
+            block.min_timestamp = static_cast<std::int64_t>(reader.u64());
+            block.max_timestamp = static_cast<std::int64_t>(reader.u64());
+            block.records = reader.u32();
+
+            const auto count = reader.u32();
+            if (reader.remaining() / sizeof(std::uint32_t) < count) {
+                break;
+            }
+            for (auto i = std::uint32_t{0}; i < count; ++i) {
+                const auto id = reader.u32();
+                if (id >= names.size()) {
+                    throw bad_index_data{"block refers to an undefined name."};
+                }
+                const auto number = static_cast<std::uint32_t>(blocks_.size());
+                block.names.push_back(id);
+                postings_[names[id]].push_back(number);
+                first_block_[id] = std::min(first_block_[id], number);
+            }
+            blocks_.push_back(std::move(block));
+        } else {
+            throw bad_index_data{"index contains an unknown entry."};
+        }
+    }
+}
+
+auto Index::end() const noexcept -> std::uint64_t {
+    return blocks_.empty() ? 0 : blocks_.back().offset + blocks_.back().size;
+}
+
+auto Index::find(std::optional<std::string_view> name, time_point_t from, time_point_t to) const
+    -> std::vector<const index_block*> {
+    const auto from_ms = to_milliseconds(from);
+    const auto to_ms = to_milliseconds(to);
+
+    const auto matches = [&](const index_block& block) {
+        const auto has_timestamps = block.min_timestamp <= block.max_timestamp;
+        return !has_timestamps ? name.has_value()
+                               : (block.min_timestamp <= to_ms && block.max_timestamp >= from_ms);
+    };
+
+    auto found = std::vector<const index_block*>{};
+    if (!name) {
+        // Records may refer to names defined in earlier blocks by `logger --dictionary`, so the
+        // first block of each name in a matching block is also returned
+        auto numbers = std::vector<std::uint32_t>{};
+        for (auto number = std::uint32_t{0}; number < blocks_.size(); ++number) {
+            if (matches(blocks_[number])) {
+                numbers.push_back(number);
+                for (const auto id : blocks_[number].names) {
+                    numbers.push_back(first_block_[id]);
+                }
+            }
+        }
+
+        std::sort(numbers.begin(), numbers.end());
+        numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+        for (const auto number : numbers) {
+            found.push_back(&blocks_[number]);
+        }
+        return found;
+    }
+
+    const auto it = postings_.find(std::string{*name});
+    if (it == postings_.end()) {
+        return found;
+    }
+
+    // The first block containing the name also contains its definition, if names are interned
+    found.push_back(&blocks_[it->second.front()]);
+    for (auto number = it->second.cbegin() + 1; number != it->second.cend(); ++number) {
+        if (matches(blocks_[*number])) {
+            found.push_back(&blocks_[*number]);
+        }
+    }
+    return found;
+}
+
+} // namespace logger
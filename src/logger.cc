@@ -1,56 +1,782 @@
+#include "aggregator.h"
 #include "compat/asio.h"
 #include "connection.h"
+#include "filter.h"
+#include "index.h"
+#include "merger.h"
+#include "metrics.h"
+#include "name_table.h"
+#include "output.h"
+#include "record_ring.h"
+#include "serializer.h"
+#include "timestamp.h"
+#include "writer.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace {
 using asio::ip::tcp;
 
+/// Socket option allowing several sockets to listen on the same port
+///
+/// The kernel distributes incoming connections across all listening sockets.
+using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+/// @brief Creates an acceptor listening on a port
+/// @param io_context The io_context used by the acceptor
+/// @param port Port to listen on
+/// @param shared If set, other acceptors may listen on the same port
+auto make_acceptor(asio::io_context& io_context, unsigned short port, bool shared)
+    -> tcp::acceptor {
+    const auto endpoint = tcp::endpoint{tcp::v4(), port};
+
+    auto acceptor = tcp::acceptor{io_context};
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+    if (shared) {
+        acceptor.set_option(reuse_port(true));
+    }
+    acceptor.bind(endpoint);
+    acceptor.listen();
+
+    return acceptor;
+}
+
 /// A logging server
 class Server {
   public:
-    Server(asio::io_context& io_context, unsigned short port)
-        : acceptor_{io_context, tcp::endpoint{tcp::v4(), port}} {
+    /// @brief Creates a Server and starts accepting connections
+    /// @param io_context The io_context running accepted connections
+    /// @param acceptor An acceptor listening for connections
+    /// @param output Destination for records and status messages
+    /// @param options Options for accepted connections
+    /// @param single_threaded If set, `io_context` is run by a single thread and connections
+    ///        are not bound to a strand
+    Server(asio::io_context& io_context,
+           tcp::acceptor acceptor,
+           logger::Output output,
+           logger::connection_options options,
+           bool single_threaded = false)
+        : io_context_{io_context},
+          acceptor_{std::move(acceptor)},
+          output_{std::move(output)},
+          options_{options},
+          single_threaded_{single_threaded} {
         do_accept();
     }
 
   private:
+    auto do_accept() -> void {
+        const auto handler = [this](std::error_code ec, tcp::socket socket) {
+            if (!ec) {
+                logger::make_connection(std::move(socket), output_, options_);
+            }
+
+            do_accept();
+        };
+
+        if (single_threaded_) {
+            acceptor_.async_accept(io_context_, handler);
+            return;
+        }
+
+        // Each accepted socket is bound to its own strand so that the handlers of a connection
+        // never run concurrently, while different connections may be served in parallel.
+        acceptor_.async_accept(asio::make_strand(io_context_), handler);
+    }
+
+    asio::io_context& io_context_;
+    tcp::acceptor acceptor_;
+    logger::Output output_;
+    const logger::connection_options options_;
+    const bool single_threaded_;
+};
+
+/// A Server with its own acceptor and io_context, run by a single thread
+///
+/// All shards listen on the same port and the kernel distributes incoming connections between
+/// them. A connection is served entirely by the thread of the shard that accepted it.
+class Shard {
+  public:
+    /// @brief Creates a Shard and starts accepting connections
+    /// @param port Port to listen on
+    /// @param output Destination for records and status messages
+    /// @param options Options for accepted connections
+    Shard(unsigned short port, logger::Output output, logger::connection_options options)
+        : server_{io_context_,
+                  make_acceptor(io_context_, port, true),
+                  std::move(output),
+                  options,
+                  true} {}
+
+    /// @brief Runs the shard on the calling thread until stopped
+    /// @param cpu Index of the CPU the calling thread is pinned to
+    auto run(unsigned cpu) -> void {
+#ifdef __linux__
+        auto cpus = cpu_set_t{};
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus);
+#else
+        static_cast<void>(cpu);
+#endif
+
+        io_context_.run();
+    }
+
+    auto stop() -> void { io_context_.stop(); }
+
+  private:
+    asio::io_context io_context_{1};
+    Server server_;
+};
+
+/// Serves metrics as plain text over HTTP
+///
+/// Every request is answered with the current metrics report, regardless of the request path,
+/// and the connection is closed.
+class StatsServer {
+  public:
+    /// @brief Creates a StatsServer listening on the loopback interface
+    /// @param io_context The io_context serving requests
+    /// @param port Port to listen on
+    /// @param metrics Metrics to report
+    /// @note `metrics` must be guaranteed to exist for the lifetime of the StatsServer
+    StatsServer(asio::io_context& io_context, unsigned short port, const logger::Metrics& metrics)
+        : acceptor_{io_context, tcp::endpoint{asio::ip::address_v4::loopback(), port}},
+          metrics_{metrics} {
+        do_accept();
+    }
+
+  private:
+    /// State of a single request
+    struct request {
+        explicit request(tcp::socket s) : socket{std::move(s)} {}
+
+        tcp::socket socket;
+        std::array<char, 1024> buffer{};
+        std::string response;
+    };
+
     auto do_accept() -> void {
         acceptor_.async_accept([this](std::error_code ec, tcp::socket socket) {
             if (!ec) {
-                logger::make_connection(std::move(socket), std::cout, std::cerr);
+                respond(std::make_shared<request>(std::move(socket)));
             }
 
             do_accept();
         });
     }
 
+    auto respond(std::shared_ptr<request> req) -> void {
+        // The request is read before responding so that closing the socket does not reset the
+        // connection while the client is still sending
+        req->socket.async_read_some(
+            asio::buffer(req->buffer), [this, req](std::error_code ec, std::size_t) {
+                if (ec) {
+                    return;
+                }
+
+                auto body = std::ostringstream{};
+                metrics_.report(body);
+                const auto body_str = body.str();
+
+                req->response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " +
+                                std::to_string(body_str.size()) + "\r\n\r\n" + body_str;
+
+                asio::async_write(req->socket,
+                                  asio::buffer(req->response),
+                                  [req](std::error_code, std::size_t) {});
+            });
+    }
+
     tcp::acceptor acceptor_;
+    const logger::Metrics& metrics_;
 };
+
+/// Sends the records published to a RecordRing to subscribers
+///
+/// Each subscriber reads the ring with its own cursor, starting with the records published after
+/// it connects. A subscriber which falls further behind than the ring holds skips the records
+/// dropped from the ring, so subscribers never slow down the connections publishing records.
+/// Data sent by subscribers is discarded.
+///
+/// With a NameTable, the definitions of the names interned so far are sent before the first
+/// records and again after records are skipped, as the definitions sent earlier may be missed.
+class SubscriberServer {
+  public:
+    /// @brief Creates a SubscriberServer and starts accepting subscribers
+    /// @param io_context The io_context running subscriber sessions
+    /// @param acceptor An acceptor listening for subscribers
+    /// @param ring Ring of records to send
+    /// @param names Names referred to by ID in the records, or nullptr if names are not interned
+    /// @param format The layout of the name definitions
+    /// @param output Destination for status messages
+    /// @note `ring` and `names` must be guaranteed to exist for the lifetime of the
+    ///       SubscriberServer and its sessions
+    SubscriberServer(asio::io_context& io_context,
+                     tcp::acceptor acceptor,
+                     logger::RecordRing& ring,
+                     const logger::NameTable* names,
+                     reader::json_format format,
+                     logger::Output output)
+        : io_context_{io_context},
+          acceptor_{std::move(acceptor)},
+          ring_{ring},
+          names_{names},
+          format_{format},
+          output_{std::move(output)} {
+        do_accept();
+    }
+
+    /// @brief Number of connected subscribers
+    auto subscribers() const noexcept -> std::uint64_t {
+        return subscribers_->load(std::memory_order_relaxed);
+    }
+
+  private:
+    /// A connected subscriber
+    class session : public std::enable_shared_from_this<session> {
+      public:
+        session(tcp::socket socket,
+                logger::RecordRing& ring,
+                const logger::NameTable* names,
+                reader::json_format format,
+                logger::Output output,
+                std::shared_ptr<std::atomic<std::uint64_t>> subscribers)
+            : socket_{std::move(socket)},
+              ring_{ring},
+              cursor_{ring.end()},
+              names_{names},
+              format_{format},
+              define_{names != nullptr},
+              output_{std::move(output)},
+              subscribers_{std::move(subscribers)} {
+            auto ss = std::ostringstream{};
+            const auto& endpoint = socket_.remote_endpoint();
+            ss << "[" << endpoint.address().to_string() << ":" << endpoint.port() << "] ";
+            status_prefix_ = ss.str();
+
+            subscribers_->fetch_add(1, std::memory_order_relaxed);
+            status("Subscribed\n");
+        }
+
+        ~session() {
+            subscribers_->fetch_sub(1, std::memory_order_relaxed);
+            status("Unsubscribed\n");
+        }
+
+        auto start() -> void {
+            watch();
+            send();
+        }
+
+      private:
+        /// Largest number of chunks sent with a single write
+        static constexpr std::size_t max_chunks = 16;
+
+        /// @brief Closes the socket once the subscriber disconnects
+        auto watch() -> void {
+            socket_.async_read_some(
+                asio::buffer(discarded_),
+                [self = shared_from_this()](std::error_code ec, std::size_t) {
+                    if (ec) {
+                        auto ignored = asio::error_code{};
+                        self->socket_.close(ignored);
+                        return;
+                    }
+                    self->watch();
+                });
+        }
+
+        /// @brief Sends the chunks following the cursor, or waits for the next chunk
+        auto send() -> void {
+            chunks_.clear();
+            const auto skipped =
+                ring_.read(cursor_, chunks_, max_chunks, [self = shared_from_this()]() {
+                    asio::post(self->socket_.get_executor(), [self]() { self->send(); });
+                });
+
+            if (skipped > 0) {
+                status("Skipped " + std::to_string(skipped) + " chunks of records\n");
+                define_ = names_ != nullptr;
+            }
+
+            if (chunks_.empty()) {
+                return;
+            }
+
+            buffers_.clear();
+            definitions_.clear();
+            if (define_) {
+                define_ = false;
+                define();
+                buffers_.push_back(asio::buffer(definitions_));
+            }
+            for (const auto& chunk : chunks_) {
+                buffers_.push_back(asio::buffer(*chunk));
+            }
+
+            // The chunks are kept alive by `chunks_` until the write completes
+            asio::async_write(socket_,
+                              buffers_,
+                              [self = shared_from_this()](std::error_code ec, std::size_t) {
+                                  if (!ec) {
+                                      self->send();
+                                  }
+                              });
+        }
+
+        /// @brief Writes the definitions of the names interned so far to `definitions_`
+        ///
+        /// The names are listed after the cursor is taken, so a name which is not listed has its
+        /// definition published after the cursor.
+        auto define() -> void {
+            for (const auto& interned : names_->names()) {
+                reader::write_name_definition(definitions_, interned.id, interned.name, format_);
+                definitions_.push_back('\n');
+            }
+        }
+
+        auto status(std::string_view message) -> void {
+            output_.status(status_prefix_ + std::string{message});
+        }
+
+        tcp::socket socket_;
+        logger::RecordRing& ring_;
+        logger::RecordRing::sequence cursor_;
+        const logger::NameTable* names_;
+        reader::json_format format_;
+
+        /// Whether name definitions are sent before the next chunks
+        bool define_;
+
+        logger::Output output_;
+        std::shared_ptr<std::atomic<std::uint64_t>> subscribers_;
+        std::string status_prefix_;
+
+        std::string definitions_;
+        std::vector<logger::RecordRing::chunk> chunks_;
+        std::vector<asio::const_buffer> buffers_;
+        std::array<char, 256> discarded_{};
+    };
+
+    auto do_accept() -> void {
+        // Each subscriber is bound to its own strand, as the ring may wake it from any thread
+        acceptor_.async_accept(asio::make_strand(io_context_),
+                               [this](std::error_code ec, tcp::socket socket) {
+                                   if (!ec) {
+                                       std::make_shared<session>(std::move(socket),
+                                                                 ring_,
+                                                                 names_,
+                                                                 format_,
+                                                                 output_,
+                                                                 subscribers_)
+                                           ->start();
+                                   }
+
+                                   do_accept();
+                               });
+    }
+
+    asio::io_context& io_context_;
+    tcp::acceptor acceptor_;
+    logger::RecordRing& ring_;
+    const logger::NameTable* names_;
+    reader::json_format format_;
+    logger::Output output_;
+
+    /// Shared with sessions, which may outlive the server
+    const std::shared_ptr<std::atomic<std::uint64_t>> subscribers_ =
+        std::make_shared<std::atomic<std::uint64_t>>(0);
+};
+
+/// Periodically writes metrics as status messages
+class StatsReporter {
+  public:
+    /// @brief Creates a StatsReporter and schedules the first report
+    /// @param io_context The io_context running the timer
+    /// @param interval Time between reports
+    /// @param metrics Metrics to report
+    /// @param output Destination for the reports
+    /// @note `metrics` must be guaranteed to exist for the lifetime of the StatsReporter
+    StatsReporter(asio::io_context& io_context,
+                  std::chrono::seconds interval,
+                  const logger::Metrics& metrics,
+                  logger::Output output)
+        : timer_{io_context}, interval_{interval}, metrics_{metrics}, output_{std::move(output)} {
+        schedule();
+    }
+
+  private:
+    auto schedule() -> void {
+        timer_.expires_after(interval_);
+        timer_.async_wait([this](std::error_code ec) {
+            if (ec) {
+                return;
+            }
+
+            auto ss = std::ostringstream{};
+            ss << "--- metrics ---\n";
+            metrics_.report(ss);
+            output_.status(ss.str());
+
+            schedule();
+        });
+    }
+
+    asio::steady_timer timer_;
+    const std::chrono::seconds interval_;
+    const logger::Metrics& metrics_;
+    logger::Output output_;
+};
+
+/// Periodically releases the state of idle sources, such as the open windows of an Aggregator or
+/// the buffered records of a Merger
+template <class Expirable>
+class Expirer {
+  public:
+    /// @brief Creates an Expirer and schedules the first expiry
+    /// @param io_context The io_context running the timer
+    /// @param interval Time between expiries
+    /// @param target Object whose idle state is expired
+    /// @note `target` must be guaranteed to exist for the lifetime of the Expirer
+    Expirer(asio::io_context& io_context, std::chrono::milliseconds interval, Expirable& target)
+        : timer_{io_context}, interval_{interval}, target_{target} {
+        schedule();
+    }
+
+  private:
+    auto schedule() -> void {
+        timer_.expires_after(interval_);
+        timer_.async_wait([this](std::error_code ec) {
+            if (ec) {
+                return;
+            }
+
+            target_.expire();
+            schedule();
+        });
+    }
+
+    asio::steady_timer timer_;
+    const std::chrono::milliseconds interval_;
+    Expirable& target_;
+};
+
+/// @brief Parses a comma separated list of durations
+/// @return The durations, or std::nullopt if any of them is invalid
+auto parse_durations(std::string_view list)
+    -> std::optional<std::vector<std::chrono::milliseconds>> {
+    auto durations = std::vector<std::chrono::milliseconds>{};
+    while (true) {
+        const auto comma = list.find(',');
+        const auto duration = logger::parse_duration(list.substr(0, comma));
+        if (!duration) {
+            return std::nullopt;
+        }
+        durations.push_back(*duration);
+
+        if (comma == std::string_view::npos) {
+            return durations;
+        }
+        list.remove_prefix(comma + 1);
+    }
+}
+
+/// Parses a positive number from a command line argument
+template <class T>
+auto parse_number(const char* arg) -> T {
+    auto ss = std::stringstream{};
+    ss << arg;
+
+    T n{};
+    ss >> n;
+    return n;
+}
+
+/// Maximum number of sensor names assigned an ID with `--dictionary`
+constexpr std::size_t max_interned_names = 1 << 16;
 } // namespace
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "usage: logger <port>\n";
+    constexpr auto usage = "usage: logger [--threads <n> | --shards <n>] [--ndjson | --raw]\n"
+                           "              [--dictionary] [--index <file>] [--stats-interval <s>]\n"
+                           "              [--stats-port <port>] [--rollup <file>]\n"
+                           "              [--windows <durations>] [--lateness <duration>]\n"
+                           "              [--merge <window>] [--subscribe-port <port>]\n"
+                           "              [--filter <expression>] <port>\n";
+
+    auto threads = 1u;
+    auto shards = std::optional<unsigned>{};
+    auto stats_interval = 0u;
+    auto stats_port = std::optional<unsigned short>{};
+    auto subscribe_port = std::optional<unsigned short>{};
+    auto dictionary = false;
+    auto index_path = std::optional<std::string>{};
+    auto rollup_path = std::optional<std::string>{};
+    auto rollup_options = logger::aggregator_options{};
+    auto valid_rollup_options = true;
+    auto merge_window = std::optional<std::chrono::milliseconds>{};
+    auto valid_merge_window = true;
+    auto filter = std::optional<reader::Filter>{};
+    auto options = logger::connection_options{logger::receive_mode::bulk};
+    auto args = std::vector<const char*>{};
+    for (auto i = 1; i < argc; ++i) {
+        const auto arg = std::string_view{argv[i]};
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = parse_number<unsigned>(argv[++i]);
+        } else if (arg == "--shards" && i + 1 < argc) {
+            shards = parse_number<unsigned>(argv[++i]);
+        } else if (arg == "--stats-interval" && i + 1 < argc) {
+            stats_interval = parse_number<unsigned>(argv[++i]);
+        } else if (arg == "--stats-port" && i + 1 < argc) {
+            stats_port = parse_number<unsigned short>(argv[++i]);
+        } else if (arg == "--subscribe-port" && i + 1 < argc) {
+            subscribe_port = parse_number<unsigned short>(argv[++i]);
+        } else if (arg == "--ndjson") {
+            options.format = reader::json_format::compact;
+        } else if (arg == "--raw") {
+            options.raw = true;
+        } else if (arg == "--dictionary") {
+            dictionary = true;
+        } else if (arg == "--index" && i + 1 < argc) {
+            index_path = argv[++i];
+        } else if (arg == "--rollup" && i + 1 < argc) {
+            rollup_path = argv[++i];
+        } else if (arg == "--windows" && i + 1 < argc) {
+            const auto windows = parse_durations(argv[++i]);
+            valid_rollup_options = valid_rollup_options && windows;
+            rollup_options.windows = windows.value_or(rollup_options.windows);
+        } else if (arg == "--lateness" && i + 1 < argc) {
+            const auto lateness = logger::parse_duration(argv[++i]);
+            valid_rollup_options = valid_rollup_options && lateness;
+            rollup_options.lateness = lateness.value_or(rollup_options.lateness);
+        } else if (arg == "--merge" && i + 1 < argc) {
+            merge_window = logger::parse_duration(argv[++i]);
+            valid_merge_window = merge_window.has_value();
+        } else if (arg == "--filter" && i + 1 < argc) {
+            auto compiled = reader::Filter::compile(argv[++i]);
+            if (!compiled) {
+                std::cerr << "Invalid filter: " << compiled.error() << "\n";
+                return EXIT_FAILURE;
+            }
+            filter = std::move(*compiled);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() != 1 || threads == 0 || (shards && (*shards == 0 || threads > 1)) ||
+        (index_path && options.raw) || (rollup_path && options.raw) || !valid_rollup_options ||
+        (merge_window && options.raw) || !valid_merge_window || (subscribe_port && options.raw) ||
+        (filter && options.raw)) {
+        std::cerr << usage;
         return EXIT_FAILURE;
     }
 
-    auto io_context = asio::io_context{};
+    // Records are written in large batches by the Writer, which does not need stdio
+    // synchronization
+    std::ios_base::sync_with_stdio(false);
+
+    auto index_file = std::ofstream{};
+    auto index = logger::IndexBuilder{};
+    if (index_path) {
+        index_file.open(*index_path, std::ios::binary | std::ios::trunc);
+        if (!index_file) {
+            std::cerr << "Unable to open " << *index_path << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto rollup_file = std::ofstream{};
+    if (rollup_path) {
+        rollup_file.open(*rollup_path, std::ios::trunc);
+        if (!rollup_file) {
+            std::cerr << "Unable to open " << *rollup_path << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Declared before the io_context so that they outlive any connections
+    auto writer = index_path ? logger::Writer{std::cout, index_file, index}
+                             : logger::Writer{std::cout};
+    auto metrics = logger::Metrics{};
+    auto names = logger::NameTable{max_interned_names};
+
+    // Rollups are written to their own file, by their own writer thread
+    auto rollup_writer = std::optional<logger::Writer>{};
+    auto aggregator = std::optional<logger::Aggregator>{};
+    if (rollup_path) {
+        rollup_options.format = options.format;
+        rollup_writer.emplace(rollup_file);
+        aggregator.emplace(rollup_options, [&rollup_writer](std::string_view rollup) {
+            rollup_writer->write(rollup);
+        });
+    }
+
+    auto io_context = asio::io_context{static_cast<int>(threads)};
+
+    const auto port = parse_number<unsigned short>(args[0]);
+
+    // Records are handed to the Writer by the thread serving a connection. Only status messages
+    // are serialized on the strand, which runs on the main thread when sharding.
+    const auto output = logger::Output{io_context.get_executor(), writer, std::cerr};
+
+    if (dictionary) {
+        options.names = &names;
+    }
+
+    if (filter) {
+        options.filter = &*filter;
+    }
+
+    // A sensor is idle once it has sent nothing for longer than its open windows can span
+    auto expirer = std::optional<Expirer<logger::Aggregator>>{};
+    if (aggregator) {
+        options.aggregator = &*aggregator;
+        expirer.emplace(io_context,
+                        *std::max_element(rollup_options.windows.cbegin(),
+                                          rollup_options.windows.cend()) +
+                            rollup_options.lateness,
+                        *aggregator);
+    }
+
+    // Declared after the io_context, as it holds subscriber sessions waiting for records
+    auto subscribers = std::optional<logger::RecordRing>{};
+    auto subscriber_server = std::optional<SubscriberServer>{};
+    if (subscribe_port) {
+        subscribers.emplace();
+        options.subscribers = &*subscribers;
+    }
 
-    const auto port = [&]() {
-        auto ss = std::stringstream{};
-        ss << argv[1];
+    // Records are merged across connections before they are handed to the Writer. Late records
+    // are written out of order and reported once per merge window.
+    auto merger = std::optional<logger::Merger>{};
+    auto merge_expirer = std::optional<Expirer<logger::Merger>>{};
+    if (merge_window) {
+        merger.emplace(
+            *merge_window,
+            [&writer, &subscribers](std::string_view record, const logger::record_info& info) {
+                writer.write(record, info);
+                if (subscribers) {
+                    subscribers->publish(record);
+                }
+            },
+            [status = output](std::uint64_t count, std::chrono::milliseconds behind) mutable {
+                status.status("Late records: " + std::to_string(count) +
+                              " written out of order, up to " + std::to_string(behind.count()) +
+                              "ms behind the merged output\n");
+            });
+        options.merger = &*merger;
+        merge_expirer.emplace(io_context, *merge_window, *merger);
+    }
+
+    if (stats_interval > 0 || stats_port) {
+        metrics.gauge("writer_queued_bytes", [&writer]() { return writer.queued(); });
+        if (dictionary) {
+            metrics.gauge("names_interned", [&names]() { return names.size(); });
+        }
+        if (aggregator) {
+            metrics.gauge("rollups_written", [&aggregator]() { return aggregator->written(); });
+            metrics.gauge("late_messages", [&aggregator]() { return aggregator->late(); });
+            metrics.gauge("rollup_sensors", [&aggregator]() { return aggregator->sensors(); });
+        }
+        if (subscribers) {
+            metrics.gauge("subscribers", [&subscriber_server]() {
+                return subscriber_server ? subscriber_server->subscribers() : 0;
+            });
+            metrics.gauge("subscriber_skipped_chunks",
+                          [&subscribers]() { return subscribers->skipped(); });
+        }
+        if (merger) {
+            metrics.gauge("merge_buffered_records", [&merger]() { return merger->buffered(); });
+            metrics.gauge("merge_late_records", [&merger]() { return merger->late(); });
+        }
+        options.metrics = &metrics;
+    }
 
-        unsigned short p;
-        ss >> p;
-        return p;
-    }();
+    auto reporter = std::optional<StatsReporter>{};
+    if (stats_interval > 0) {
+        reporter.emplace(io_context, std::chrono::seconds{stats_interval}, metrics, output);
+    }
+
+    auto server = std::optional<Server>{};
+    auto sharded = std::vector<std::unique_ptr<Shard>>{};
+    auto stats_server = std::optional<StatsServer>{};
+    try {
+        if (stats_port) {
+            stats_server.emplace(io_context, *stats_port, metrics);
+        }
+        if (subscribe_port) {
+            subscriber_server.emplace(io_context,
+                                      make_acceptor(io_context, *subscribe_port, false),
+                                      *subscribers,
+                                      options.names,
+                                      options.format,
+                                      output);
+        }
+        if (!shards) {
+            server.emplace(io_context, make_acceptor(io_context, port, false), output, options);
+        }
+        for (auto i = 0u; i < shards.value_or(0); ++i) {
+            sharded.push_back(std::make_unique<Shard>(port, output, options));
+        }
+    } catch (const std::system_error& ex) {
+        std::cerr << "Unable to listen: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
 
-    auto server = Server{io_context, port};
+    // Stop on interrupt so that buffered records are written before exiting
+    auto signals = asio::signal_set{io_context, SIGINT, SIGTERM};
+    signals.async_wait([&io_context, &sharded](const std::error_code&, int) {
+        for (auto& shard : sharded) {
+            shard->stop();
+        }
+        io_context.stop();
+    });
 
     std::cerr << "Starting logger on port " << port << "\n";
 
+    auto pool = std::vector<std::thread>{};
+    for (auto i = 1u; i < threads; ++i) {
+        pool.emplace_back([&io_context]() { io_context.run(); });
+    }
+
+    const auto cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    for (auto i = 0u; i < sharded.size(); ++i) {
+        pool.emplace_back([&shard = *sharded[i], cpu = i % cpus]() { shard.run(cpu); });
+    }
+
     io_context.run();
 
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    // Windows still open on exit are written, even though later messages could have been added
+    if (aggregator) {
+        aggregator->flush();
+    }
+    if (merger) {
+        merger->flush();
+    }
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,198 @@
+#include "merger.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace logger {
+
+namespace {
+
+/// Orders heap nodes so that the earliest record is at the front
+template <class Node>
+auto later(const Node& a, const Node& b) noexcept -> bool {
+    return a.timestamp != b.timestamp ? a.timestamp > b.timestamp : a.sequence > b.sequence;
+}
+
+} // namespace
+
+Merger::Merger(std::chrono::milliseconds window, sink_type sink, late_handler_type on_late)
+    : window_{window}, sink_{std::move(sink)}, on_late_{std::move(on_late)} {}
+
+auto Merger::open() -> source {
+    return {*this, std::make_shared<run>()};
+}
+
+auto Merger::add(const std::shared_ptr<run>& r, std::string_view record, const record_info& info)
+    -> void {
+    auto lock = std::unique_lock<std::mutex>{mutex_};
+
+    if (!info.timestamp) {
+        write(record, info);
+        drain(lock);
+        return;
+    }
+
+    const auto timestamp = *info.timestamp;
+    active_ = true;
+
+    // The system clock is only read for records which would advance the watermark
+    const auto ahead =
+        (!latest_ || timestamp > *latest_) && timestamp > clock_t::now() + window_;
+    const auto behind = released_ && timestamp < *released_;
+    if (ahead || behind) {
+        write(record, info);
+        late_.fetch_add(1, std::memory_order_relaxed);
+        ++unreported_late_;
+        if (behind) {
+            unreported_behind_ = std::max(
+                unreported_behind_,
+                std::chrono::duration_cast<std::chrono::milliseconds>(*released_ - timestamp));
+        }
+        drain(lock);
+        return;
+    }
+
+    auto e = entry{timestamp, sequence_++, storage(), record.size()};
+    e.data.append(record).append(info.name);
+
+    // A record is usually the latest of its run, otherwise it is inserted after the records
+    // with the same or an earlier timestamp
+    auto& entries = r->entries;
+    if (entries.empty() || !(timestamp < entries.back().timestamp)) {
+        entries.push_back(std::move(e));
+    } else {
+        const auto position = std::upper_bound(
+            entries.begin(), entries.end(), timestamp, [](time_point_t t, const entry& other) {
+                return t < other.timestamp;
+            });
+        entries.insert(position, std::move(e));
+    }
+    buffered_.fetch_add(1, std::memory_order_relaxed);
+
+    if (entries.front().sequence == sequence_ - 1) {
+        push(r);
+    }
+
+    latest_ = latest_ ? std::max(*latest_, timestamp) : timestamp;
+    release(*latest_ - window_);
+    drain(lock);
+}
+
+auto Merger::expire() -> void {
+    auto lock = std::unique_lock<std::mutex>{mutex_};
+
+    if (!active_) {
+        release(time_point_t::max());
+    }
+    active_ = false;
+
+    drain(lock);
+    report_late(lock);
+}
+
+auto Merger::flush() -> void {
+    auto lock = std::unique_lock<std::mutex>{mutex_};
+    release(time_point_t::max());
+
+    // Another thread may be writing records released before
+    drain(lock);
+    drained_.wait(lock, [this]() { return !draining_; });
+    report_late(lock);
+}
+
+auto Merger::push(const std::shared_ptr<run>& r) -> void {
+    const auto& earliest = r->entries.front();
+    heap_.push_back({earliest.timestamp, earliest.sequence, ++r->generation, r});
+    std::push_heap(heap_.begin(), heap_.end(), later<node>);
+}
+
+auto Merger::release(time_point_t watermark) -> void {
+    while (!heap_.empty()) {
+        const auto& top = heap_.front();
+
+        // Skip nodes replaced after a record was inserted before the earliest one
+        if (top.generation != top.r->generation) {
+            std::pop_heap(heap_.begin(), heap_.end(), later<node>);
+            heap_.pop_back();
+            continue;
+        }
+
+        if (top.timestamp > watermark) {
+            return;
+        }
+
+        std::pop_heap(heap_.begin(), heap_.end(), later<node>);
+        const auto r = std::move(heap_.back().r);
+        heap_.pop_back();
+
+        auto& earliest = r->entries.front();
+        queued_.push_back({std::move(earliest.data), earliest.record_size, earliest.timestamp});
+        released_ = earliest.timestamp;
+
+        r->entries.pop_front();
+        buffered_.fetch_sub(1, std::memory_order_relaxed);
+
+        if (!r->entries.empty()) {
+            push(r);
+        }
+    }
+}
+
+auto Merger::write(std::string_view record, const record_info& info) -> void {
+    auto data = storage();
+    data.append(record).append(info.name);
+    queued_.push_back({std::move(data), record.size(), info.timestamp});
+}
+
+auto Merger::drain(std::unique_lock<std::mutex>& lock) -> void {
+    // The writing thread also writes records queued while it was writing, preserving their order
+    if (draining_) {
+        return;
+    }
+    draining_ = true;
+
+    while (!queued_.empty()) {
+        writing_.swap(queued_);
+
+        lock.unlock();
+        for (const auto& record : writing_) {
+            const auto data = std::string_view{record.data};
+            sink_(data.substr(0, record.record_size),
+                  {data.substr(record.record_size), record.timestamp});
+        }
+        lock.lock();
+
+        for (auto& record : writing_) {
+            if (spare_.size() < max_spare) {
+                spare_.push_back(std::move(record.data));
+            }
+        }
+        writing_.clear();
+    }
+
+    draining_ = false;
+    drained_.notify_all();
+}
+
+auto Merger::report_late(std::unique_lock<std::mutex>& lock) -> void {
+    const auto count = std::exchange(unreported_late_, 0);
+    const auto behind = std::exchange(unreported_behind_, std::chrono::milliseconds{0});
+    lock.unlock();
+
+    if (count > 0 && on_late_) {
+        on_late_(count, behind);
+    }
+}
+
+auto Merger::storage() -> std::string {
+    if (spare_.empty()) {
+        return {};
+    }
+
+    auto data = std::move(spare_.back());
+    spare_.pop_back();
+    data.clear();
+    return data;
+}
+
+} // namespace logger
@@ -1,10 +1,10 @@
 #include "message.h"
 
-#include "compat/endian.h"
+#include "timestamp.h"
+#include "utf8.h"
 
 #include <cstdint>
-#include <iomanip>
-#include <sstream>
+#include <ostream>
 
 namespace reader {
 
@@ -21,100 +21,149 @@ auto operator<<(std::ostream& out, const std::optional<T>& t) -> std::ostream& {
 
 auto operator<<(std::ostream& out, const reader::Message::time_point_t& timestamp)
     -> std::ostream& {
-    constexpr auto iso_8601_date_time = "%FT%T";
-    constexpr auto iso_8601_timezone = "%z";
+    char buffer[max_timestamp_size];
+    const auto end = format_timestamp(timestamp, buffer);
 
-    const auto time = reader::Message::clock_t::to_time_t(timestamp);
-    const auto localtime = std::localtime(&time);
+    return out.write(buffer, end - buffer);
+}
 
-    const auto milliseconds =
-        std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()) % 1000;
+namespace {
 
-    out << std::put_time(localtime, iso_8601_date_time);
-    out << '.' << std::setfill('0') << std::setw(3) << milliseconds.count();
-    out << std::put_time(localtime, iso_8601_timezone);
+using schema = wire::message_schema;
 
-    return out;
+auto decode_timestamp(const unsigned char* data) noexcept -> Message::time_point_t {
+    return Message::time_point_t{
+        std::chrono::milliseconds{static_cast<int64_t>(schema::timestamp::read(data))}};
 }
 
-Message::Message(asio::const_buffer wire_data) {
-    constexpr auto minimum_message_size = wire_size::timestamp + wire_size::nlen;
-    if (wire_data.size() < minimum_message_size) {
-        throw bad_message_data{"`wire_data` is smaller than the message minimum size."};
-    };
-
-    const auto timestamp_buffer = asio::buffer(wire_data, wire_size::timestamp);
+auto decode_temperature(const unsigned char* data) noexcept -> float {
+    // converts hundredths of K to C
+    const auto convert_unit = [](float f) { return f / 100.0f - 273.15f; };
 
-    auto offset = timestamp_buffer.size();
-    const auto nlen = aux::buffer_cast<uint8_t>(asio::buffer(wire_data + offset, wire_size::nlen));
+    return convert_unit(static_cast<float>(schema::temperature::read(data)));
+}
 
-    offset += wire_size::nlen;
-    const auto name_buffer = asio::buffer(wire_data + offset, nlen);
+auto decode_humidity(const unsigned char* data) noexcept -> float {
+    // converts relative humidity in ‰ to %
+    const auto convert_unit = [](float f) { return f / 10.0f; };
 
-    offset += name_buffer.size();
-    const auto temperature_buffer = asio::buffer(wire_data + offset, wire_size::temperature);
+    return convert_unit(static_cast<float>(schema::humidity::read(data)));
+}
 
-    if (temperature_buffer.size() == wire_size::temperature) {
-        offset += temperature_buffer.size();
+} // namespace
+
+auto describe(asio::const_buffer wire_data, decode_error error) -> std::string {
+    switch (error) {
+        case decode_error::too_small:
+            return "`wire_data` is smaller than the message minimum size.";
+        case decode_error::name_overrun:
+            return "The value of `nlen` results in overrun of `wire_data` on decode.";
+        case decode_error::unused_bytes:
+            return "`wire_data` contains unused bytes after message decode.";
+        case decode_error::invalid_name: {
+            const auto data = static_cast<const unsigned char*>(wire_data.data());
+            return describe_invalid_utf8(
+                {reinterpret_cast<const char*>(data + schema::name_data_offset),
+                 schema::name::read_size(data + schema::name_offset)});
+        }
     }
-    const auto humidity_buffer = asio::buffer(wire_data + offset);
-
-    set_timestamp(timestamp_buffer);
+    return {};
+}
 
-    if (name_buffer.size() != nlen) {
-        throw bad_message_data{"The value of `nlen` results in overrun of `wire_data` on decode."};
+auto try_decode_view(asio::const_buffer wire_data) noexcept
+    -> nonstd::expected<MessageView, decode_error> {
+    const auto data = static_cast<const unsigned char*>(wire_data.data());
+
+    auto layout = wire::message_layout{};
+    if (const auto error = wire::validate(data, wire_data.size(), layout)) {
+        switch (*error) {
+            case wire::layout_error::too_small:
+                return nonstd::make_unexpected(decode_error::too_small);
+            case wire::layout_error::name_overrun:
+                return nonstd::make_unexpected(decode_error::name_overrun);
+            case wire::layout_error::unused_bytes:
+                return nonstd::make_unexpected(decode_error::unused_bytes);
+        }
     }
-    set_name(name_buffer);
 
-    if (temperature_buffer.size() == wire_size::temperature) {
-        set_temperature(temperature_buffer);
+    const auto message = MessageView{data, layout};
+    if (!is_valid_utf8(message.name())) {
+        return nonstd::make_unexpected(decode_error::invalid_name);
     }
 
-    if (humidity_buffer.size() == wire_size::humidity) {
-        set_humidity(humidity_buffer);
-    } else if (const auto n = humidity_buffer.size(); n > 0 && n != wire_size::humidity) {
-        throw bad_message_data{"`wire_data` contains unused bytes after message decode."};
-    }
+    return message;
 }
 
-auto Message::set_timestamp(asio::const_buffer wire_data) -> void {
-    timestamp_ =
-        time_point_t{std::chrono::milliseconds{be64toh(aux::buffer_cast<uint64_t>(wire_data))}};
-}
+auto try_decode(asio::const_buffer wire_data) -> nonstd::expected<Message, decode_error> {
+    const auto view = try_decode_view(wire_data);
+    if (!view) {
+        return nonstd::make_unexpected(view.error());
+    }
 
-auto Message::set_name(asio::const_buffer wire_data) -> void {
-    name_ = std::string{static_cast<const char*>(wire_data.data()), wire_data.size()};
+    return Message{*view};
 }
 
-auto Message::set_temperature(asio::const_buffer wire_data) -> void {
-    // converts hundredths of K to C
-    const auto convert_unit = [](float f) { return f / 100.0f - 273.15f; };
+MessageView::MessageView(asio::const_buffer wire_data)
+    : MessageView{[wire_data]() {
+          const auto view = try_decode_view(wire_data);
+          if (!view) {
+              if (view.error() == decode_error::invalid_name) {
+                  throw bad_string_data{describe(wire_data, view.error())};
+              }
+              throw bad_message_data{describe(wire_data, view.error()).c_str()};
+          }
+          return *view;
+      }()} {}
+
+MessageView::MessageView(const unsigned char* data, wire::message_layout layout) noexcept
+    : data_{data}, layout_{layout} {}
+
+auto MessageView::timestamp() const noexcept -> time_point_t {
+    return decode_timestamp(data_);
+}
 
-    uint32_t temp_be;
-    std::memcpy(&temp_be, wire_data.data(), wire_data.size());
+auto MessageView::name() const noexcept -> std::string_view {
+    return {reinterpret_cast<const char*>(data_ + schema::name_data_offset), layout_.name_size};
+}
 
-    auto temp_he = be32toh(temp_be);
+auto MessageView::temperature() const noexcept -> std::optional<float> {
+    constexpr auto field = schema::temperature_field;
+    if (!((layout_.present >> field) & 1)) {
+        return std::nullopt;
+    }
+    const auto trailing = data_ + schema::name_data_offset + layout_.name_size;
+    return decode_temperature(trailing + schema::trailing_fields::offset<field>(layout_.present));
+}
 
-    // Temperature is only 3 bytes, not 4. We need to shift if the machine is little endian.
-    if (temp_he != temp_be) {
-        temp_he >>= 8;
+auto MessageView::humidity() const noexcept -> std::optional<float> {
+    constexpr auto field = schema::humidity_field;
+    if (!((layout_.present >> field) & 1)) {
+        return std::nullopt;
     }
+    const auto trailing = data_ + schema::name_data_offset + layout_.name_size;
+    return decode_humidity(trailing + schema::trailing_fields::offset<field>(layout_.present));
+}
 
-    temperature_ = convert_unit(static_cast<float>(temp_he));
+auto MessageView::as_json() const -> nlohmann::json {
+    return *this;
 }
 
-auto Message::set_humidity(asio::const_buffer wire_data) -> void {
-    // converts relative humidity in ‰ to %
-    const auto convert_unit = [](float f) { return f / 10.0f; };
+Message::Message(asio::const_buffer wire_data) : Message{MessageView{wire_data}} {}
 
-    humidity_ = convert_unit(static_cast<float>(be16toh(aux::buffer_cast<uint16_t>(wire_data))));
-}
+Message::Message(const MessageView& view)
+    : timestamp_{view.timestamp()},
+      name_{view.name()},
+      temperature_{view.temperature()},
+      humidity_{view.humidity()} {}
 
 auto Message::as_json() const -> nlohmann::json {
     return *this;
 }
 
-auto operator<<(std::ostream& out, const Message& message) -> std::ostream& {
+namespace {
+
+template <class M>
+auto write_message(std::ostream& out, const M& message) -> std::ostream& {
     out << "Message {\n";
     out << "  timestamp: " << message.timestamp() << "\n";
     out << "  name: " << message.name() << "\n";
@@ -125,12 +174,41 @@ auto operator<<(std::ostream& out, const Message& message) -> std::ostream& {
     return out;
 }
 
+template <class M>
+void write_json(nlohmann::json& j, const M& message) {
+    char timestamp[max_timestamp_size];
+    const auto timestamp_end = format_timestamp(message.timestamp(), timestamp);
+
+    j = nlohmann::json{
+        {"timestamp", std::string{timestamp, timestamp_end}},
+        {"name", message.name()},
+    };
+
+    if (const auto t = message.temperature()) {
+        j["temperature"] = *t;
+    }
+
+    if (const auto h = message.humidity()) {
+        j["humidity"] = *h;
+    }
+}
+
+} // namespace
+
+auto operator<<(std::ostream& out, const Message& message) -> std::ostream& {
+    return write_message(out, message);
+}
+
+auto operator<<(std::ostream& out, const MessageView& message) -> std::ostream& {
+    return write_message(out, message);
+}
+
 auto decode_message_length(asio::const_buffer wire_data) -> uint32_t {
     if (wire_data.size() != wire_size::message_length) {
         throw bad_message_data{"`wire_data` size does not match message length size."};
     }
 
-    return be32toh(aux::buffer_cast<uint32_t>(wire_data));
+    return schema::length::read(static_cast<const unsigned char*>(wire_data.data()));
 }
 
 auto decode_message_payload_length(asio::const_buffer wire_data) -> uint32_t {
@@ -138,21 +216,11 @@ auto decode_message_payload_length(asio::const_buffer wire_data) -> uint32_t {
 }
 
 void to_json(nlohmann::json& j, const Message& message) {
-    auto ss = std::stringstream{};
-    ss << message.timestamp();
-
-    j = nlohmann::json{
-        {"timestamp", ss.str()},
-        {"name", message.name()},
-    };
-
-    if (const auto t = message.temperature()) {
-        j["temperature"] = *t;
-    }
+    write_json(j, message);
+}
 
-    if (const auto h = message.humidity()) {
-        j["humidity"] = *h;
-    }
+void to_json(nlohmann::json& j, const MessageView& message) {
+    write_json(j, message);
 }
 
 } // namespace reader
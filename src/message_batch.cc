@@ -0,0 +1,307 @@
+#include "message_batch.h"
+
+#include "utf8.h"
+#include "wire.h"
+
+#include <cstring>
+
+#ifdef RECORDER_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace reader {
+
+namespace {
+
+using schema = wire::message_schema;
+
+// The unit conversions divide rather than multiply by a reciprocal, so that every implementation
+// rounds exactly like the per-message decoding in message.cc.
+
+/// Converts hundredths of K to °C
+constexpr auto temperature_scale = 100.0f;
+constexpr auto temperature_offset = 273.15f;
+
+/// Converts ‰ to %
+constexpr auto humidity_scale = 10.0f;
+
+auto convert_temperatures_scalar(const unsigned char* packed,
+                                 std::size_t count,
+                                 float* out) noexcept -> void {
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        const auto value = static_cast<float>(schema::temperature::read(packed + 3 * i));
+        out[i] = value / temperature_scale - temperature_offset;
+    }
+}
+
+auto convert_humidities_scalar(const unsigned char* packed,
+                               std::size_t count,
+                               float* out) noexcept -> void {
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        out[i] = static_cast<float>(schema::humidity::read(packed + 2 * i)) / humidity_scale;
+    }
+}
+
+#ifdef RECORDER_SIMD_X86
+
+// Each kernel converts as many values as it can without reading past the end of the column and
+// returns the number converted. The remainder is converted by the scalar implementation.
+
+/// @brief Moves 3-byte big-endian values to the low bytes of 32-bit lanes
+[[gnu::target("sse4.1")]] auto unpack_24_mask() noexcept -> __m128i {
+    return _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+}
+
+/// @brief Swaps the bytes of 16-bit lanes
+[[gnu::target("sse4.1")]] auto swap_16_mask() noexcept -> __m128i {
+    return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+}
+
+[[gnu::target("sse4.1")]] auto convert_temperatures_sse4(const unsigned char* packed,
+                                                         std::size_t count,
+                                                         float* out) noexcept -> std::size_t {
+    const auto scale = _mm_set1_ps(temperature_scale);
+    const auto offset = _mm_set1_ps(temperature_offset);
+
+    // Converts 4 values at a time from a load of 16 bytes
+    auto i = std::size_t{0};
+    for (; 3 * (count - i) >= sizeof(__m128i); i += 4) {
+        const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + 3 * i));
+        const auto values = _mm_cvtepi32_ps(_mm_shuffle_epi8(input, unpack_24_mask()));
+        _mm_storeu_ps(out + i, _mm_sub_ps(_mm_div_ps(values, scale), offset));
+    }
+    return i;
+}
+
+[[gnu::target("sse4.1")]] auto convert_humidities_sse4(const unsigned char* packed,
+                                                       std::size_t count,
+                                                       float* out) noexcept -> std::size_t {
+    const auto scale = _mm_set1_ps(humidity_scale);
+
+    auto i = std::size_t{0};
+    for (; i + 8 <= count; i += 8) {
+        const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + 2 * i));
+        const auto swapped = _mm_shuffle_epi8(input, swap_16_mask());
+        const auto low = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(swapped));
+        const auto high = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(swapped, 8)));
+        _mm_storeu_ps(out + i, _mm_div_ps(low, scale));
+        _mm_storeu_ps(out + i + 4, _mm_div_ps(high, scale));
+    }
+    return i;
+}
+
+[[gnu::target("avx2")]] auto convert_temperatures_avx2(const unsigned char* packed,
+                                                       std::size_t count,
+                                                       float* out) noexcept -> std::size_t {
+    const auto mask = _mm256_broadcastsi128_si256(unpack_24_mask());
+    const auto scale = _mm256_set1_ps(temperature_scale);
+    const auto offset = _mm256_set1_ps(temperature_offset);
+
+    // Converts 8 values at a time from two loads of 16 bytes, 12 bytes apart, as byte shuffles
+    // operate within 128-bit lanes
+    auto i = std::size_t{0};
+    for (; 3 * (count - i) >= 12 + sizeof(__m128i); i += 8) {
+        const auto p = packed + 3 * i;
+        const auto input = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)),
+            1);
+        const auto values = _mm256_cvtepi32_ps(_mm256_shuffle_epi8(input, mask));
+        _mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_div_ps(values, scale), offset));
+    }
+    return i + convert_temperatures_sse4(packed + 3 * i, count - i, out + i);
+}
+
+[[gnu::target("avx2")]] auto convert_humidities_avx2(const unsigned char* packed,
+                                                     std::size_t count,
+                                                     float* out) noexcept -> std::size_t {
+    const auto mask = _mm256_broadcastsi128_si256(swap_16_mask());
+    const auto scale = _mm256_set1_ps(humidity_scale);
+
+    auto i = std::size_t{0};
+    for (; i + 16 <= count; i += 16) {
+        const auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + 2 * i));
+        const auto swapped = _mm256_shuffle_epi8(input, mask);
+        const auto low =
+            _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(swapped)));
+        const auto high =
+            _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(swapped, 1)));
+        _mm256_storeu_ps(out + i, _mm256_div_ps(low, scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_div_ps(high, scale));
+    }
+    return i + convert_humidities_sse4(packed + 2 * i, count - i, out + i);
+}
+
+#endif
+
+/// @brief Copies a field in wire format to a column
+/// @tparam Field Position of the field in `schema::trailing_fields`
+/// @param trailing The trailing fields of a payload
+/// @param present The trailing fields present
+/// @param index Index of the message in the batch
+template <std::size_t Field, class Type>
+auto gather(const unsigned char* trailing,
+            std::uint8_t present,
+            std::size_t index,
+            std::vector<unsigned char>& packed,
+            std::vector<std::uint64_t>& bitmap) noexcept -> void {
+    const auto out = packed.data() + index * Type::size;
+    if ((present >> Field) & 1) {
+        std::memcpy(out, trailing + schema::trailing_fields::offset<Field>(present), Type::size);
+        bitmap[index / 64] |= std::uint64_t{1} << (index % 64);
+    } else {
+        std::memset(out, 0, Type::size);
+    }
+}
+
+/// @brief Counts the complete frames at the start of a buffer, without validating them
+auto count_frames(const unsigned char* data, std::size_t size) noexcept -> std::size_t {
+    auto count = std::size_t{0};
+    auto offset = std::size_t{0};
+    while (size - offset >= schema::length::size) {
+        const auto length = schema::length::read(data + offset);
+        if (length < schema::length::size || length > size - offset) {
+            break;
+        }
+        offset += length;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+auto convert_temperatures(const unsigned char* packed,
+                          std::size_t count,
+                          float* out,
+                          simd_isa isa) noexcept -> void {
+    auto converted = std::size_t{0};
+    switch (isa) {
+#ifdef RECORDER_SIMD_X86
+    case simd_isa::avx2:
+        converted = convert_temperatures_avx2(packed, count, out);
+        break;
+    case simd_isa::sse4:
+        converted = convert_temperatures_sse4(packed, count, out);
+        break;
+#endif
+    default:
+        break;
+    }
+    convert_temperatures_scalar(packed + 3 * converted, count - converted, out + converted);
+}
+
+auto convert_humidities(const unsigned char* packed,
+                        std::size_t count,
+                        float* out,
+                        simd_isa isa) noexcept -> void {
+    auto converted = std::size_t{0};
+    switch (isa) {
+#ifdef RECORDER_SIMD_X86
+    case simd_isa::avx2:
+        converted = convert_humidities_avx2(packed, count, out);
+        break;
+    case simd_isa::sse4:
+        converted = convert_humidities_sse4(packed, count, out);
+        break;
+#endif
+    default:
+        break;
+    }
+    convert_humidities_scalar(packed + 2 * converted, count - converted, out + converted);
+}
+
+auto MessageBatch::row::timestamp() const noexcept -> time_point_t {
+    return time_point_t{std::chrono::milliseconds{batch_->timestamps_[index_]}};
+}
+
+auto MessageBatch::row::name() const noexcept -> std::string_view {
+    return {reinterpret_cast<const char*>(batch_->data_ + batch_->name_offsets_[index_]),
+            batch_->name_sizes_[index_]};
+}
+
+auto MessageBatch::row::temperature() const noexcept -> std::optional<float> {
+    if (!batch_->has_temperature(index_)) {
+        return std::nullopt;
+    }
+    return batch_->temperatures_[index_];
+}
+
+auto MessageBatch::row::humidity() const noexcept -> std::optional<float> {
+    if (!batch_->has_humidity(index_)) {
+        return std::nullopt;
+    }
+    return batch_->humidities_[index_];
+}
+
+MessageBatch::MessageBatch() : MessageBatch{[]() {
+    static const auto isa = best_simd_isa();
+    return isa;
+}()} {}
+
+MessageBatch::MessageBatch(simd_isa isa) noexcept : isa_{isa} {}
+
+auto MessageBatch::decode(asio::const_buffer frames) -> std::size_t {
+    data_ = static_cast<const unsigned char*>(frames.data());
+
+    // Columns are sized for every complete frame up front, and truncated to the frames decoded
+    const auto capacity = count_frames(data_, frames.size());
+    resize(capacity);
+    temperature_present_.assign((capacity + bitmap_word_bits - 1) / bitmap_word_bits, 0);
+    humidity_present_.assign(temperature_present_.size(), 0);
+
+    auto count = std::size_t{0};
+    auto offset = std::size_t{0};
+    for (; count < capacity; ++count) {
+        const auto frame = data_ + offset;
+        const auto length = schema::length::read(frame);
+        const auto payload = frame + schema::length::size;
+
+        auto layout = wire::message_layout{};
+        if (wire::validate(payload, length - schema::length::size, layout)) {
+            break;
+        }
+
+        const auto name = std::string_view{
+            reinterpret_cast<const char*>(payload + schema::name_data_offset), layout.name_size};
+        if (!is_valid_utf8(name)) {
+            break;
+        }
+
+        store(count, payload, layout.name_size, layout.present);
+        offset += length;
+    }
+    resize(count);
+
+    convert_temperatures(packed_temperatures_.data(), count, temperatures_.data(), isa_);
+    convert_humidities(packed_humidities_.data(), count, humidities_.data(), isa_);
+
+    return offset;
+}
+
+auto MessageBatch::resize(std::size_t count) -> void {
+    timestamps_.resize(count);
+    name_offsets_.resize(count);
+    name_sizes_.resize(count);
+    packed_temperatures_.resize(count * schema::temperature::size);
+    packed_humidities_.resize(count * schema::humidity::size);
+    temperatures_.resize(count);
+    humidities_.resize(count);
+}
+
+auto MessageBatch::store(std::size_t index,
+                         const unsigned char* payload,
+                         std::uint8_t name_size,
+                         std::uint8_t present) noexcept -> void {
+    timestamps_[index] = static_cast<std::int64_t>(schema::timestamp::read(payload));
+    name_offsets_[index] = static_cast<std::size_t>(payload + schema::name_data_offset - data_);
+    name_sizes_[index] = name_size;
+
+    const auto trailing = payload + schema::name_data_offset + name_size;
+    gather<schema::temperature_field, schema::temperature>(
+        trailing, present, index, packed_temperatures_, temperature_present_);
+    gather<schema::humidity_field, schema::humidity>(
+        trailing, present, index, packed_humidities_, humidity_present_);
+}
+
+} // namespace reader
@@ -0,0 +1,178 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace logger {
+
+auto Histogram::record(std::uint64_t value, std::uint64_t n) noexcept -> void {
+    counts_[bucket_index(value)].fetch_add(n, std::memory_order_relaxed);
+    count_.fetch_add(n, std::memory_order_relaxed);
+
+    auto max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+auto Histogram::merge(const Histogram& other) noexcept -> void {
+    for (auto i = std::size_t{}; i < bucket_count; ++i) {
+        const auto n = other.counts_[i].load(std::memory_order_relaxed);
+        if (n > 0) {
+            counts_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.count(), std::memory_order_relaxed);
+
+    const auto value = other.max();
+    auto max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+auto Histogram::percentile(double fraction) const noexcept -> std::uint64_t {
+    const auto total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    const auto rank = std::max(
+        std::uint64_t{1},
+        static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) *
+                                             static_cast<double>(total))));
+
+    auto seen = std::uint64_t{};
+    for (auto i = std::size_t{}; i < bucket_count; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucket_max(i), max());
+        }
+    }
+
+    return max();
+}
+
+auto Histogram::bucket_index(std::uint64_t value) noexcept -> std::size_t {
+    if (value < sub_buckets) {
+        return value;
+    }
+
+    // Values in [2^n, 2^(n+1)) are split into `sub_buckets` buckets of equal width
+    const auto msb = static_cast<unsigned>(63 - __builtin_clzll(value));
+    const auto shift = msb - sub_bucket_bits;
+    const auto mantissa = value >> shift;
+
+    return (shift + 1) * sub_buckets + (mantissa - sub_buckets);
+}
+
+auto Histogram::bucket_max(std::size_t index) noexcept -> std::uint64_t {
+    if (index < sub_buckets) {
+        return index;
+    }
+
+    const auto shift = index / sub_buckets - 1;
+    const auto mantissa = std::uint64_t{sub_buckets + index % sub_buckets};
+
+    // The largest bucket ends at the largest representable value
+    if (mantissa + 1 == 2 * sub_buckets && shift + sub_bucket_bits + 1 == 64) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+    return ((mantissa + 1) << shift) - 1;
+}
+
+auto Metrics::open(std::string endpoint) -> std::shared_ptr<connection_counters> {
+    auto counters = std::shared_ptr<connection_counters>{
+        new connection_counters{std::move(endpoint)}, [this](connection_counters* c) {
+            close(*c);
+            delete c;
+        }};
+
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+    connections_.push_back(counters.get());
+
+    return counters;
+}
+
+auto Metrics::gauge(std::string name, std::function<std::uint64_t()> read) -> void {
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+    gauges_.emplace_back(std::move(name), std::move(read));
+}
+
+auto Metrics::close(const connection_counters& counters) -> void {
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+    connections_.erase(std::find(connections_.begin(), connections_.end(), &counters));
+
+    ++closed_;
+    closed_messages_ += counters.messages.load(std::memory_order_relaxed);
+    closed_bytes_ += counters.bytes.load(std::memory_order_relaxed);
+    closed_decode_errors_ += counters.decode_errors.load(std::memory_order_relaxed);
+    closed_string_errors_ += counters.string_errors.load(std::memory_order_relaxed);
+    closed_filtered_ += counters.filtered.load(std::memory_order_relaxed);
+    closed_latencies_.merge(counters.latencies);
+}
+
+auto Metrics::latencies() const -> std::unique_ptr<latency_histograms> {
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+    return merged_latencies();
+}
+
+auto Metrics::merged_latencies() const -> std::unique_ptr<latency_histograms> {
+    auto merged = std::make_unique<latency_histograms>();
+    merged->merge(closed_latencies_);
+    for (const auto connection : connections_) {
+        merged->merge(connection->latencies);
+    }
+    return merged;
+}
+
+auto Metrics::report(std::ostream& out) const -> void {
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+
+    auto messages = closed_messages_;
+    auto bytes = closed_bytes_;
+    auto decode_errors = closed_decode_errors_;
+    auto string_errors = closed_string_errors_;
+    auto filtered = closed_filtered_;
+    for (const auto connection : connections_) {
+        messages += connection->messages.load(std::memory_order_relaxed);
+        bytes += connection->bytes.load(std::memory_order_relaxed);
+        decode_errors += connection->decode_errors.load(std::memory_order_relaxed);
+        string_errors += connection->string_errors.load(std::memory_order_relaxed);
+        filtered += connection->filtered.load(std::memory_order_relaxed);
+    }
+
+    out << "connections_open " << connections_.size() << "\n"
+        << "connections_closed " << closed_ << "\n"
+        << "messages " << messages << "\n"
+        << "bytes " << bytes << "\n"
+        << "decode_errors " << decode_errors << "\n"
+        << "string_errors " << string_errors << "\n"
+        << "filtered " << filtered << "\n";
+
+    for (const auto& [name, read] : gauges_) {
+        out << name << " " << read() << "\n";
+    }
+
+    const auto histogram = [&out](const char* name, const Histogram& h) {
+        out << name << " count=" << h.count() << " p50=" << h.percentile(0.5)
+            << " p90=" << h.percentile(0.9) << " p99=" << h.percentile(0.99)
+            << " p999=" << h.percentile(0.999) << " max=" << h.max() << "\n";
+    };
+    const auto latencies = merged_latencies();
+    histogram("decode_ns", latencies->decode_latency);
+    histogram("serialize_ns", latencies->serialize_latency);
+    histogram("write_ns", latencies->write_latency);
+    histogram("lag_ns", latencies->lag);
+
+    for (const auto connection : connections_) {
+        out << "connection " << connection->endpoint
+            << " messages=" << connection->messages.load(std::memory_order_relaxed)
+            << " bytes=" << connection->bytes.load(std::memory_order_relaxed)
+            << " decode_errors=" << connection->decode_errors.load(std::memory_order_relaxed)
+            << " string_errors=" << connection->string_errors.load(std::memory_order_relaxed)
+            << " filtered=" << connection->filtered.load(std::memory_order_relaxed)
+            << " buffered=" << connection->buffered.load(std::memory_order_relaxed) << "\n";
+    }
+}
+
+} // namespace logger
@@ -0,0 +1,60 @@
+#include "index.h"
+#include "mapped_file.h"
+#include "query.h"
+#include "timestamp.h"
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    constexpr auto usage = "usage: query [--name <name>] [--from <time>] [--to <time>]\n"
+                           "             [--index <file>] <log>\n";
+
+    auto options = logger::query_options{};
+    auto index_path = std::optional<std::string>{};
+    auto args = std::vector<const char*>{};
+    for (auto i = 1; i < argc; ++i) {
+        const auto arg = std::string_view{argv[i]};
+        if (arg == "--name" && i + 1 < argc) {
+            options.name = argv[++i];
+        } else if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+            const auto t = reader::parse_timestamp(argv[++i]);
+            if (!t) {
+                std::cerr << "Invalid timestamp: " << argv[i] << "\n";
+                return EXIT_FAILURE;
+            }
+            (arg == "--from" ? options.from : options.to) = *t;
+        } else if (arg == "--index" && i + 1 < argc) {
+            index_path = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() != 1) {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    std::ios_base::sync_with_stdio(false);
+
+    try {
+        const auto log = reader::MappedFile{args[0]};
+        const auto index_file = reader::MappedFile{index_path.value_or(std::string{args[0]} + ".idx")};
+        const auto index = logger::Index{index_file.data()};
+
+        logger::Query{log.data(), index, options, std::cout, std::cerr}.run();
+    } catch (const std::system_error& ex) {
+        std::cerr << "Unable to open " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    } catch (const logger::bad_index_data& ex) {
+        std::cerr << "Unable to decode index: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,77 +1,187 @@
+#include "client.h"
 #include "compat/asio.h"
+#include "spill_ring.h"
 
 #include <chrono>
-#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <system_error>
 
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
 namespace {
 using asio::ip::tcp;
 using asio::posix::stream_descriptor;
 
-/// Sends sensor data stream to a log server
-class Client {
+#ifdef __linux__
+/// Sends sensor data from a pipe to a log server without copying it to user space
+///
+/// Data is moved from the input pipe to the socket with `splice()`, so the reader only waits for
+/// readiness and never reads the data itself. As message boundaries are never seen, the
+/// connection cannot be resumed at a message boundary, so forwarding ends if it is lost.
+class SpliceClient {
   public:
-    Client(tcp::socket socket, stream_descriptor istream)
+    SpliceClient(tcp::socket socket, stream_descriptor istream)
         : socket_{std::move(socket)}, istream_{std::move(istream)} {
-        async_read_data();
+        socket_.native_non_blocking(true);
+        async_wait_data();
     }
 
   private:
-    /// @brief Writes the internal buffer to the log server, then posts a read
-    auto async_write_data() -> void {
-        asio::async_write(socket_, streambuf_, [this](std::error_code ec, std::size_t) {
+    /// @brief Waits until the input pipe has data, then forwards it
+    auto async_wait_data() -> void {
+        istream_.async_wait(stream_descriptor::wait_read, [this](std::error_code ec) {
             if (!ec) {
-                async_read_data();
+                splice_data();
             }
         });
     }
 
-    /// @brief Reads from the input stream until the internal buffer is full, then posts a write
-    auto async_read_data() -> void {
-        asio::async_read(istream_, streambuf_, [this](std::error_code ec, std::size_t) {
+    /// @brief Waits until the socket can accept data, then waits for data
+    auto async_wait_socket() -> void {
+        socket_.async_wait(tcp::socket::wait_write, [this](std::error_code ec) {
             if (!ec) {
-                async_write_data();
+                async_wait_data();
             }
         });
     }
 
-    /// Maximum size of the streambuf
-    static constexpr std::size_t bufsize = 16;
+    /// @brief Moves data from the input pipe to the socket until either would block
+    auto splice_data() -> void {
+        while (true) {
+            const auto n = ::splice(istream_.native_handle(),
+                                    nullptr,
+                                    socket_.native_handle(),
+                                    nullptr,
+                                    splice_size,
+                                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+            if (n > 0 || (n == -1 && errno == EINTR)) {
+                continue;
+            }
+
+            if (n == -1 && errno == EAGAIN) {
+                // Either the pipe is empty or the socket is full. Waiting on the socket first
+                // returns immediately in the former case.
+                async_wait_socket();
+            } else if (n == -1) {
+                std::cerr << "Unable to forward data: " << std::strerror(errno) << "\n";
+            }
+
+            // End of input
+            return;
+        }
+    }
+
+    /// Maximum number of bytes moved by a single splice
+    static constexpr std::size_t splice_size = 64 * 1024;
 
     /// Socket to remote log server
     tcp::socket socket_;
 
     /// Input data stream
     stream_descriptor istream_;
-
-    /// Internal buffer for forwarding from the input data stream to the log server
-    asio::streambuf streambuf_{bufsize};
 };
+
+/// @brief Checks if a file descriptor refers to a pipe
+auto is_pipe(int fd) -> bool {
+    struct stat st {};
+    return (::fstat(fd, &st) == 0) && S_ISFIFO(st.st_mode);
+}
+#endif
+
+auto usage() -> void {
+    std::cerr << "usage: reader [--splice | --spill <file> [--spill-size <MiB>]] <host> <port>\n";
+}
 } // namespace
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "usage: reader <host> <port>\n";
+    auto spill_path = std::string{};
+    auto spill_size = std::size_t{64};
+    auto splice = false;
+
+    auto arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        const auto option = std::string_view{argv[arg]};
+        if (option == "--splice") {
+            splice = true;
+            continue;
+        }
+        if (arg + 1 == argc) {
+            usage();
+            return EXIT_FAILURE;
+        }
+
+        if (option == "--spill") {
+            spill_path = argv[++arg];
+        } else if (option == "--spill-size") {
+            try {
+                spill_size = std::stoul(argv[++arg]);
+            } catch (const std::logic_error&) {
+                usage();
+                return EXIT_FAILURE;
+            }
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - arg != 2 || (splice && !spill_path.empty())) {
+        usage();
         return EXIT_FAILURE;
     }
+    const auto host = argv[arg];
+    const auto port = argv[arg + 1];
+
+    auto spill = std::unique_ptr<reader::SpillRing>{};
+    if (!spill_path.empty()) {
+        try {
+            spill = std::make_unique<reader::SpillRing>(spill_path, spill_size * 1024 * 1024);
+        } catch (const std::system_error& ex) {
+            std::cerr << "Unable to create spill file: " << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
 
     auto io_context = asio::io_context{};
 
     auto istream = asio::posix::stream_descriptor{io_context, STDIN_FILENO};
 
     auto socket = asio::ip::tcp::socket{io_context};
+    auto endpoints = asio::ip::tcp::resolver::results_type{};
     try {
-        asio::connect(socket, asio::ip::tcp::resolver{io_context}.resolve(argv[1], argv[2]));
+        endpoints = asio::ip::tcp::resolver{io_context}.resolve(host, port);
+        asio::connect(socket, endpoints);
     } catch (const std::system_error& ex) {
-        std::cerr << "Unable to connect to " << argv[1] << ":" << argv[2] << "\n";
+        std::cerr << "Unable to connect to " << host << ":" << port << "\n";
         std::cerr << ex.what() << "\n";
         std::cerr << "Is a log server running?\n";
 
         return EXIT_FAILURE;
     }
 
-    auto client = Client{std::move(socket), std::move(istream)};
+    // Only one of these is used. Piped input is only spliced if requested, as the SpliceClient
+    // does not reconnect to the log server.
+    auto client = std::optional<reader::Client>{};
+#ifdef __linux__
+    auto splice_client = std::optional<SpliceClient>{};
+    if (splice && is_pipe(STDIN_FILENO)) {
+        splice_client.emplace(std::move(socket), std::move(istream));
+    } else
+#endif
+    {
+        client.emplace(std::move(socket), std::move(istream), endpoints, std::move(spill));
+    }
 
     while (io_context.run_for(std::chrono::seconds{5}) == 0) {
         std::cerr << "No data has been received. Please check your configuration.\n";
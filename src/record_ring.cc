@@ -0,0 +1,87 @@
+#include "record_ring.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace logger {
+
+RecordRing::RecordRing(record_ring_options options) : options_{options} {}
+
+auto RecordRing::publish(std::string_view record) -> void {
+    auto ready = std::vector<waiter>{};
+    {
+        const auto lock = std::lock_guard<std::mutex>{mutex_};
+        open_.append(record).push_back('\n');
+
+        if (open_.size() >= options_.chunk_size || !waiters_.empty()) {
+            seal();
+            ready.swap(waiters_);
+        }
+    }
+
+    for (auto& on_ready : ready) {
+        on_ready();
+    }
+}
+
+auto RecordRing::end() -> sequence {
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+
+    // Records already published are sealed so that they are not read from the returned cursor
+    if (!open_.empty()) {
+        seal();
+    }
+    return begin_ + chunks_.size();
+}
+
+auto RecordRing::read(sequence& cursor,
+                      std::vector<chunk>& out,
+                      std::size_t max_chunks,
+                      waiter on_ready) -> std::uint64_t {
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+
+    auto skipped = std::uint64_t{0};
+    const auto skip_dropped = [&]() {
+        if (cursor < begin_) {
+            skipped += begin_ - cursor;
+            skipped_.fetch_add(begin_ - cursor, std::memory_order_relaxed);
+            cursor = begin_;
+        }
+    };
+    skip_dropped();
+
+    // A reader which reads up to the last chunk also takes the open chunk rather than waiting for
+    // it to fill
+    const auto end = begin_ + chunks_.size();
+    if (cursor + max_chunks > end) {
+        if (!open_.empty()) {
+            seal();
+
+            // Sealing a full ring drops the oldest chunk, which may be the next one to read
+            skip_dropped();
+        } else if (cursor == end) {
+            waiters_.push_back(std::move(on_ready));
+            return skipped;
+        }
+    }
+
+    const auto first = chunks_.cbegin() + static_cast<std::ptrdiff_t>(cursor - begin_);
+    const auto count =
+        std::min(max_chunks, static_cast<std::size_t>(chunks_.cend() - first));
+    out.insert(out.end(), first, first + static_cast<std::ptrdiff_t>(count));
+    cursor += count;
+
+    return skipped;
+}
+
+auto RecordRing::seal() -> void {
+    chunks_.push_back(std::make_shared<const std::string>(std::move(open_)));
+    open_.clear();
+
+    if (chunks_.size() > options_.capacity) {
+        chunks_.pop_front();
+        ++begin_;
+    }
+}
+
+} // namespace logger
@@ -0,0 +1,446 @@
+#include "compat/asio.h"
+#include "mapped_file.h"
+#include "message.h"
+#include "wire.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace {
+using asio::ip::tcp;
+using std::chrono::steady_clock;
+
+using schema = reader::wire::message_schema;
+
+constexpr auto header_length = reader::wire_size::message_length;
+
+/// @brief Finds the complete messages in a capture
+/// @param capture A buffer of messages in wire format, including the message length header
+/// @return Offsets of each message, followed by the offset past the last complete message
+auto index_frames(asio::const_buffer capture) -> std::vector<std::size_t> {
+    auto offsets = std::vector<std::size_t>{0};
+
+    while (capture.size() >= header_length) {
+        const auto payload_length =
+            reader::decode_message_payload_length(asio::buffer(capture, header_length));
+
+        if (payload_length > reader::wire_size::max_payload ||
+            capture.size() - header_length < payload_length) {
+            break;
+        }
+
+        offsets.push_back(offsets.back() + header_length + payload_length);
+        capture += header_length + payload_length;
+    }
+
+    return offsets;
+}
+
+/// @brief Re-encodes messages with a different name
+/// @param capture A buffer of messages in wire format, including the message length header
+/// @param offsets Offsets of the messages in `capture`, as returned by `index_frames`
+/// @param name The name to set, truncated to 255 characters
+/// @return The re-encoded messages
+auto rename_frames(asio::const_buffer capture,
+                   const std::vector<std::size_t>& offsets,
+                   std::string_view name) -> std::vector<unsigned char> {
+    name = name.substr(0, schema::name::max_size);
+
+    const auto data = static_cast<const unsigned char*>(capture.data());
+    auto renamed = std::vector<unsigned char>{};
+
+    for (auto i = std::size_t{1}; i < offsets.size(); ++i) {
+        const auto frame = data + offsets[i - 1];
+        const auto payload = frame + header_length;
+        const auto payload_length = offsets[i] - offsets[i - 1] - header_length;
+
+        auto layout = reader::wire::message_layout{};
+        if (reader::wire::validate(payload, payload_length, layout)) {
+            // Leave malformed messages unchanged
+            renamed.insert(renamed.end(), frame, data + offsets[i]);
+            continue;
+        }
+
+        // The optional fields are copied without decoding them
+        const auto trailing = payload + schema::name_data_offset + layout.name_size;
+        const auto trailing_size = schema::trailing_fields::size(layout.present);
+        const auto message_length =
+            header_length + schema::name_data_offset + name.size() + trailing_size;
+
+        const auto offset = renamed.size();
+        renamed.resize(offset + message_length);
+        auto out = schema::length::write(static_cast<uint32_t>(message_length),
+                                         renamed.data() + offset);
+        out = std::copy(payload, payload + schema::timestamp::size, out);
+        out = schema::name::write(name, out);
+        std::copy(trailing, trailing + trailing_size, out);
+    }
+
+    return renamed;
+}
+
+/// Command line options
+struct replay_options {
+    /// Number of concurrent connections
+    unsigned connections = 1;
+
+    /// Messages per second summed over all connections, or 0 to send as fast as possible
+    double rate = 0;
+
+    /// Number of times each connection sends the capture
+    unsigned repeat = 1;
+
+    /// Sets the timestamp of each message to the time it is sent
+    bool rewrite_timestamps = false;
+
+    /// Replaces the name of each message with this prefix and the connection number, if set
+    std::string name;
+};
+
+/// Counts messages sent by all connections and periodically reports throughput
+class Statistics {
+  public:
+    explicit Statistics(asio::io_context& io_context) : timer_{io_context} {}
+
+    /// @brief Registers a connection which has started sending
+    auto opened() -> void {
+        if (active_++ == 0) {
+            start_time_ = steady_clock::now();
+            previous_time_ = start_time_;
+            wait();
+        }
+    }
+
+    /// @brief Registers a completed write
+    auto sent(uint64_t messages, uint64_t bytes) -> void {
+        messages_ += messages;
+        bytes_ += bytes;
+    }
+
+    /// @brief Registers a connection which has stopped sending
+    auto closed() -> void {
+        if (--active_ == 0) {
+            end_time_ = steady_clock::now();
+            timer_.cancel();
+        }
+    }
+
+    /// @brief Writes the total throughput
+    auto summary() const -> void { report("total", messages_, bytes_, end_time_ - start_time_); }
+
+  private:
+    auto wait() -> void {
+        timer_.expires_after(std::chrono::seconds{1});
+        timer_.async_wait([this](std::error_code ec) {
+            if (ec) {
+                return;
+            }
+
+            const auto now = steady_clock::now();
+            report("sent",
+                   messages_ - previous_messages_,
+                   bytes_ - previous_bytes_,
+                   now - previous_time_);
+            previous_messages_ = messages_;
+            previous_bytes_ = bytes_;
+            previous_time_ = now;
+
+            wait();
+        });
+    }
+
+    static auto report(std::string_view label,
+                       uint64_t messages,
+                       uint64_t bytes,
+                       steady_clock::duration elapsed) -> void {
+        const auto seconds = std::chrono::duration<double>(elapsed).count();
+
+        auto ss = std::stringstream{};
+        ss << std::fixed << std::setprecision(3) << label << ": " << messages << " msgs, "
+           << bytes << " bytes in " << seconds << " s (" << std::setprecision(0)
+           << static_cast<double>(messages) / seconds << " msgs/s, "
+           << static_cast<double>(bytes) / seconds << " bytes/s)\n";
+        std::cerr << ss.str();
+    }
+
+    asio::steady_timer timer_;
+
+    /// Number of connections which are sending
+    unsigned active_ = 0;
+
+    uint64_t messages_ = 0;
+    uint64_t bytes_ = 0;
+
+    steady_clock::time_point start_time_;
+    steady_clock::time_point end_time_;
+
+    /// Counters at the last periodic report
+    uint64_t previous_messages_ = 0;
+    uint64_t previous_bytes_ = 0;
+    steady_clock::time_point previous_time_;
+};
+
+/// Sends a capture over a single connection
+class Sender : public std::enable_shared_from_this<Sender> {
+  public:
+    /// @brief Creates a Sender
+    /// @param socket A connected socket
+    /// @param capture Messages in wire format, which must outlive the Sender
+    /// @param offsets Offsets of the messages in `capture`, as returned by `index_frames`
+    /// @param options Replay options, which must outlive the Sender
+    /// @param id Number identifying this connection
+    /// @param stats Statistics to update, which must outlive the Sender
+    Sender(tcp::socket socket,
+           asio::const_buffer capture,
+           const std::vector<std::size_t>& offsets,
+           const replay_options& options,
+           unsigned id,
+           Statistics& stats)
+        : socket_{std::move(socket)},
+          timer_{socket_.get_executor()},
+          options_{options},
+          stats_{stats},
+          offsets_{offsets} {
+        if (!options_.name.empty()) {
+            owned_ = rename_frames(capture, offsets, options_.name + "-" + std::to_string(id));
+            offsets_ = index_frames(asio::buffer(owned_));
+        } else if (options_.rewrite_timestamps) {
+            const auto data = static_cast<const unsigned char*>(capture.data());
+            owned_.assign(data, data + offsets_.back());
+        }
+
+        data_ = owned_.empty() ? static_cast<const unsigned char*>(capture.data()) : owned_.data();
+        rate_ = options_.rate / options_.connections;
+    }
+
+    /// @brief Starts sending messages
+    auto start() -> void {
+        stats_.opened();
+        start_time_ = steady_clock::now();
+        send();
+    }
+
+  private:
+    /// Maximum number of bytes sent with a single write
+    static constexpr std::size_t max_batch_size = 64 * 1024;
+
+    /// Number of messages in the capture
+    auto size() const noexcept -> std::size_t { return offsets_.size() - 1; }
+
+    /// @brief Sends the messages which are due, or waits until the next message is due
+    auto send() -> void {
+        if (next_ == size()) {
+            next_ = 0;
+            if (++repetition_ == options_.repeat || size() == 0) {
+                // The socket is closed once the last handler referring to this Sender returns
+                stats_.closed();
+                return;
+            }
+        }
+
+        auto last = size();
+        if (rate_ > 0) {
+            const auto elapsed = std::chrono::duration<double>(steady_clock::now() - start_time_);
+            const auto due = static_cast<std::size_t>(elapsed.count() * rate_) + 1;
+
+            if (due <= sent_) {
+                // Wait until the next message is due
+                const auto delay =
+                    std::chrono::duration<double>(static_cast<double>(sent_) / rate_);
+                timer_.expires_at(start_time_ +
+                                  std::chrono::duration_cast<steady_clock::duration>(delay));
+                timer_.async_wait([self = shared_from_this()](std::error_code ec) {
+                    if (!ec) {
+                        self->send();
+                    }
+                });
+                return;
+            }
+
+            last = std::min(last, next_ + (due - sent_));
+        }
+
+        // Limit the batch size, but always send at least one message
+        const auto first = offsets_.cbegin() + static_cast<std::ptrdiff_t>(next_) + 1;
+        const auto end = offsets_.cbegin() + static_cast<std::ptrdiff_t>(last) + 1;
+        const auto batch_end = std::upper_bound(first, end, offsets_[next_] + max_batch_size);
+        last = std::max(next_ + 1, static_cast<std::size_t>(batch_end - offsets_.cbegin()) - 1);
+
+        if (options_.rewrite_timestamps) {
+            set_timestamps(last);
+        }
+
+        const auto batch = asio::buffer(data_ + offsets_[next_], offsets_[last] - offsets_[next_]);
+        const auto messages = last - next_;
+        next_ = last;
+
+        const auto handler = [self = shared_from_this(), messages](std::error_code ec,
+                                                                   std::size_t n) {
+            if (ec) {
+                std::cerr << "Unable to send: " << ec.message() << "\n";
+                self->stats_.closed();
+                return;
+            }
+
+            self->sent_ += messages;
+            self->stats_.sent(messages, n);
+            self->send();
+        };
+        asio::async_write(socket_, batch, handler);
+    }
+
+    /// @brief Sets the timestamp of messages from `next_` to `last` to the current time
+    ///
+    /// Messages too short to contain a timestamp are left unchanged.
+    auto set_timestamps(std::size_t last) -> void {
+        const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+
+        for (auto i = next_; i < last; ++i) {
+            const auto payload_length = offsets_[i + 1] - offsets_[i] - header_length;
+            if (payload_length < schema::timestamp::size) {
+                continue;
+            }
+            schema::timestamp::write(static_cast<uint64_t>(now.count()),
+                                     owned_.data() + offsets_[i] + header_length);
+        }
+    }
+
+    tcp::socket socket_;
+    asio::steady_timer timer_;
+    const replay_options& options_;
+    Statistics& stats_;
+
+    /// Offsets of the messages in `data_`
+    std::vector<std::size_t> offsets_;
+
+    /// Messages modified for this connection, if any
+    std::vector<unsigned char> owned_;
+
+    /// Messages to send
+    const unsigned char* data_ = nullptr;
+
+    /// Messages per second for this connection, or 0 if unlimited
+    double rate_ = 0;
+
+    /// Index of the next message to send
+    std::size_t next_ = 0;
+
+    /// Number of times the capture has been sent
+    unsigned repetition_ = 0;
+
+    /// Number of messages sent
+    std::size_t sent_ = 0;
+
+    steady_clock::time_point start_time_;
+};
+
+/// Parses a positive number from a command line argument
+template <class T>
+auto parse_number(const char* arg) -> T {
+    auto ss = std::stringstream{};
+    ss << arg;
+
+    T n{};
+    ss >> n;
+    return n;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    constexpr auto usage =
+        "usage: replay [--connections <n>] [--rate <msgs/s>] [--repeat <n>] "
+        "[--rewrite-timestamps] [--name <prefix>] <host> <port> <capture>\n";
+
+    auto options = replay_options{};
+    auto args = std::vector<const char*>{};
+    for (auto i = 1; i < argc; ++i) {
+        const auto arg = std::string_view{argv[i]};
+        if (arg == "--connections" && i + 1 < argc) {
+            options.connections = parse_number<unsigned>(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.rate = parse_number<double>(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = parse_number<unsigned>(argv[++i]);
+        } else if (arg == "--rewrite-timestamps") {
+            options.rewrite_timestamps = true;
+        } else if (arg == "--name" && i + 1 < argc) {
+            options.name = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() != 3 || options.connections == 0 || options.repeat == 0 ||
+        !(options.rate >= 0)) {
+        std::cerr << usage;
+        return EXIT_FAILURE;
+    }
+
+    auto capture = std::unique_ptr<reader::MappedFile>{};
+    try {
+        capture = std::make_unique<reader::MappedFile>(args[2]);
+    } catch (const std::system_error& ex) {
+        std::cerr << "Unable to open capture: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto data = asio::buffer(capture->data());
+    const auto offsets = index_frames(data);
+    if (offsets.back() != data.size()) {
+        std::cerr << "Ignoring " << data.size() - offsets.back()
+                  << " bytes after the last complete message\n";
+    }
+
+    auto io_context = asio::io_context{1};
+
+    auto endpoints = tcp::resolver::results_type{};
+    try {
+        endpoints = tcp::resolver{io_context}.resolve(args[0], args[1]);
+    } catch (const std::system_error& ex) {
+        std::cerr << "Unable to resolve " << args[0] << ":" << args[1] << "\n";
+        std::cerr << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    auto stats = Statistics{io_context};
+    auto senders = std::vector<std::shared_ptr<Sender>>{};
+    for (auto i = 0u; i < options.connections; ++i) {
+        auto socket = tcp::socket{io_context};
+        try {
+            asio::connect(socket, endpoints);
+        } catch (const std::system_error& ex) {
+            std::cerr << "Unable to connect to " << args[0] << ":" << args[1] << "\n";
+            std::cerr << ex.what() << "\n";
+            std::cerr << "Is a log server running?\n";
+            return EXIT_FAILURE;
+        }
+        socket.set_option(tcp::no_delay{true});
+
+        senders.push_back(std::make_shared<Sender>(
+            std::move(socket), data, offsets, options, i, stats));
+    }
+
+    std::cerr << "Replaying " << offsets.size() - 1 << " messages over " << options.connections
+              << " connections\n";
+
+    for (auto& sender : senders) {
+        sender->start();
+    }
+    senders.clear();
+
+    io_context.run();
+
+    stats.summary();
+
+    return EXIT_SUCCESS;
+}
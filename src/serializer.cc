@@ -0,0 +1,193 @@
+#include "serializer.h"
+
+#include "timestamp.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string_view>
+
+namespace reader {
+
+namespace {
+
+/// @brief Appends a JSON string, escaped in the same way as `nlohmann::json::dump`
+/// @note `s` is expected to be valid UTF-8, which is checked when a message is decoded
+auto write_string(std::string& out, std::string_view s) -> void {
+    out.push_back('"');
+
+    for (const auto c : s) {
+        switch (c) {
+        case '\b':
+            out.append("\\b");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\f':
+            out.append("\\f");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        default:
+            if (static_cast<std::uint8_t>(c) <= 0x1F) {
+                constexpr auto lower_hex_digits = "0123456789abcdef";
+                const auto byte = static_cast<std::uint8_t>(c);
+                out.append("\\u00");
+                out.push_back(lower_hex_digits[byte >> 4]);
+                out.push_back(lower_hex_digits[byte & 0xF]);
+            } else {
+                out.push_back(c);
+            }
+        }
+    }
+
+    out.push_back('"');
+}
+
+/// @brief Appends a JSON number, formatted in the same way as `nlohmann::json::dump`
+auto write_number(std::string& out, float value) -> void {
+    // JSON numbers are stored as double
+    const auto d = static_cast<double>(value);
+
+    if (!std::isfinite(d)) {
+        out.append("null");
+        return;
+    }
+
+    char buffer[64];
+    const auto end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), d);
+    out.append(buffer, end);
+}
+
+/// @brief Appends a JSON number for an unsigned integer
+auto write_integer(std::string& out, std::uint32_t value) -> void {
+    char buffer[10];
+    auto begin = std::end(buffer);
+    do {
+        *--begin = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    out.append(begin, std::end(buffer));
+}
+
+/// Writes the members of a JSON object in key order
+class object_writer {
+  public:
+    object_writer(std::string& out, json_format format) : out_{out}, format_{format} {
+        out_.push_back('{');
+    }
+
+    auto key(std::string_view k) -> std::string& {
+        if (!first_) {
+            out_.push_back(',');
+        }
+        first_ = false;
+
+        if (format_ == json_format::pretty) {
+            out_.append("\n    ");
+        }
+
+        out_.push_back('"');
+        out_.append(k);
+        out_.append((format_ == json_format::pretty) ? "\": " : "\":");
+        return out_;
+    }
+
+    auto close() -> void {
+        if (format_ == json_format::pretty) {
+            out_.push_back('\n');
+        }
+        out_.push_back('}');
+    }
+
+  private:
+    std::string& out_;
+    const json_format format_;
+    bool first_ = true;
+};
+
+/// @brief Appends a JSON object for a message
+/// @param name_id If set, written as `name_id` in place of the name
+template <class M>
+auto write_message(std::string& out,
+                   const M& message,
+                   std::optional<std::uint32_t> name_id,
+                   json_format format) -> void {
+    // `nlohmann::json` objects are sorted by key
+    auto object = object_writer{out, format};
+
+    if (const auto h = message.humidity()) {
+        write_number(object.key("humidity"), *h);
+    }
+
+    if (name_id) {
+        write_integer(object.key("name_id"), *name_id);
+    } else {
+        write_string(object.key("name"), message.name());
+    }
+
+    if (const auto t = message.temperature()) {
+        write_number(object.key("temperature"), *t);
+    }
+
+    char timestamp[max_timestamp_size];
+    const auto timestamp_end = format_timestamp(message.timestamp(), timestamp);
+    write_string(object.key("timestamp"),
+                 {timestamp, static_cast<std::size_t>(timestamp_end - timestamp)});
+
+    object.close();
+}
+
+} // namespace
+
+auto write_json(std::string& out, const MessageView& message, json_format format) -> void {
+    write_message(out, message, std::nullopt, format);
+}
+
+auto write_json(std::string& out, const Message& message, json_format format) -> void {
+    write_message(out, message, std::nullopt, format);
+}
+
+auto write_json(std::string& out, const MessageBatch::row& message, json_format format) -> void {
+    write_message(out, message, std::nullopt, format);
+}
+
+auto write_json(std::string& out,
+                const MessageView& message,
+                std::uint32_t name_id,
+                json_format format) -> void {
+    write_message(out, message, name_id, format);
+}
+
+auto write_json(std::string& out,
+                const MessageBatch::row& message,
+                std::uint32_t name_id,
+                json_format format) -> void {
+    write_message(out, message, name_id, format);
+}
+
+auto write_name_definition(std::string& out,
+                           std::uint32_t name_id,
+                           std::string_view name,
+                           json_format format) -> void {
+    auto object = object_writer{out, format};
+    write_integer(object.key("id"), name_id);
+    write_string(object.key("name"), name);
+    object.close();
+}
+
+} // namespace reader
@@ -0,0 +1,70 @@
+#include "spill_ring.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace reader {
+
+SpillRing::SpillRing(const std::string& path, std::size_t capacity) : capacity_{capacity} {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd_ == -1) {
+        throw std::system_error{errno, std::generic_category(), path};
+    }
+
+    if (::ftruncate(fd_, static_cast<off_t>(capacity_)) == -1) {
+        const auto error = errno;
+        ::close(fd_);
+        throw std::system_error{error, std::generic_category(), path};
+    }
+
+    const auto mapping = ::mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        const auto error = errno;
+        ::close(fd_);
+        throw std::system_error{error, std::generic_category(), path};
+    }
+    data_ = static_cast<unsigned char*>(mapping);
+}
+
+SpillRing::~SpillRing() {
+    ::munmap(data_, capacity_);
+    ::close(fd_);
+}
+
+auto SpillRing::push(asio::const_buffer data) noexcept -> bool {
+    if (data.size() > capacity_ - size_) {
+        return false;
+    }
+
+    const auto bytes = static_cast<const unsigned char*>(data.data());
+    const auto tail = (head_ + size_) % capacity_;
+    const auto first = std::min(data.size(), capacity_ - tail);
+
+    std::memcpy(data_ + tail, bytes, first);
+    std::memcpy(data_, bytes + first, data.size() - first);
+
+    size_ += data.size();
+    return true;
+}
+
+auto SpillRing::front(std::size_t max) const noexcept -> std::array<asio::const_buffer, 2> {
+    const auto n = std::min(max, size_);
+    const auto first = std::min(n, capacity_ - head_);
+
+    return {asio::const_buffer{data_ + head_, first}, asio::const_buffer{data_, n - first}};
+}
+
+auto SpillRing::pop(std::size_t n) noexcept -> void {
+    assert(n <= size_);
+
+    size_ -= n;
+    head_ = (size_ == 0) ? 0 : (head_ + n) % capacity_;
+}
+
+} // namespace reader
@@ -0,0 +1,210 @@
+#include "timestamp.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+
+namespace reader {
+
+namespace {
+
+/// Writes `value` as a zero padded decimal number of `width` digits
+template <std::size_t width>
+auto write_digits(char* out, long value) noexcept -> char* {
+    for (auto i = width; i > 0; --i) {
+        out[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+/// Formatted date, time and UTC offset of a single second
+struct second_cache {
+    static constexpr std::size_t max_size = 48;
+
+    /// Seconds since the epoch of the cached entry
+    std::time_t seconds = 0;
+
+    /// Set once an entry has been cached
+    bool valid = false;
+
+    /// Formatted `%FT%T`
+    char date_time[max_size] = {};
+    std::size_t date_time_size = 0;
+
+    /// Formatted `%z`
+    char utc_offset[max_size] = {};
+    std::size_t utc_offset_size = 0;
+};
+
+auto update(second_cache& cache, std::time_t seconds) -> void {
+    auto local = std::tm{};
+    if (::localtime_r(&seconds, &local) == nullptr) {
+        // Only reachable with timestamps far outside the range representable by `std::tm`
+        cache.date_time_size = 0;
+        cache.utc_offset_size = 0;
+    } else if (local.tm_year + 1900 >= 1000 && local.tm_year + 1900 <= 9999) {
+        // Fast path for four digit years, equivalent to "%FT%T"
+        auto p = cache.date_time;
+        p = write_digits<4>(p, local.tm_year + 1900);
+        *p++ = '-';
+        p = write_digits<2>(p, local.tm_mon + 1);
+        *p++ = '-';
+        p = write_digits<2>(p, local.tm_mday);
+        *p++ = 'T';
+        p = write_digits<2>(p, local.tm_hour);
+        *p++ = ':';
+        p = write_digits<2>(p, local.tm_min);
+        *p++ = ':';
+        p = write_digits<2>(p, local.tm_sec);
+        cache.date_time_size = static_cast<std::size_t>(p - cache.date_time);
+
+        // Equivalent to "%z"
+        const auto offset_minutes = local.tm_gmtoff / 60;
+        p = cache.utc_offset;
+        *p++ = (offset_minutes < 0) ? '-' : '+';
+        p = write_digits<2>(p, std::labs(offset_minutes) / 60);
+        p = write_digits<2>(p, std::labs(offset_minutes) % 60);
+        cache.utc_offset_size = static_cast<std::size_t>(p - cache.utc_offset);
+    } else {
+        cache.date_time_size =
+            std::strftime(cache.date_time, second_cache::max_size, "%FT%T", &local);
+        cache.utc_offset_size =
+            std::strftime(cache.utc_offset, second_cache::max_size, "%z", &local);
+    }
+
+    cache.seconds = seconds;
+    cache.valid = true;
+}
+
+/// @brief Reads a decimal number of exactly `width` digits
+/// @return The number, or -1 if `s` does not start with `width` digits
+auto read_digits(std::string_view& s, std::size_t width) noexcept -> long {
+    if (s.size() < width) {
+        return -1;
+    }
+
+    auto value = 0L;
+    for (auto i = std::size_t{0}; i < width; ++i) {
+        if (s[i] < '0' || s[i] > '9') {
+            return -1;
+        }
+        value = value * 10 + (s[i] - '0');
+    }
+
+    s.remove_prefix(width);
+    return value;
+}
+
+/// @brief Reads an expected character
+auto read_char(std::string_view& s, char c) noexcept -> bool {
+    if (s.empty() || s.front() != c) {
+        return false;
+    }
+
+    s.remove_prefix(1);
+    return true;
+}
+
+/// @brief Number of days from 1970-01-01 to a date in the proleptic Gregorian calendar
+/// @see http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+constexpr auto days_from_civil(long y, long m, long d) noexcept -> long {
+    y -= (m <= 2) ? 1 : 0;
+    const auto era = ((y >= 0) ? y : y - 399) / 400;
+    const auto yoe = y - era * 400;
+    const auto doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+} // namespace
+
+auto format_timestamp(std::chrono::system_clock::time_point timestamp, char* out) -> char* {
+    static thread_local auto cache = second_cache{};
+
+    const auto since_epoch =
+        std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch());
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    if (seconds > since_epoch) {
+        seconds -= std::chrono::seconds{1};
+    }
+    const auto milliseconds = (since_epoch - seconds).count();
+
+    const auto t = std::chrono::system_clock::to_time_t(
+        std::chrono::system_clock::time_point{seconds});
+    if (!cache.valid || cache.seconds != t) {
+        update(cache, t);
+    }
+
+    std::memcpy(out, cache.date_time, cache.date_time_size);
+    out += cache.date_time_size;
+    *out++ = '.';
+    out = write_digits<3>(out, static_cast<long>(milliseconds));
+    std::memcpy(out, cache.utc_offset, cache.utc_offset_size);
+    return out + cache.utc_offset_size;
+}
+
+auto parse_timestamp(std::string_view s) -> std::optional<std::chrono::system_clock::time_point> {
+    const auto year = read_digits(s, 4);
+    const auto month = read_char(s, '-') ? read_digits(s, 2) : -1;
+    const auto day = read_char(s, '-') ? read_digits(s, 2) : -1;
+    const auto hour = read_char(s, 'T') ? read_digits(s, 2) : -1;
+    const auto minute = read_char(s, ':') ? read_digits(s, 2) : -1;
+    const auto second = read_char(s, ':') ? read_digits(s, 2) : -1;
+    if (year < 0 || month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23 ||
+        minute < 0 || minute > 59 || second < 0 || second > 60) {
+        return std::nullopt;
+    }
+
+    auto milliseconds = 0L;
+    if (read_char(s, '.')) {
+        auto digits = 0;
+        for (; digits < 3 && !s.empty() && s.front() >= '0' && s.front() <= '9'; ++digits) {
+            milliseconds = milliseconds * 10 + read_digits(s, 1);
+        }
+        if (digits == 0) {
+            return std::nullopt;
+        }
+        for (; digits < 3; ++digits) {
+            milliseconds *= 10;
+        }
+    }
+
+    auto seconds = std::time_t{};
+    if (s.empty()) {
+        auto local = std::tm{};
+        local.tm_year = static_cast<int>(year - 1900);
+        local.tm_mon = static_cast<int>(month - 1);
+        local.tm_mday = static_cast<int>(day);
+        local.tm_hour = static_cast<int>(hour);
+        local.tm_min = static_cast<int>(minute);
+        local.tm_sec = static_cast<int>(second);
+        local.tm_isdst = -1;
+        seconds = std::mktime(&local);
+    } else {
+        auto offset_minutes = 0L;
+        if (!read_char(s, 'Z')) {
+            const auto sign = read_char(s, '+') ? 1 : read_char(s, '-') ? -1 : 0;
+            const auto offset_hours = read_digits(s, 2);
+            read_char(s, ':');
+            const auto offset_minute = read_digits(s, 2);
+            if (sign == 0 || offset_hours < 0 || offset_minute < 0) {
+                return std::nullopt;
+            }
+            offset_minutes = sign * (offset_hours * 60 + offset_minute);
+        }
+        if (!s.empty()) {
+            return std::nullopt;
+        }
+
+        const auto minutes = (days_from_civil(year, month, day) * 24 + hour) * 60 + minute;
+        seconds = (minutes - offset_minutes) * 60 + second;
+    }
+
+    return std::chrono::system_clock::from_time_t(seconds) +
+           std::chrono::milliseconds{milliseconds};
+}
+
+} // namespace reader
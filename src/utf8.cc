@@ -0,0 +1,323 @@
+#include "utf8.h"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef RECORDER_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace reader {
+
+namespace {
+
+/// Position and kind of the first invalid byte in a string
+struct utf8_error {
+    /// Index of the first invalid byte, or the size of the string if valid
+    std::size_t index;
+
+    /// Set if the string ends within a multi-byte sequence
+    bool incomplete;
+};
+
+/// @brief Finds the first invalid byte of a string, one code point at a time
+auto find_invalid(std::string_view s) noexcept -> utf8_error {
+    const auto byte_at = [&](std::size_t i) { return static_cast<std::uint8_t>(s[i]); };
+
+    auto i = std::size_t{0};
+    while (i < s.size()) {
+        // Skip 8 ASCII bytes at a time
+        if (s.size() - i >= sizeof(std::uint64_t)) {
+            auto block = std::uint64_t{};
+            std::memcpy(&block, s.data() + i, sizeof(block));
+            if ((block & 0x8080808080808080) == 0) {
+                i += sizeof(block);
+                continue;
+            }
+        }
+
+        const auto lead = byte_at(i);
+
+        if (lead < 0x80) {
+            ++i;
+            continue;
+        }
+
+        // Number of continuation bytes and the valid range of the first continuation byte
+        auto length = std::size_t{};
+        auto lower = std::uint8_t{0x80};
+        auto upper = std::uint8_t{0xBF};
+
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 1;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 2;
+            lower = (lead == 0xE0) ? 0xA0 : lower; // overlong
+            upper = (lead == 0xED) ? 0x9F : upper; // surrogates
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 3;
+            lower = (lead == 0xF0) ? 0x90 : lower; // overlong
+            upper = (lead == 0xF4) ? 0x8F : upper; // above U+10FFFF
+        } else {
+            return {i, false};
+        }
+
+        for (auto j = std::size_t{1}; j <= length; ++j) {
+            if (i + j == s.size()) {
+                return {s.size() - 1, true};
+            }
+
+            const auto byte = byte_at(i + j);
+            const auto min = (j == 1) ? lower : std::uint8_t{0x80};
+            const auto max = (j == 1) ? upper : std::uint8_t{0xBF};
+            if (byte < min || byte > max) {
+                return {i + j, false};
+            }
+        }
+
+        i += length + 1;
+    }
+
+    return {s.size(), false};
+}
+
+auto validate_scalar(std::string_view s) noexcept -> bool {
+    const auto error = find_invalid(s);
+    return error.index == s.size() && !error.incomplete;
+}
+
+#ifdef RECORDER_SIMD_X86
+
+// The vectorized implementations follow the lookup algorithm of simdjson, which classifies each
+// pair of adjacent bytes with three table lookups on nibbles. Every class of error sets a bit,
+// and a byte is invalid if the bit is set in all three lookups. Continuation bytes required by
+// three and four byte sequences are checked separately.
+//
+// See John Keiser, Daniel Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte",
+// Software: Practice and Experience 51 (5), 2021.
+
+constexpr std::uint8_t too_short = 1 << 0;
+constexpr std::uint8_t too_long = 1 << 1;
+constexpr std::uint8_t overlong_3 = 1 << 2;
+constexpr std::uint8_t too_large = 1 << 3;
+constexpr std::uint8_t surrogate = 1 << 4;
+constexpr std::uint8_t overlong_2 = 1 << 5;
+constexpr std::uint8_t too_large_1000 = 1 << 6;
+constexpr std::uint8_t overlong_4 = 1 << 6;
+constexpr std::uint8_t two_conts = 1 << 7;
+constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+/// Errors indexed by the high nibble of the first byte of a pair
+alignas(16) constexpr std::uint8_t byte_1_high[16] = {
+    // 0_______ ________
+    too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+    // 10______ ________
+    two_conts, two_conts, two_conts, two_conts,
+    // 1100____ ________
+    too_short | overlong_2,
+    // 1101____ ________
+    too_short,
+    // 1110____ ________
+    too_short | overlong_3 | surrogate,
+    // 1111____ ________
+    too_short | too_large | too_large_1000 | overlong_4};
+
+/// Errors indexed by the low nibble of the first byte of a pair
+alignas(16) constexpr std::uint8_t byte_1_low[16] = {
+    // ____0000 ________
+    carry | overlong_3 | overlong_2 | overlong_4,
+    // ____0001 ________
+    carry | overlong_2,
+    // ____001_ ________
+    carry,
+    carry,
+    // ____0100 ________
+    carry | too_large,
+    // ____0101 ________
+    carry | too_large | too_large_1000,
+    // ____011_ ________
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    // ____1___ ________
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    // ____1101 ________
+    carry | too_large | too_large_1000 | surrogate,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000};
+
+/// Errors indexed by the high nibble of the second byte of a pair
+alignas(16) constexpr std::uint8_t byte_2_high[16] = {
+    // ________ 0_______
+    too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+    // ________ 1000____
+    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+    // ________ 1001____
+    too_long | overlong_2 | two_conts | overlong_3 | too_large,
+    // ________ 101_____
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    // ________ 11______
+    too_short, too_short, too_short, too_short};
+
+[[gnu::target("sse4.1")]] auto load_table(const std::uint8_t (&table)[16]) noexcept -> __m128i {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+[[gnu::target("sse4.1")]] auto low_nibbles(__m128i v) noexcept -> __m128i {
+    return _mm_and_si128(v, _mm_set1_epi8(0x0F));
+}
+
+[[gnu::target("sse4.1")]] auto high_nibbles(__m128i v) noexcept -> __m128i {
+    return low_nibbles(_mm_srli_epi16(v, 4));
+}
+
+/// @brief Finds errors in a block of 16 bytes
+/// @param input The block
+/// @param previous The preceding block, or zeros
+[[gnu::target("sse4.1")]] auto check_block(__m128i input, __m128i previous) noexcept -> __m128i {
+    const auto prev1 = _mm_alignr_epi8(input, previous, 15);
+    const auto special_cases =
+        _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(load_table(byte_1_high), high_nibbles(prev1)),
+                                    _mm_shuffle_epi8(load_table(byte_1_low), low_nibbles(prev1))),
+                      _mm_shuffle_epi8(load_table(byte_2_high), high_nibbles(input)));
+
+    // Bytes following a three or four byte lead must be continuation bytes
+    const auto prev2 = _mm_alignr_epi8(input, previous, 14);
+    const auto prev3 = _mm_alignr_epi8(input, previous, 13);
+    const auto is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80));
+    const auto is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80));
+    const auto must_be_continuation =
+        _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte),
+                      _mm_set1_epi8(static_cast<char>(0x80)));
+
+    return _mm_xor_si128(must_be_continuation, special_cases);
+}
+
+[[gnu::target("sse4.1")]] auto validate_sse4(std::string_view s) noexcept -> bool {
+    constexpr auto block_size = sizeof(__m128i);
+
+    auto error = _mm_setzero_si128();
+    auto previous = _mm_setzero_si128();
+
+    auto i = std::size_t{0};
+    for (; i + block_size <= s.size(); i += block_size) {
+        const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.data() + i));
+        error = _mm_or_si128(error, check_block(input, previous));
+        previous = input;
+    }
+
+    // The remaining bytes are padded with zeros, which also detects a sequence that is incomplete
+    // at the end of the string
+    alignas(block_size) char tail[block_size] = {};
+    std::memcpy(tail, s.data() + i, s.size() - i);
+    error = _mm_or_si128(
+        error, check_block(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)), previous));
+
+    return _mm_testz_si128(error, error) != 0;
+}
+
+[[gnu::target("avx2")]] auto load_table_x2(const std::uint8_t (&table)[16]) noexcept -> __m256i {
+    return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+[[gnu::target("avx2")]] auto low_nibbles(__m256i v) noexcept -> __m256i {
+    return _mm256_and_si256(v, _mm256_set1_epi8(0x0F));
+}
+
+[[gnu::target("avx2")]] auto high_nibbles(__m256i v) noexcept -> __m256i {
+    return low_nibbles(_mm256_srli_epi16(v, 4));
+}
+
+/// @brief Finds errors in a block of 32 bytes
+/// @param input The block
+/// @param previous The preceding block, or zeros
+[[gnu::target("avx2")]] auto check_block(__m256i input, __m256i previous) noexcept -> __m256i {
+    // Shifts operate within 128-bit lanes, so the lower lane is shifted in from the preceding
+    // block and the upper lane from the lower lane of the input
+    const auto carried = _mm256_permute2x128_si256(previous, input, 0x21);
+
+    const auto prev1 = _mm256_alignr_epi8(input, carried, 15);
+    const auto special_cases = _mm256_and_si256(
+        _mm256_and_si256(_mm256_shuffle_epi8(load_table_x2(byte_1_high), high_nibbles(prev1)),
+                         _mm256_shuffle_epi8(load_table_x2(byte_1_low), low_nibbles(prev1))),
+        _mm256_shuffle_epi8(load_table_x2(byte_2_high), high_nibbles(input)));
+
+    const auto prev2 = _mm256_alignr_epi8(input, carried, 14);
+    const auto prev3 = _mm256_alignr_epi8(input, carried, 13);
+    const auto is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80));
+    const auto is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80));
+    const auto must_be_continuation =
+        _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte),
+                         _mm256_set1_epi8(static_cast<char>(0x80)));
+
+    return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+[[gnu::target("avx2")]] auto validate_avx2(std::string_view s) noexcept -> bool {
+    constexpr auto block_size = sizeof(__m256i);
+
+    auto error = _mm256_setzero_si256();
+    auto previous = _mm256_setzero_si256();
+
+    auto i = std::size_t{0};
+    for (; i + block_size <= s.size(); i += block_size) {
+        const auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s.data() + i));
+        error = _mm256_or_si256(error, check_block(input, previous));
+        previous = input;
+    }
+
+    alignas(block_size) char tail[block_size] = {};
+    std::memcpy(tail, s.data() + i, s.size() - i);
+    error = _mm256_or_si256(
+        error, check_block(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)), previous));
+
+    return _mm256_testz_si256(error, error) != 0;
+}
+
+#endif
+
+constexpr auto hex_digits = "0123456789ABCDEF";
+
+auto hex_byte(std::uint8_t byte) -> std::string {
+    return {hex_digits[byte >> 4], hex_digits[byte & 0xF]};
+}
+
+} // namespace
+
+auto is_valid_utf8(std::string_view s) noexcept -> bool {
+    static const auto isa = best_simd_isa();
+    return is_valid_utf8(s, isa);
+}
+
+auto is_valid_utf8(std::string_view s, simd_isa isa) noexcept -> bool {
+    switch (isa) {
+#ifdef RECORDER_SIMD_X86
+    case simd_isa::avx2:
+        return validate_avx2(s);
+    case simd_isa::sse4:
+        return validate_sse4(s);
+#endif
+    default:
+        return validate_scalar(s);
+    }
+}
+
+auto describe_invalid_utf8(std::string_view s) -> std::string {
+    const auto error = find_invalid(s);
+
+    if (error.incomplete) {
+        return "incomplete UTF-8 string; last byte: 0x" +
+               hex_byte(static_cast<std::uint8_t>(s[error.index]));
+    }
+    if (error.index < s.size()) {
+        return "invalid UTF-8 byte at index " + std::to_string(error.index) + ": 0x" +
+               hex_byte(static_cast<std::uint8_t>(s[error.index]));
+    }
+    return {};
+}
+
+} // namespace reader
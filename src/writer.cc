@@ -0,0 +1,134 @@
+#include "writer.h"
+
+#include <utility>
+
+namespace logger {
+
+Writer::Writer(std::ostream& out, std::size_t flush_size, std::chrono::milliseconds flush_interval)
+    : out_{out}, flush_size_{flush_size}, flush_interval_{flush_interval} {
+    front_.reserve(flush_size_);
+    back_.reserve(flush_size_);
+    thread_ = std::thread{[this]() { run(); }};
+}
+
+Writer::Writer(std::ostream& out,
+               std::ostream& index_out,
+               IndexBuilder& index,
+               std::size_t flush_size,
+               std::chrono::milliseconds flush_interval)
+    : Writer{out, flush_size, flush_interval} {
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+    index_out_ = &index_out;
+    index_ = &index;
+}
+
+Writer::~Writer() {
+    {
+        const auto lock = std::lock_guard<std::mutex>{mutex_};
+        stop_ = true;
+    }
+    write_requested_.notify_one();
+    thread_.join();
+}
+
+auto Writer::write(std::string_view record) -> void {
+    write_record(record, nullptr);
+}
+
+auto Writer::write(std::string_view record, const record_info& info) -> void {
+    write_record(record, &info);
+}
+
+auto Writer::append(std::string_view data) -> void {
+    auto notify = false;
+    {
+        const auto lock = std::lock_guard<std::mutex>{mutex_};
+        front_.append(data);
+        appended_ += data.size();
+        queued_.store(front_.size(), std::memory_order_relaxed);
+        notify = crossed_threshold(data.size());
+    }
+
+    if (notify) {
+        write_requested_.notify_one();
+    }
+}
+
+auto Writer::flush() -> void {
+    auto lock = std::unique_lock<std::mutex>{mutex_};
+    const auto target = ++flushes_requested_;
+    write_requested_.notify_one();
+    flush_completed_.wait(lock, [&]() { return flushes_completed_ >= target; });
+}
+
+auto Writer::write_record(std::string_view record, const record_info* info) -> void {
+    auto notify = false;
+    {
+        const auto lock = std::lock_guard<std::mutex>{mutex_};
+        if (index_ && info) {
+            index_->add(appended_, *info);
+        }
+        front_.append(record);
+        front_.push_back('\n');
+        appended_ += record.size() + 1;
+        queued_.store(front_.size(), std::memory_order_relaxed);
+        notify = crossed_threshold(record.size() + 1);
+    }
+
+    if (notify) {
+        write_requested_.notify_one();
+    }
+}
+
+auto Writer::crossed_threshold(std::size_t appended) const noexcept -> bool {
+    // Only wake the writer thread when the threshold is first crossed
+    return (front_.size() >= flush_size_) && (front_.size() - appended < flush_size_);
+}
+
+auto Writer::run() -> void {
+    auto lock = std::unique_lock<std::mutex>{mutex_};
+
+    while (true) {
+        write_requested_.wait_for(lock, flush_interval_, [&]() {
+            return stop_ || (front_.size() >= flush_size_) ||
+                   (flushes_completed_ < flushes_requested_);
+        });
+
+        std::swap(front_, back_);
+        queued_.store(0, std::memory_order_relaxed);
+        const auto flushes = flushes_requested_;
+        const auto stop = stop_;
+
+        // Index entries refer to records up to the end of the back buffer at most
+        if (index_) {
+            if (stop) {
+                index_->finish(appended_);
+            }
+            index_->take(index_back_);
+        }
+
+        lock.unlock();
+        if (!back_.empty()) {
+            out_.write(back_.data(), static_cast<std::streamsize>(back_.size()));
+            out_.flush();
+            back_.clear();
+        }
+        if (!index_back_.empty()) {
+            index_out_->write(index_back_.data(), static_cast<std::streamsize>(index_back_.size()));
+            index_out_->flush();
+            index_back_.clear();
+        }
+        lock.lock();
+
+        if (flushes_completed_ < flushes) {
+            flushes_completed_ = flushes;
+            flush_completed_.notify_all();
+        }
+
+        if (stop && front_.empty()) {
+            return;
+        }
+    }
+}
+
+} // namespace logger
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "wire.h"
+
+#include <vector>
+
+namespace test {
+
+/// Encodes a message payload in wire format
+inline auto encode(const reader::wire::message_fields& fields) -> std::vector<unsigned char> {
+    auto data = std::vector<unsigned char>(reader::wire::payload_size(fields));
+    reader::wire::encode(fields, data.data());
+    return data;
+}
+
+} // namespace test
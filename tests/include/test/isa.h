@@ -0,0 +1,22 @@
+#pragma once
+
+#include "simd.h"
+
+#include <vector>
+
+namespace test {
+
+/// Instruction sets supported by the running CPU
+inline auto supported_isas() -> std::vector<reader::simd_isa> {
+    using reader::simd_isa;
+
+    auto isas = std::vector<simd_isa>{};
+    for (const auto isa : {simd_isa::scalar, simd_isa::sse4, simd_isa::avx2}) {
+        if (reader::supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+    return isas;
+}
+
+} // namespace test
@@ -97,7 +97,8 @@ class read_op : public read_op_base {
                     ec = asio::error::eof;
                 else if (s.code == status::reset)
                     ec = asio::error::connection_reset;
-                asio::post(s.ioc.get_executor(), asio::detail::bind_handler(std::move(h), ec, 0));
+                asio::post(s.ioc.get_executor(),
+                           asio::detail::bind_handler(std::move(h), ec, std::size_t{0}));
             }
         }
     };
@@ -125,6 +126,9 @@ class socket {
 
     auto buffer() -> asio::streambuf& { return in_->b; }
 
+    /// Sets the maximum number of bytes returned by a single read
+    auto read_size(std::size_t n) noexcept -> void { in_->read_max = n; }
+
     auto remote_endpoint() const noexcept -> const ::test::remote_endpoint& { return ep_; }
 
     template <class MutableBufferSequence, class ReadHandler>
@@ -154,11 +158,32 @@ class socket {
                     new read_op<ASIO_HANDLER_TYPE(ReadHandler, void(std::error_code, std::size_t)),
                                 MutableBufferSequence>{
                         *in_, buffers, std::move(init.completion_handler)});
+
+                if (in_->code != status::ok) {
+                    auto op = std::move(in_->op);
+                    lock.unlock();
+                    (*op)();
+                }
             }
         }
         return init.result.get();
     }
 
+    /// Closes the remote end, so that reads fail with `asio::error::eof` once all buffered data
+    /// has been read
+    auto close_remote() -> void {
+        auto op = std::unique_ptr<read_op_base>{};
+        {
+            std::lock_guard<std::mutex> lock{in_->m};
+            in_->code = status::eof;
+            op = std::move(in_->op);
+        }
+
+        if (op) {
+            (*op)();
+        }
+    }
+
   private:
     std::shared_ptr<state> in_;
 
@@ -0,0 +1,275 @@
+#include "aggregator.h"
+#include "timestamp.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+using time_point_t = logger::Aggregator::time_point_t;
+
+auto at(std::int64_t ms) -> time_point_t {
+    return time_point_t{std::chrono::milliseconds{ms}};
+}
+
+/// Records the rollups written by an Aggregator
+struct rollups {
+    auto sink() -> logger::Aggregator::sink_type {
+        return [this](std::string_view rollup) {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            written.push_back(nlohmann::json::parse(rollup));
+        };
+    }
+
+    std::mutex mutex;
+    std::vector<nlohmann::json> written;
+};
+
+auto options(std::vector<std::chrono::milliseconds> windows, std::chrono::milliseconds lateness)
+    -> logger::aggregator_options {
+    auto opts = logger::aggregator_options{};
+    opts.windows = std::move(windows);
+    opts.lateness = lateness;
+    opts.format = reader::json_format::compact;
+    return opts;
+}
+
+auto start_of(const nlohmann::json& rollup) -> std::optional<time_point_t> {
+    return reader::parse_timestamp(rollup["start"].get<std::string>());
+}
+
+} // namespace
+
+TEST(Aggregator, WritesClosedWindows) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 0ms), out.sink()};
+
+    aggregator.add("abc", at(100), 1.0F, std::nullopt);
+    aggregator.add("abc", at(500), 3.0F, 50.0F);
+    EXPECT_TRUE(out.written.empty());
+
+    aggregator.add("abc", at(1200), std::nullopt, std::nullopt);
+    ASSERT_EQ(1, out.written.size());
+
+    const auto& rollup = out.written.front();
+    EXPECT_EQ("abc", rollup["name"]);
+    EXPECT_EQ("1s", rollup["window"]);
+    EXPECT_EQ(at(0), start_of(rollup));
+    EXPECT_EQ(2, rollup["count"]);
+    EXPECT_EQ(2, rollup["temperature"]["count"]);
+    EXPECT_EQ(1.0, rollup["temperature"]["min"]);
+    EXPECT_EQ(3.0, rollup["temperature"]["max"]);
+    EXPECT_EQ(2.0, rollup["temperature"]["mean"]);
+    EXPECT_EQ(1, rollup["humidity"]["count"]);
+    EXPECT_EQ(50.0, rollup["humidity"]["mean"]);
+    EXPECT_EQ(1, aggregator.written());
+}
+
+TEST(Aggregator, OmitsMissingFieldsAndEmptyWindows) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 0ms), out.sink()};
+
+    aggregator.add("abc", at(100), std::nullopt, std::nullopt);
+    aggregator.add("abc", at(5100), std::nullopt, std::nullopt);
+    aggregator.flush();
+
+    ASSERT_EQ(2, out.written.size());
+    EXPECT_EQ(at(0), start_of(out.written[0]));
+    EXPECT_EQ(at(5000), start_of(out.written[1]));
+    EXPECT_EQ(0, out.written[0].count("temperature"));
+    EXPECT_EQ(0, out.written[0].count("humidity"));
+}
+
+TEST(Aggregator, AddsLateMessagesWithinLateness) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 500ms), out.sink()};
+
+    aggregator.add("abc", at(1200), 2.0F, std::nullopt);
+    aggregator.add("abc", at(900), 1.0F, std::nullopt);
+    EXPECT_TRUE(out.written.empty());
+
+    // The watermark passes the end of the first window
+    aggregator.add("abc", at(2000), 4.0F, std::nullopt);
+    ASSERT_EQ(1, out.written.size());
+    EXPECT_EQ(at(0), start_of(out.written[0]));
+    EXPECT_EQ(1, out.written[0]["count"]);
+
+    // Older than the watermark
+    aggregator.add("abc", at(1400), 8.0F, std::nullopt);
+    EXPECT_EQ(1, aggregator.late());
+
+    aggregator.flush();
+    ASSERT_EQ(3, out.written.size());
+    EXPECT_EQ(at(1000), start_of(out.written[1]));
+    EXPECT_EQ(1, out.written[1]["count"]);
+    EXPECT_EQ(2.0, out.written[1]["temperature"]["max"]);
+    EXPECT_EQ(at(2000), start_of(out.written[2]));
+}
+
+TEST(Aggregator, AddsToEachWidth) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s, 1min}, 0ms), out.sink()};
+
+    for (auto ms = 0; ms < 3000; ms += 100) {
+        aggregator.add("abc", at(ms), static_cast<float>(ms), std::nullopt);
+    }
+    aggregator.flush();
+
+    auto seconds = std::vector<nlohmann::json>{};
+    auto minutes = std::vector<nlohmann::json>{};
+    for (const auto& rollup : out.written) {
+        (rollup["window"] == "1s" ? seconds : minutes).push_back(rollup);
+    }
+
+    ASSERT_EQ(3, seconds.size());
+    ASSERT_EQ(1, minutes.size());
+    EXPECT_EQ(10, seconds[2]["count"]);
+    EXPECT_EQ(2000.0, seconds[2]["temperature"]["min"]);
+    EXPECT_EQ(30, minutes[0]["count"]);
+    EXPECT_EQ(0.0, minutes[0]["temperature"]["min"]);
+    EXPECT_EQ(2900.0, minutes[0]["temperature"]["max"]);
+    EXPECT_EQ(1450.0, minutes[0]["temperature"]["mean"]);
+}
+
+TEST(Aggregator, AlignsWindowsBeforeTheEpoch) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 0ms), out.sink()};
+
+    aggregator.add("abc", at(-500), std::nullopt, std::nullopt);
+    aggregator.flush();
+
+    ASSERT_EQ(1, out.written.size());
+    EXPECT_EQ(at(-1000), start_of(out.written[0]));
+}
+
+TEST(Aggregator, SensorsHaveTheirOwnWatermark) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 0ms), out.sink()};
+
+    aggregator.add("abc", at(100'000), std::nullopt, std::nullopt);
+    aggregator.add("def", at(100), std::nullopt, std::nullopt);
+    aggregator.add("def", at(1100), std::nullopt, std::nullopt);
+
+    EXPECT_EQ(0, aggregator.late());
+    ASSERT_EQ(1, out.written.size());
+    EXPECT_EQ("def", out.written[0]["name"]);
+}
+
+TEST(Aggregator, ExpiresIdleSensors) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 0ms), out.sink()};
+
+    aggregator.add("abc", at(100), std::nullopt, std::nullopt);
+    aggregator.add("def", at(100), std::nullopt, std::nullopt);
+    aggregator.expire();
+    EXPECT_TRUE(out.written.empty());
+
+    aggregator.add("abc", at(200), std::nullopt, std::nullopt);
+    aggregator.expire();
+    ASSERT_EQ(1, out.written.size());
+    EXPECT_EQ("def", out.written[0]["name"]);
+
+    // The window of an expired sensor is not written again
+    aggregator.add("def", at(300), std::nullopt, std::nullopt);
+    EXPECT_EQ(1, aggregator.late());
+}
+
+TEST(Aggregator, ForgetsIdleSensors) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 0ms), out.sink()};
+
+    aggregator.add("abc", at(100), std::nullopt, std::nullopt);
+    aggregator.add("def", at(100), std::nullopt, std::nullopt);
+    EXPECT_EQ(2, aggregator.sensors());
+
+    aggregator.expire();
+    aggregator.expire();
+    EXPECT_EQ(2, aggregator.sensors());
+    EXPECT_EQ(2, out.written.size());
+
+    aggregator.add("abc", at(1100), std::nullopt, std::nullopt);
+    aggregator.expire();
+    EXPECT_EQ(1, aggregator.sensors());
+
+    // A forgotten sensor starts over
+    aggregator.add("def", at(200), std::nullopt, std::nullopt);
+    EXPECT_EQ(0, aggregator.late());
+    EXPECT_EQ(2, aggregator.sensors());
+
+    aggregator.flush();
+    aggregator.flush();
+    EXPECT_EQ(0, aggregator.sensors());
+    EXPECT_EQ(4, out.written.size());
+}
+
+TEST(Aggregator, AddsExtremeTimestamps) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s, logger::max_duration}, 1s), out.sink()};
+
+    aggregator.add("abc", time_point_t::min(), std::nullopt, std::nullopt);
+    aggregator.add("abc", time_point_t::max(), std::nullopt, std::nullopt);
+    aggregator.add("def", time_point_t::min(), std::nullopt, std::nullopt);
+    aggregator.flush();
+
+    EXPECT_EQ(0, aggregator.late());
+    EXPECT_EQ(6, out.written.size());
+}
+
+TEST(Aggregator, AddsConcurrently) {
+    auto out = rollups{};
+    auto aggregator = logger::Aggregator{options({1s}, 0ms), out.sink()};
+
+    constexpr auto messages = 1000;
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&aggregator, name = std::to_string(i)]() {
+            for (auto ms = 0; ms < messages; ++ms) {
+                aggregator.add(name, at(ms * 10), 1.0F, std::nullopt);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    aggregator.flush();
+
+    auto count = 0;
+    for (const auto& rollup : out.written) {
+        count += rollup["count"].get<int>();
+    }
+    EXPECT_EQ(4 * messages, count);
+    EXPECT_EQ(4 * 10, out.written.size());
+}
+
+TEST(Duration, Parse) {
+    EXPECT_EQ(500ms, logger::parse_duration("500ms"));
+    EXPECT_EQ(1s, logger::parse_duration("1s"));
+    EXPECT_EQ(5min, logger::parse_duration("5m"));
+    EXPECT_EQ(2h, logger::parse_duration("2h"));
+
+    EXPECT_FALSE(logger::parse_duration(""));
+    EXPECT_FALSE(logger::parse_duration("1"));
+    EXPECT_FALSE(logger::parse_duration("0s"));
+    EXPECT_FALSE(logger::parse_duration("-1s"));
+    EXPECT_FALSE(logger::parse_duration("1d"));
+    EXPECT_FALSE(logger::parse_duration("s"));
+    EXPECT_FALSE(logger::parse_duration("9223372036854775807ms"));
+    EXPECT_FALSE(logger::parse_duration("1000000000000h"));
+}
+
+TEST(Duration, Format) {
+    EXPECT_EQ("250ms", logger::format_duration(250ms));
+    EXPECT_EQ("1s", logger::format_duration(1000ms));
+    EXPECT_EQ("90s", logger::format_duration(90s));
+    EXPECT_EQ("1m", logger::format_duration(60s));
+    EXPECT_EQ("1h", logger::format_duration(60min));
+}
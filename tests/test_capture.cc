@@ -0,0 +1,81 @@
+#include "capture.h"
+#include "compat/asio.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+using time_point_t = logger::segment_header::time_point_t;
+
+const auto receive_time = time_point_t{std::chrono::milliseconds{1593355910240}};
+
+auto encode(std::string_view endpoint, uint32_t payload_length) -> std::string {
+    auto out = std::string{};
+    logger::encode_segment_header(out, {endpoint, receive_time, payload_length});
+    return out;
+}
+
+} // namespace
+
+TEST(Capture, HeaderRoundTrip) {
+    const auto data = encode("127.0.0.1:54321", 0x01020304);
+
+    ASSERT_EQ(logger::capture_size::fixed_header + 15, data.size());
+    EXPECT_EQ("RSEG", data.substr(0, logger::capture_size::magic));
+
+    const auto size = logger::decode_segment_header_size(
+        asio::buffer(data.data(), logger::capture_size::fixed_header));
+    EXPECT_EQ(data.size(), size);
+
+    const auto header = logger::decode_segment_header(asio::buffer(data));
+    EXPECT_EQ("127.0.0.1:54321", header.endpoint);
+    EXPECT_EQ(receive_time, header.receive_time);
+    EXPECT_EQ(0x01020304, header.payload_length);
+}
+
+TEST(Capture, HeaderIsBigEndian) {
+    const auto data = encode("", 0x01020304);
+
+    const auto payload_length_offset =
+        logger::capture_size::magic + logger::capture_size::receive_time;
+    EXPECT_EQ(std::string("\x01\x02\x03\x04", 4), data.substr(payload_length_offset, 4));
+}
+
+TEST(Capture, ReceiveTimeTruncatedToMilliseconds) {
+    auto data = std::string{};
+    logger::encode_segment_header(
+        data, {"", receive_time + std::chrono::microseconds{999}, 0});
+
+    EXPECT_EQ(receive_time, logger::decode_segment_header(asio::buffer(data)).receive_time);
+}
+
+TEST(Capture, LongEndpointTruncated) {
+    const auto data = encode(std::string(300, 'a'), 0);
+
+    EXPECT_EQ(logger::capture_size::max_header, data.size());
+    EXPECT_EQ(std::string(255, 'a'), logger::decode_segment_header(asio::buffer(data)).endpoint);
+}
+
+TEST(Capture, InvalidMagic) {
+    auto data = encode("a:1", 0);
+    data[0] = 'X';
+
+    EXPECT_THROW(logger::decode_segment_header_size(
+                     asio::buffer(data.data(), logger::capture_size::fixed_header)),
+                 logger::bad_capture_data);
+    EXPECT_THROW(logger::decode_segment_header(asio::buffer(data)), logger::bad_capture_data);
+}
+
+TEST(Capture, InvalidHeaderSize) {
+    const auto data = encode("a:1", 0);
+
+    EXPECT_THROW(logger::decode_segment_header_size(asio::buffer(data)),
+                 logger::bad_capture_data);
+    EXPECT_THROW(logger::decode_segment_header(asio::buffer(data.data(), data.size() - 1)),
+                 logger::bad_capture_data);
+    EXPECT_THROW(logger::decode_segment_header(asio::buffer(data.data(), 3)),
+                 logger::bad_capture_data);
+}
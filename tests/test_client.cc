@@ -0,0 +1,143 @@
+#include "client.h"
+#include "compat/asio.h"
+#include "message.h"
+#include "wire.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using asio::ip::tcp;
+
+/// Frames of messages whose size does not divide the buffer size, so that buffers end with a
+/// partial message
+auto make_frames(std::size_t size) -> std::vector<unsigned char> {
+    const auto fields = reader::wire::message_fields{
+        1593355910240, "e74bb50f-5a1e-4742-8827-20bc80a17297", 343428, 808};
+    const auto frame_size = reader::wire_size::message_length + reader::wire::payload_size(fields);
+
+    auto data = std::vector<unsigned char>((size / frame_size) * frame_size);
+    for (auto offset = std::size_t{0}; offset < data.size(); offset += frame_size) {
+        reader::wire::encode_frame(fields, data.data() + offset);
+    }
+    return data;
+}
+
+/// @brief Writes data to a file descriptor until all is written or the reader closes it
+auto write_all(int fd, const std::vector<unsigned char>& data) -> void {
+    for (auto offset = std::size_t{0}; offset < data.size();) {
+        const auto n = ::write(fd, data.data() + offset, data.size() - offset);
+        if (n <= 0) {
+            return;
+        }
+        offset += static_cast<std::size_t>(n);
+    }
+}
+
+/// @brief Forwards data through a Client to a log server which receives slowly
+/// @return The data received by the log server within a time limit
+auto forward_to_slow_server(const std::vector<unsigned char>& data,
+                            std::unique_ptr<reader::SpillRing> spill)
+    -> std::vector<unsigned char> {
+    auto ioc = asio::io_context{};
+
+    // Small socket buffers keep the kernel from absorbing the data
+    auto acceptor = tcp::acceptor{ioc, tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+    acceptor.set_option(tcp::socket::receive_buffer_size{4096});
+    auto socket = tcp::socket{ioc, tcp::v4()};
+    socket.set_option(tcp::socket::send_buffer_size{4096});
+    socket.connect(acceptor.local_endpoint());
+    auto server = acceptor.accept();
+
+    // Writes to the pipe fail instead of raising a signal once the client is destroyed
+    std::signal(SIGPIPE, SIG_IGN);
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        ADD_FAILURE() << "Unable to create pipe";
+        return {};
+    }
+
+    auto client = std::optional<reader::Client>{};
+    client.emplace(std::move(socket),
+                   asio::posix::stream_descriptor{ioc, fds[0]},
+                   tcp::resolver::results_type{},
+                   std::move(spill));
+
+    // The input is kept open, so data is only sent if it is forwarded as writes complete
+    auto writer = std::thread{[&data, fd = fds[1]] { write_all(fd, data); }};
+
+    // The log server receives in small chunks with a delay between each
+    auto received = std::vector<unsigned char>{};
+    auto chunk = std::vector<unsigned char>(8192);
+    auto timer = asio::steady_timer{ioc};
+    auto receive = std::function<void()>{};
+    receive = [&] {
+        server.async_read_some(asio::buffer(chunk), [&](std::error_code ec, std::size_t n) {
+            ASSERT_FALSE(ec) << ec.message();
+            received.insert(
+                received.end(), chunk.cbegin(), chunk.cbegin() + static_cast<std::ptrdiff_t>(n));
+            if (received.size() >= data.size()) {
+                ioc.stop();
+                return;
+            }
+
+            timer.expires_after(std::chrono::milliseconds{1});
+            timer.async_wait([&](std::error_code) { receive(); });
+        });
+    };
+    receive();
+
+    ioc.run_for(std::chrono::seconds{10});
+
+    // Closes the read end of the pipe, so that the writer stops if the client stalled
+    client.reset();
+    writer.join();
+    ::close(fds[1]);
+
+    return received;
+}
+
+/// Several times the size of the ring, so that reads fill every buffer while the log server is
+/// slow to receive
+const auto frames = make_frames(4 * reader::Client::ring_size * reader::Client::buffer_size);
+
+} // namespace
+
+TEST(Client, DrainsRingBehindSlowSocket) {
+    const auto received = forward_to_slow_server(frames, nullptr);
+
+    EXPECT_EQ(frames.size(), received.size());
+    EXPECT_TRUE(received == frames);
+}
+
+TEST(Client, DrainsSpillFileBehindSlowSocket) {
+    const auto received = forward_to_slow_server(
+        frames,
+        std::make_unique<reader::SpillRing>(::testing::TempDir() + "test_client.spill",
+                                            2 * frames.size()));
+
+    EXPECT_EQ(frames.size(), received.size());
+    EXPECT_TRUE(received == frames);
+}
+
+TEST(Client, CompleteFramesSize) {
+    const auto three = make_frames(200);
+    ASSERT_EQ(162, three.size());
+
+    EXPECT_EQ(162, reader::complete_frames_size(three.data(), three.size()));
+    EXPECT_EQ(108, reader::complete_frames_size(three.data(), 161));
+    EXPECT_EQ(0, reader::complete_frames_size(three.data(), 3));
+
+    // Invalid message lengths are forwarded unchanged
+    const auto invalid = std::vector<unsigned char>{0, 0, 0, 1, 'a', 'b'};
+    EXPECT_EQ(6, reader::complete_frames_size(invalid.data(), invalid.size()));
+}
@@ -3,8 +3,11 @@
 #include "test/socket.h"
 
 #include "gtest/gtest.h"
+#include <cstring>
 #include <sstream>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace {
 
@@ -201,3 +204,415 @@ TEST_F(Connection, UnusedBytes_WithTemperatureAndHumidity) {
               "after message decode.\n",
               err.str());
 }
+
+TEST_F(Connection, ReadPayloadWithSerializedOutput) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c' // name
+    };
+    // clang-format on
+
+    push_data(asio::buffer(message));
+    logger::make_connection(std::move(socket), logger::Output{ioc.get_executor(), out, err});
+
+    // Writes from outside the io_context are queued on the output strand
+    EXPECT_EQ("", err.str());
+
+    ioc.poll();
+
+    EXPECT_NE(std::string::npos, out.str().find("    \"name\": \"abc\","));
+    EXPECT_EQ("[test_address:12345] Established connection\n", err.str());
+}
+
+TEST_F(Connection, RemoteClosedAfterLastMessage) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c' // name
+    };
+    // clang-format on
+
+    push_data(asio::buffer(message));
+    socket.close_remote();
+    logger::make_connection(
+        std::move(socket), logger::Output{out, err}, {logger::receive_mode::bulk});
+
+    err.str("");
+
+    // The connection is destroyed once the remote end is closed, so no work remains
+    ioc.run();
+
+    EXPECT_NE(std::string::npos, out.str().find("    \"name\": \"abc\","));
+    EXPECT_NE(std::string::npos, err.str().find("[test_address:12345] Terminating connection\n"));
+}
+
+TEST_F(Connection, BulkReadDecodesAllCompleteMessages) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 3 * n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'd', 'e', 'f', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'g', 'h', 'i' // name
+    };
+    // clang-format on
+
+    // The first read ends within the third message
+    push_data(asio::buffer(message));
+    socket.read_size(2 * n + 6);
+    logger::make_connection(
+        std::move(socket), logger::Output{out, err}, {logger::receive_mode::bulk});
+
+    err.str("");
+
+    // A single read decodes both complete messages
+    EXPECT_EQ(1, ioc.poll_one());
+    EXPECT_EQ("", err.str());
+
+    auto out_str = out.str();
+    EXPECT_NE(std::string::npos, out_str.find("    \"name\": \"abc\","));
+    EXPECT_NE(std::string::npos, out_str.find("    \"name\": \"def\","));
+    EXPECT_EQ(std::string::npos, out_str.find("    \"name\": \"ghi\","));
+
+    // The partial message is completed by the next read
+    EXPECT_EQ(1, ioc.poll_one());
+    EXPECT_EQ("", err.str());
+
+    out_str = out.str();
+    EXPECT_NE(std::string::npos, out_str.find("    \"name\": \"ghi\","));
+}
+
+TEST_F(Connection, BulkReadInvalidMessageLength) {
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 8>{
+        0x00, 0x00, 0x00, 0x02, // message length smaller than the length field
+        0x00, 0x00, 0x00, 0x00
+    };
+    // clang-format on
+
+    push_data(asio::buffer(message));
+    logger::make_connection(
+        std::move(socket), logger::Output{out, err}, {logger::receive_mode::bulk});
+
+    err.str("");
+
+    EXPECT_EQ(1, ioc.poll_one());
+    EXPECT_EQ("", out.str());
+    EXPECT_EQ("[test_address:12345] Unable to decode message: message length is invalid.\n"
+              "[test_address:12345] Terminating connection\n",
+              err.str());
+}
+
+TEST_F(Connection, RawCaptureWritesCompleteMessages) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 2 * n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        0xff, 0xff, 0xff, // name, which is not decoded
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'd', 'e', 'f' // name
+    };
+    // clang-format on
+
+    // The first read ends within the second message
+    push_data(asio::buffer(message));
+    socket.read_size(n + 6);
+
+    auto options = logger::connection_options{};
+    options.raw = true;
+    logger::make_connection(std::move(socket), logger::Output{out, err}, options);
+
+    err.str("");
+
+    EXPECT_EQ(1, ioc.poll_one());
+    EXPECT_EQ(1, ioc.poll_one());
+    EXPECT_EQ("", err.str());
+
+    const auto out_str = out.str();
+    auto capture = asio::buffer(out_str);
+
+    // Each read with complete messages is written as a separate segment
+    const auto frames_per_read = std::array<asio::const_buffer, 2>{
+        asio::buffer(message, n),
+        asio::buffer(message) + n,
+    };
+    for (const auto& frames : frames_per_read) {
+        ASSERT_LE(logger::capture_size::fixed_header, capture.size());
+        const auto header_size = logger::decode_segment_header_size(
+            asio::buffer(capture, logger::capture_size::fixed_header));
+
+        const auto header = logger::decode_segment_header(asio::buffer(capture, header_size));
+        EXPECT_EQ("test_address:12345", header.endpoint);
+        EXPECT_EQ(frames.size(), header.payload_length);
+        capture += header_size;
+
+        ASSERT_LE(frames.size(), capture.size());
+        EXPECT_EQ(0, std::memcmp(frames.data(), capture.data(), frames.size()));
+        capture += frames.size();
+    }
+
+    EXPECT_EQ(0, capture.size());
+}
+
+TEST_F(Connection, MetricsCountMessagesAndErrors) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 2 * n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        0xff, 0xff, 0xff // name
+    };
+    // clang-format on
+
+    auto metrics = logger::Metrics{};
+
+    push_data(asio::buffer(message));
+    socket.close_remote();
+    auto options = logger::connection_options{logger::receive_mode::bulk};
+    options.metrics = &metrics;
+    logger::make_connection(std::move(socket), logger::Output{out, err}, options);
+
+    ioc.run();
+
+    auto report = std::stringstream{};
+    metrics.report(report);
+
+    const auto report_str = report.str();
+    EXPECT_NE(std::string::npos, report_str.find("connections_open 0\n"));
+    EXPECT_NE(std::string::npos, report_str.find("connections_closed 1\n"));
+    EXPECT_NE(std::string::npos, report_str.find("messages 2\n"));
+    EXPECT_NE(std::string::npos, report_str.find("bytes 32\n"));
+    EXPECT_NE(std::string::npos, report_str.find("decode_errors 0\n"));
+    EXPECT_NE(std::string::npos, report_str.find("string_errors 1\n"));
+    const auto latencies = metrics.latencies();
+    EXPECT_EQ(2, latencies->decode_latency.count());
+    EXPECT_EQ(1, latencies->serialize_latency.count());
+    EXPECT_EQ(1, latencies->lag.count());
+}
+
+TEST_F(Connection, DictionaryDefinesEachNameOnce) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 3 * n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'd', 'e', 'f', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c' // name
+    };
+    // clang-format on
+
+    auto names = logger::NameTable{16};
+
+    push_data(asio::buffer(message));
+    socket.close_remote();
+    auto options = logger::connection_options{logger::receive_mode::bulk};
+    options.format = reader::json_format::compact;
+    options.names = &names;
+    logger::make_connection(std::move(socket), logger::Output{out, err}, options);
+
+    ioc.run();
+
+    auto records = std::istringstream{out.str()};
+    auto lines = std::vector<std::string>{};
+    for (auto line = std::string{}; std::getline(records, line);) {
+        lines.push_back(line.substr(0, line.find(",\"timestamp\"")));
+    }
+
+    EXPECT_EQ((std::vector<std::string>{
+                  R"({"id":0,"name":"abc"})",
+                  R"({"name_id":0)",
+                  R"({"id":1,"name":"def"})",
+                  R"({"name_id":1)",
+                  R"({"name_id":0)",
+              }),
+              lines);
+    EXPECT_EQ(2, names.size());
+}
+
+TEST_F(Connection, DictionaryWritesNamesWhenFull) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 2 * n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'd', 'e', 'f' // name
+    };
+    // clang-format on
+
+    auto names = logger::NameTable{1};
+
+    push_data(asio::buffer(message));
+    socket.close_remote();
+    auto options = logger::connection_options{logger::receive_mode::bulk};
+    options.format = reader::json_format::compact;
+    options.names = &names;
+    logger::make_connection(std::move(socket), logger::Output{out, err}, options);
+
+    ioc.run();
+
+    auto records = std::istringstream{out.str()};
+    auto lines = std::vector<std::string>{};
+    for (auto line = std::string{}; std::getline(records, line);) {
+        lines.push_back(line.substr(0, line.find(",\"timestamp\"")));
+    }
+
+    EXPECT_EQ((std::vector<std::string>{
+                  R"({"id":0,"name":"abc"})",
+                  R"({"name_id":0)",
+                  R"({"name":"def")",
+              }),
+              lines);
+}
+
+TEST_F(Connection, FilterDropsMessagesBeforeDecoding) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 4 * n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'd', 'e', 'f', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x05, // nlen
+        'd', 'e', 'f', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c' // name
+    };
+    // clang-format on
+
+    const auto filter = reader::Filter::compile("name = abc");
+    ASSERT_TRUE(filter);
+    auto metrics = logger::Metrics{};
+
+    push_data(asio::buffer(message));
+    socket.close_remote();
+    auto options = logger::connection_options{};
+    options.format = reader::json_format::compact;
+    options.filter = &*filter;
+    options.metrics = &metrics;
+    logger::make_connection(std::move(socket), logger::Output{out, err}, options);
+
+    ioc.run();
+
+    // Messages which cannot be decoded are kept, so that they are reported
+    auto records = std::istringstream{out.str()};
+    auto lines = std::vector<std::string>{};
+    for (auto line = std::string{}; std::getline(records, line);) {
+        lines.push_back(line.substr(0, line.find(",\"timestamp\"")));
+    }
+    EXPECT_EQ((std::vector<std::string>{R"({"name":"abc")", R"({"name":"abc")"}), lines);
+    EXPECT_NE(std::string::npos, err.str().find("Unable to decode message"));
+
+    auto report = std::stringstream{};
+    metrics.report(report);
+
+    const auto report_str = report.str();
+    EXPECT_NE(std::string::npos, report_str.find("messages 4\n"));
+    EXPECT_NE(std::string::npos, report_str.find("bytes 64\n"));
+    EXPECT_NE(std::string::npos, report_str.find("decode_errors 1\n"));
+    EXPECT_NE(std::string::npos, report_str.find("filtered 1\n"));
+    EXPECT_EQ(3, metrics.latencies()->decode_latency.count());
+}
+
+TEST_F(Connection, BulkReadFilterDropsMessagesBeforeDecoding) {
+    constexpr auto n = 16;
+    // clang-format off
+    constexpr auto message = std::array<uint8_t, 5 * n>{
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'd', 'e', 'f', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'g', 'h', 'i', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x05, // nlen
+        'd', 'e', 'f', // name
+        0x00, 0x00, 0x00, n, // message length
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // timestamp
+        0x03, // nlen
+        'a', 'b', 'c' // name
+    };
+    // clang-format on
+
+    const auto filter = reader::Filter::compile("name = abc");
+    ASSERT_TRUE(filter);
+    auto metrics = logger::Metrics{};
+
+    push_data(asio::buffer(message));
+    socket.close_remote();
+    auto options = logger::connection_options{logger::receive_mode::bulk};
+    options.format = reader::json_format::compact;
+    options.filter = &*filter;
+    options.metrics = &metrics;
+    logger::make_connection(std::move(socket), logger::Output{out, err}, options);
+
+    ioc.run();
+
+    auto records = std::istringstream{out.str()};
+    auto lines = std::vector<std::string>{};
+    for (auto line = std::string{}; std::getline(records, line);) {
+        lines.push_back(line.substr(0, line.find(",\"timestamp\"")));
+    }
+    EXPECT_EQ((std::vector<std::string>{R"({"name":"abc")", R"({"name":"abc")"}), lines);
+    EXPECT_NE(std::string::npos, err.str().find("Unable to decode message"));
+
+    auto report = std::stringstream{};
+    metrics.report(report);
+
+    const auto report_str = report.str();
+    EXPECT_NE(std::string::npos, report_str.find("messages 5\n"));
+    EXPECT_NE(std::string::npos, report_str.find("bytes 80\n"));
+    EXPECT_NE(std::string::npos, report_str.find("decode_errors 1\n"));
+    EXPECT_NE(std::string::npos, report_str.find("filtered 2\n"));
+}
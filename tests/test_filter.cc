@@ -0,0 +1,190 @@
+#include "compat/asio.h"
+#include "filter.h"
+#include "message.h"
+#include "test/encode.h"
+#include "wire.h"
+
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+/// @brief Compiles a filter, failing the test if the expression is invalid
+auto compile(std::string_view expression) -> reader::Filter {
+    auto filter = reader::Filter::compile(expression);
+    EXPECT_TRUE(filter) << expression << ": " << filter.error();
+    return filter ? *filter : *reader::Filter::compile("has temperature or not has temperature");
+}
+
+auto matches(std::string_view expression, const reader::wire::message_fields& fields) -> bool {
+    return compile(expression).matches(asio::buffer(test::encode(fields)));
+}
+
+auto error(std::string_view expression) -> std::string {
+    const auto filter = reader::Filter::compile(expression);
+    EXPECT_FALSE(filter) << expression;
+    return filter ? std::string{} : filter.error();
+}
+
+// 2020-06-28T14:51:50.240Z
+constexpr auto timestamp = std::uint64_t{1593355910240};
+
+const auto kitchen = reader::wire::message_fields{timestamp, "kitchen-1", 29815, 455};
+const auto garage = reader::wire::message_fields{timestamp, "garage", std::nullopt, 700};
+
+} // namespace
+
+TEST(Filter, MatchesNames) {
+    EXPECT_TRUE(matches("name = kitchen-1", kitchen));
+    EXPECT_FALSE(matches("name = kitchen", kitchen));
+    EXPECT_TRUE(matches("name ^= kitchen", kitchen));
+    EXPECT_TRUE(matches("name ^= \"\"", kitchen));
+    EXPECT_FALSE(matches("name ^= kitchen-10", kitchen));
+    EXPECT_FALSE(matches("name ^= kitchen", garage));
+}
+
+TEST(Filter, MatchesQuotedNames) {
+    const auto quoted = reader::wire::message_fields{timestamp, "a \"b\" \\ (c)", 0, 0};
+    EXPECT_TRUE(matches(R"x(name = "a \"b\" \\ (c)")x", quoted));
+    EXPECT_TRUE(matches(R"(name="kitchen-1")", kitchen));
+    EXPECT_TRUE(matches(R"(name^="kitchen")", kitchen));
+}
+
+TEST(Filter, MatchesTemperatures) {
+    // 29815 hundredths of K is 25 °C
+    EXPECT_TRUE(matches("temperature >= 25", kitchen));
+    EXPECT_FALSE(matches("temperature > 25", kitchen));
+    EXPECT_TRUE(matches("temperature <= 25", kitchen));
+    EXPECT_FALSE(matches("temperature < 25", kitchen));
+    EXPECT_TRUE(matches("temperature > -10.5 and temperature < 30", kitchen));
+
+    // Messages without a temperature never match a range
+    EXPECT_FALSE(matches("temperature < 1000", garage));
+    EXPECT_FALSE(matches("temperature > -1000", garage));
+}
+
+TEST(Filter, MatchesHumidities) {
+    EXPECT_TRUE(matches("humidity >= 45.5", kitchen));
+    EXPECT_FALSE(matches("humidity > 45.5", kitchen));
+    EXPECT_TRUE(matches("humidity>70", reader::wire::message_fields{timestamp, "a", 0, 701}));
+    EXPECT_FALSE(
+        matches("humidity < 100", reader::wire::message_fields{timestamp, "a", 0, std::nullopt}));
+}
+
+TEST(Filter, MatchesRangesAsDecoded) {
+    // Bounds are compared with the decoded value, including around the rounding of each unit
+    const auto expressions = std::vector<std::string>{
+        "temperature < 0",  "temperature <= 0",     "temperature > 0",     "temperature >= 0",
+        "temperature < 0.1", "temperature >= 20.07", "temperature > -273.15", "humidity < 33.3",
+        "humidity <= 33.3", "humidity > 0.1",        "humidity >= 0"};
+
+    for (const auto& expression : expressions) {
+        const auto filter = compile(expression);
+        const auto separator = expression.find(' ');
+        const auto field = expression.substr(0, separator);
+        const auto op = expression.substr(separator + 1, expression.find(' ', separator + 1) -
+                                                             separator - 1);
+        const auto bound = std::stof(expression.substr(expression.rfind(' ') + 1));
+
+        for (auto encoded = std::uint32_t{0}; encoded < 40000; ++encoded) {
+            const auto fields =
+                field == "temperature"
+                    ? reader::wire::message_fields{timestamp, "a", encoded, std::nullopt}
+                    : reader::wire::message_fields{
+                          timestamp, "a", std::nullopt, static_cast<std::uint16_t>(encoded)};
+            const auto payload = test::encode(fields);
+            const auto message = reader::try_decode_view(asio::buffer(payload));
+            ASSERT_TRUE(message);
+            const auto value = field == "temperature" ? *message->temperature()
+                                                      : *message->humidity();
+
+            const auto expected = op == "<"    ? value < bound
+                                  : op == "<=" ? value <= bound
+                                  : op == ">"  ? value > bound
+                                               : value >= bound;
+            ASSERT_EQ(expected, filter.matches(asio::buffer(payload)))
+                << expression << " with " << encoded;
+        }
+    }
+}
+
+TEST(Filter, MatchesTimestamps) {
+    EXPECT_TRUE(matches("timestamp >= 2020-06-28T14:51:50.240Z", kitchen));
+    EXPECT_FALSE(matches("timestamp > 2020-06-28T14:51:50.240Z", kitchen));
+    EXPECT_TRUE(matches("timestamp < 2020-06-28T16:51:50.241+0200", kitchen));
+    EXPECT_FALSE(matches("timestamp < 2020-06-28T14:51:50.240Z", kitchen));
+    EXPECT_TRUE(matches("timestamp > 1960-01-01T00:00:00Z", kitchen));
+    EXPECT_FALSE(matches("timestamp <= 1960-01-01T00:00:00Z", kitchen));
+
+    // Encoded timestamps are signed, as they are decoded
+    const auto before_epoch =
+        reader::wire::message_fields{static_cast<std::uint64_t>(-1000), "a", 0, 0};
+    EXPECT_TRUE(matches("timestamp < 1970-01-01T00:00:00Z", before_epoch));
+    EXPECT_TRUE(matches("timestamp >= 1969-12-31T23:59:59Z", before_epoch));
+    EXPECT_FALSE(matches("timestamp > 1969-12-31T23:59:59Z", before_epoch));
+    EXPECT_FALSE(matches("timestamp > 2020-06-28T14:51:50.240Z", before_epoch));
+}
+
+TEST(Filter, MatchesPresence) {
+    EXPECT_TRUE(matches("has temperature", kitchen));
+    EXPECT_FALSE(matches("has temperature", garage));
+    EXPECT_TRUE(matches("has humidity", garage));
+}
+
+TEST(Filter, CombinesConditions) {
+    const auto expression = "name ^= kitchen and (temperature > 30 or not has humidity)";
+    EXPECT_FALSE(matches(expression, kitchen));
+    EXPECT_TRUE(
+        matches(expression, reader::wire::message_fields{timestamp, "kitchen-2", 31000, 0}));
+    EXPECT_TRUE(matches(expression,
+                        reader::wire::message_fields{timestamp, "kitchen-2", 0, std::nullopt}));
+    EXPECT_FALSE(matches(expression, garage));
+
+    // `and` takes precedence over `or`
+    EXPECT_TRUE(matches("name = garage or name = kitchen-1 and has humidity", garage));
+    EXPECT_FALSE(matches("(name = garage or name = kitchen-1) and has temperature", garage));
+    EXPECT_TRUE(matches("not not has humidity", garage));
+}
+
+TEST(Filter, KeepsPayloadsWhichCannotBeDecoded) {
+    const auto filter = compile("name = kitchen-1");
+
+    // Unused bytes after the humidity
+    auto payload = test::encode(garage);
+    payload.insert(payload.end(), {0, 0});
+    EXPECT_TRUE(filter.matches(asio::buffer(payload)));
+    EXPECT_TRUE(filter.matches(asio::buffer(payload.data(), 3)));
+}
+
+TEST(Filter, DescribesInvalidExpressions) {
+    EXPECT_EQ("expected a condition at the end of the expression", error(""));
+    EXPECT_EQ("expected a condition at column 1", error("colour = red"));
+    EXPECT_EQ("expected `=` or `^=` at column 6", error("name < a"));
+    EXPECT_EQ("expected a name at the end of the expression", error("name ="));
+    EXPECT_EQ("expected `<`, `<=`, `>` or `>=` at column 13", error("temperature = 1"));
+    EXPECT_EQ("expected a number at column 15", error("temperature > warm"));
+    EXPECT_EQ("expected a number at column 12", error("humidity > nan"));
+    EXPECT_EQ("expected a date and time at column 13", error("timestamp > yesterday"));
+    EXPECT_EQ("expected `temperature` or `humidity` at column 5", error("has name"));
+    EXPECT_EQ("expected `)` at the end of the expression", error("(has humidity"));
+    EXPECT_EQ("expected `and`, `or` or the end of the expression at column 14",
+              error("has humidity has temperature"));
+    EXPECT_EQ("unterminated string at column 8", error("name = \"abc"));
+}
+
+TEST(Filter, LimitsNesting) {
+    auto nested = std::string{};
+    for (auto i = std::size_t{0}; i < reader::Filter::max_depth; ++i) {
+        nested += "(";
+    }
+    EXPECT_EQ("expression is nested too deeply at column 65", error(nested + "has humidity"));
+
+    auto deep = std::string{"has humidity"};
+    for (auto i = std::size_t{1}; i < reader::Filter::max_depth; ++i) {
+        deep = "has humidity and (" + deep + ")";
+    }
+    EXPECT_TRUE(reader::Filter::compile(deep));
+}
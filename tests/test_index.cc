@@ -0,0 +1,159 @@
+#include "index.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+using time_point_t = logger::record_info::time_point_t;
+
+auto at(std::int64_t ms) -> time_point_t {
+    return time_point_t{std::chrono::milliseconds{ms}};
+}
+
+/// Offsets of the blocks returned by a query
+auto offsets(const std::vector<const logger::index_block*>& blocks) -> std::vector<std::uint64_t> {
+    auto result = std::vector<std::uint64_t>{};
+    for (const auto block : blocks) {
+        result.push_back(block->offset);
+    }
+    return result;
+}
+
+/// Encodes an index of records of 10 bytes each, in blocks of 30 bytes
+auto build(const std::vector<logger::record_info>& records) -> std::string {
+    auto builder = logger::IndexBuilder{30};
+
+    auto offset = std::uint64_t{0};
+    for (const auto& record : records) {
+        builder.add(offset, record);
+        offset += 10;
+    }
+    builder.finish(offset);
+
+    auto encoded = std::string{};
+    builder.take(encoded);
+    return encoded;
+}
+
+} // namespace
+
+TEST(Index, EmptyIndex) {
+    const auto index = logger::Index{build({})};
+
+    EXPECT_TRUE(index.blocks().empty());
+    EXPECT_EQ(0, index.end());
+}
+
+TEST(Index, BlocksStartAtRecords) {
+    const auto index = logger::Index{build({
+        {"abc", at(10)},
+        {"def", at(5)},
+        {"abc", at(20)},
+        {"abc", at(30)},
+        {"ghi", std::nullopt},
+    })};
+
+    ASSERT_EQ(2, index.blocks().size());
+    EXPECT_EQ(50, index.end());
+
+    const auto& first = index.blocks()[0];
+    EXPECT_EQ(0, first.offset);
+    EXPECT_EQ(30, first.size);
+    EXPECT_EQ(5, first.min_timestamp);
+    EXPECT_EQ(20, first.max_timestamp);
+    EXPECT_EQ(3, first.records);
+    EXPECT_EQ((std::vector<std::uint32_t>{0, 1}), first.names);
+
+    const auto& second = index.blocks()[1];
+    EXPECT_EQ(30, second.offset);
+    EXPECT_EQ(20, second.size);
+    EXPECT_EQ(30, second.min_timestamp);
+    EXPECT_EQ(30, second.max_timestamp);
+    EXPECT_EQ(2, second.records);
+    EXPECT_EQ((std::vector<std::uint32_t>{0, 2}), second.names);
+}
+
+TEST(Index, FindByName) {
+    const auto index = logger::Index{build({
+        {"abc", at(0)},
+        {"abc", at(0)},
+        {"abc", at(0)},
+        {"def", at(0)},
+        {"def", at(0)},
+        {"def", at(0)},
+        {"abc", at(0)},
+    })};
+
+    const auto all = std::pair{time_point_t::min(), time_point_t::max()};
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 60}),
+              offsets(index.find("abc", all.first, all.second)));
+    EXPECT_EQ((std::vector<std::uint64_t>{30}), offsets(index.find("def", all.first, all.second)));
+    EXPECT_TRUE(index.find("ghi", all.first, all.second).empty());
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 30, 60}),
+              offsets(index.find(std::nullopt, all.first, all.second)));
+}
+
+TEST(Index, FindByTime) {
+    const auto index = logger::Index{build({
+        {"abc", at(100)},
+        {"abc", at(110)},
+        {"abc", at(120)},
+        {"abc", at(200)},
+        {"abc", at(150)},
+        {"abc", at(210)},
+        {"abc", std::nullopt},
+    })};
+
+    EXPECT_EQ((std::vector<std::uint64_t>{0}), offsets(index.find(std::nullopt, at(0), at(100))));
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 30}),
+              offsets(index.find(std::nullopt, at(115), at(160))));
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 30}),
+              offsets(index.find(std::nullopt, at(160), at(170))));
+    EXPECT_TRUE(index.find(std::nullopt, at(211), at(300)).empty());
+
+    // Blocks without timestamps are only found by name
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 60}), offsets(index.find("abc", at(211), at(300))));
+}
+
+TEST(Index, FindByNameIncludesFirstBlockOfName) {
+    const auto index = logger::Index{build({
+        {"abc", std::nullopt},
+        {"abc", at(100)},
+        {"abc", at(110)},
+        {"abc", at(200)},
+        {"def", std::nullopt},
+        {"def", at(210)},
+        {"abc", at(220)},
+    })};
+
+    // The first block of a name contains its definition, which is needed to resolve later records
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 30, 60}),
+              offsets(index.find("abc", at(200), at(300))));
+    EXPECT_EQ((std::vector<std::uint64_t>{30}), offsets(index.find("def", at(0), at(50))));
+
+    // Without a name, the first blocks of the names in the blocks matched by time are included
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 30, 60}),
+              offsets(index.find(std::nullopt, at(200), at(300))));
+    EXPECT_EQ((std::vector<std::uint64_t>{0}), offsets(index.find(std::nullopt, at(0), at(105))));
+}
+
+TEST(Index, IncompleteEntryIsIgnored) {
+    const auto encoded = build({{"abc", at(0)}, {"abc", at(0)}, {"abc", at(0)}, {"def", at(0)}});
+    const auto complete = logger::Index{encoded};
+    ASSERT_EQ(2, complete.blocks().size());
+
+    for (auto size = logger::index_magic.size(); size < encoded.size(); ++size) {
+        const auto index = logger::Index{std::string_view{encoded}.substr(0, size)};
+        EXPECT_LE(index.blocks().size(), 1);
+    }
+}
+
+TEST(Index, InvalidIndex) {
+    EXPECT_THROW(logger::Index{"XIDX"}, logger::bad_index_data);
+    EXPECT_THROW(logger::Index{"RIDXZ"}, logger::bad_index_data);
+}
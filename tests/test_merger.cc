@@ -0,0 +1,270 @@
+#include "merger.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+using time_point_t = logger::Merger::time_point_t;
+
+auto at(std::int64_t ms) -> time_point_t {
+    return time_point_t{std::chrono::milliseconds{ms}};
+}
+
+/// Records the output of a Merger
+struct records {
+    auto sink() -> logger::Merger::sink_type {
+        return [this](std::string_view record, const logger::record_info& info) {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            written.emplace_back(record);
+            names.emplace_back(info.name);
+            timestamps.push_back(info.timestamp);
+        };
+    }
+
+    auto late_handler() -> logger::Merger::late_handler_type {
+        return [this](std::uint64_t count, std::chrono::milliseconds behind) {
+            late.emplace_back(count, behind);
+        };
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> written;
+    std::vector<std::string> names;
+    std::vector<std::optional<time_point_t>> timestamps;
+    std::vector<std::pair<std::uint64_t, std::chrono::milliseconds>> late;
+};
+
+} // namespace
+
+TEST(Merger, MergesSourcesInTimestampOrder) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink()};
+    auto a = merger.open();
+    auto b = merger.open();
+
+    a.add("a0", {"a", at(0)});
+    a.add("a20", {"a", at(20)});
+    b.add("b10", {"b", at(10)});
+    b.add("b30", {"b", at(30)});
+    a.add("a40", {"a", at(40)});
+    EXPECT_TRUE(out.written.empty());
+    EXPECT_EQ(5, merger.buffered());
+
+    merger.flush();
+    EXPECT_EQ((std::vector<std::string>{"a0", "b10", "a20", "b30", "a40"}), out.written);
+    EXPECT_EQ((std::vector<std::string>{"a", "b", "a", "b", "a"}), out.names);
+    EXPECT_EQ(at(10), out.timestamps[1]);
+    EXPECT_EQ(0, merger.buffered());
+}
+
+TEST(Merger, ReleasesRecordsBehindTheWindow) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink()};
+    auto a = merger.open();
+    auto b = merger.open();
+
+    a.add("a0", {"a", at(0)});
+    b.add("b50", {"b", at(50)});
+    a.add("a120", {"a", at(120)});
+    EXPECT_EQ((std::vector<std::string>{"a0"}), out.written);
+
+    b.add("b220", {"b", at(220)});
+    EXPECT_EQ((std::vector<std::string>{"a0", "b50", "a120"}), out.written);
+    EXPECT_EQ(1, merger.buffered());
+}
+
+TEST(Merger, OrdersRecordsWithinASource) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink()};
+    auto a = merger.open();
+
+    a.add("a30", {"a", at(30)});
+    a.add("a10", {"a", at(10)});
+    a.add("a20", {"a", at(20)});
+    a.add("a10'", {"a", at(10)});
+    merger.flush();
+
+    EXPECT_EQ((std::vector<std::string>{"a10", "a10'", "a20", "a30"}), out.written);
+    EXPECT_EQ(0, merger.late());
+}
+
+TEST(Merger, BreaksTiesInArrivalOrder) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink()};
+    auto a = merger.open();
+    auto b = merger.open();
+
+    b.add("b", {"b", at(10)});
+    a.add("a", {"a", at(10)});
+    merger.flush();
+
+    EXPECT_EQ((std::vector<std::string>{"b", "a"}), out.written);
+}
+
+TEST(Merger, FlagsLateRecords) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink(), out.late_handler()};
+    auto a = merger.open();
+    auto b = merger.open();
+
+    a.add("a0", {"a", at(0)});
+    a.add("a150", {"a", at(150)});
+    ASSERT_EQ((std::vector<std::string>{"a0"}), out.written);
+
+    // Written immediately, after a record it precedes
+    b.add("b-30", {"b", at(-30)});
+    b.add("b-10", {"b", at(-10)});
+    EXPECT_EQ((std::vector<std::string>{"a0", "b-30", "b-10"}), out.written);
+    EXPECT_EQ(2, merger.late());
+
+    // Behind the watermark, but after the last record released
+    b.add("b20", {"b", at(20)});
+    EXPECT_EQ((std::vector<std::string>{"a0", "b-30", "b-10", "b20"}), out.written);
+    EXPECT_EQ(2, merger.late());
+
+    // Late records are reported together, once per expiry
+    EXPECT_TRUE(out.late.empty());
+    merger.expire();
+    ASSERT_EQ(1, out.late.size());
+    EXPECT_EQ(2, out.late[0].first);
+    EXPECT_EQ(30ms, out.late[0].second);
+
+    merger.expire();
+    EXPECT_EQ(1, out.late.size());
+}
+
+TEST(Merger, WritesRecordsAheadOfTheClockImmediately) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink(), out.late_handler()};
+    auto a = merger.open();
+    auto b = merger.open();
+
+    const auto future = logger::Merger::clock_t::now() + 24h;
+    a.add("future", {"a", future});
+    EXPECT_EQ((std::vector<std::string>{"future"}), out.written);
+    EXPECT_EQ(1, merger.late());
+
+    // The watermark is not advanced by the record ahead of the clock
+    b.add("b0", {"b", at(0)});
+    b.add("b50", {"b", at(50)});
+    a.add("a120", {"a", at(120)});
+    EXPECT_EQ((std::vector<std::string>{"future", "b0"}), out.written);
+    EXPECT_EQ(1, merger.late());
+
+    merger.flush();
+    ASSERT_EQ(1, out.late.size());
+    EXPECT_EQ(1, out.late[0].first);
+}
+
+TEST(Merger, WritesRecordsWithoutTimestampImmediately) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink()};
+    auto a = merger.open();
+
+    a.add("a0", {"a", at(0)});
+    a.add("definition", {"a", std::nullopt});
+
+    EXPECT_EQ((std::vector<std::string>{"definition"}), out.written);
+    EXPECT_EQ(std::nullopt, out.timestamps[0]);
+}
+
+TEST(Merger, ExpiresWhenIdle) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink()};
+    auto a = merger.open();
+
+    a.add("a0", {"a", at(0)});
+    merger.expire();
+    EXPECT_TRUE(out.written.empty());
+
+    merger.expire();
+    EXPECT_EQ((std::vector<std::string>{"a0"}), out.written);
+}
+
+TEST(Merger, ReleasesRecordsOfClosedSources) {
+    auto out = records{};
+    auto merger = logger::Merger{100ms, out.sink()};
+    auto b = merger.open();
+    {
+        auto a = merger.open();
+        a.add("a0", {"a", at(0)});
+        a.add("a20", {"a", at(20)});
+    }
+
+    b.add("b150", {"b", at(150)});
+    EXPECT_EQ((std::vector<std::string>{"a0", "a20"}), out.written);
+}
+
+TEST(Merger, AddsRecordsWhileTheSinkWrites) {
+    auto mutex = std::mutex{};
+    auto changed = std::condition_variable{};
+    auto writing = false;
+    auto added = false;
+    auto added_while_writing = false;
+
+    auto merger = logger::Merger{
+        100ms, [&](std::string_view record, const logger::record_info&) {
+            if (record != "a0") {
+                return;
+            }
+            auto lock = std::unique_lock<std::mutex>{mutex};
+            writing = true;
+            changed.notify_all();
+            added_while_writing = changed.wait_for(lock, 10s, [&]() { return added; });
+        }};
+    auto a = merger.open();
+    auto b = merger.open();
+
+    a.add("a0", {"a", at(0)});
+    auto thread = std::thread{[&a]() { a.add("a150", {"a", at(150)}); }};
+    {
+        auto lock = std::unique_lock<std::mutex>{mutex};
+        changed.wait(lock, [&]() { return writing; });
+    }
+
+    b.add("b120", {"b", at(120)});
+    {
+        const auto lock = std::lock_guard<std::mutex>{mutex};
+        added = true;
+    }
+    changed.notify_all();
+    thread.join();
+
+    EXPECT_TRUE(added_while_writing);
+    EXPECT_EQ(2, merger.buffered());
+}
+
+TEST(Merger, MergesConcurrently) {
+    auto out = records{};
+    auto merger = logger::Merger{1min, out.sink()};
+
+    constexpr auto messages = 1000;
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&merger, i]() {
+            auto source = merger.open();
+            for (auto ms = 0; ms < messages; ++ms) {
+                source.add(std::to_string(i), {"s", at(ms * 4 + i)});
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    merger.flush();
+
+    ASSERT_EQ(4 * messages, out.timestamps.size());
+    EXPECT_TRUE(std::is_sorted(out.timestamps.cbegin(), out.timestamps.cend()));
+    EXPECT_EQ(0, merger.late());
+}
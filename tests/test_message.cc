@@ -179,3 +179,145 @@ TEST(Message, NLenTooLargeForBuffer) {
 
     EXPECT_THROW(reader::Message{asio::buffer(data)};, reader::bad_message_data);
 }
+
+TEST_F(MessageWithDefaults, ViewFromHandCreatedSensorData) {
+    const auto data = fill_with(timestamp_ms, name, temperature_centi_K, humidity_deci_percent);
+    const auto view = reader::MessageView{asio::buffer(data)};
+
+    EXPECT_EQ(expected_timestamp, view.timestamp());
+    EXPECT_EQ("handdata", view.name());
+    EXPECT_EQ(0.0f, view.temperature());
+    EXPECT_EQ(1.0f, view.humidity());
+}
+
+TEST_F(MessageWithDefaults, ViewReferencesWireData) {
+    const auto data = fill_with(timestamp_ms, name, humidity_deci_percent);
+    const auto view = reader::MessageView{asio::buffer(data)};
+
+    EXPECT_EQ(static_cast<const void*>(&data[ws::timestamp + ws::nlen]), view.name().data());
+    EXPECT_EQ(std::nullopt, view.temperature());
+    EXPECT_EQ(1.0f, view.humidity());
+}
+
+TEST_F(MessageWithDefaults, MessageFromView) {
+    const auto data = fill_with(timestamp_ms, name, temperature_centi_K);
+    const auto view = reader::MessageView{asio::buffer(data)};
+    const auto message = reader::Message{view};
+
+    EXPECT_EQ(view.timestamp(), message.timestamp());
+    EXPECT_EQ(view.name(), message.name());
+    EXPECT_EQ(view.temperature(), message.temperature());
+    EXPECT_EQ(view.humidity(), message.humidity());
+    EXPECT_EQ(view.as_json(), message.as_json());
+}
+
+TEST_F(MessageWithDefaults, ViewBufferTooLarge) {
+    const auto data = fill_with(timestamp_ms, name, temperature_centi_K, humidity_deci_percent);
+    auto data2 = std::array<std::byte, 1 + std::tuple_size_v<decltype(data)>>{};
+    std::copy(data.cbegin(), data.cend(), data2.begin());
+
+    EXPECT_THROW(reader::MessageView{asio::buffer(data2)};, reader::bad_message_data);
+}
+
+TEST(MessageView, BufferTooSmall) {
+    std::array<std::byte, ws::timestamp> data;
+
+    EXPECT_THROW(reader::MessageView{asio::buffer(data)};, reader::bad_message_data);
+}
+
+TEST(MessageView, InvalidUtf8Name) {
+    const auto names = std::vector<std::string>{
+        "\xff\xff\xff",
+        "ab\xc3",
+        "ab\xc3\x41",
+        "\xe0\x80\x80",
+        "\xed\xa0\x80",
+        "\xf0\x9f\x98",
+        "\xf4\x90\x80\x80",
+        "\xc0\xaf",
+        "a long name with ASCII characters before an invalid byte \xff",
+    };
+
+    for (const auto& name : names) {
+        auto data = std::vector<unsigned char>(ws::timestamp);
+        data.push_back(static_cast<unsigned char>(name.size()));
+        data.insert(data.end(), name.cbegin(), name.cend());
+
+        auto expected = std::string{};
+        try {
+            nlohmann::json(name).dump();
+        } catch (const nlohmann::json::type_error& ex) {
+            expected = ex.what();
+        }
+
+        try {
+            reader::MessageView{asio::buffer(data)};
+            ADD_FAILURE() << "expected bad_string_data";
+        } catch (const reader::bad_string_data& ex) {
+            EXPECT_EQ(expected, "[json.exception.type_error.316] " + std::string{ex.what()});
+        }
+    }
+}
+
+TEST_F(MessageWithDefaults, TryDecode) {
+    const auto data = fill_with(timestamp_ms, name, temperature_centi_K, humidity_deci_percent);
+
+    const auto view = reader::try_decode_view(asio::buffer(data));
+    ASSERT_TRUE(view);
+    EXPECT_EQ("handdata", view->name());
+    EXPECT_EQ(1.0f, view->humidity());
+
+    const auto message = reader::try_decode(asio::buffer(data));
+    ASSERT_TRUE(message);
+    EXPECT_EQ(expected_timestamp, message->timestamp());
+    EXPECT_EQ("handdata", message->name());
+    EXPECT_EQ(0.0f, message->temperature());
+}
+
+TEST_F(MessageWithDefaults, TryDecodeErrors) {
+    const auto valid = fill_with(timestamp_ms, name, temperature_centi_K, humidity_deci_percent);
+
+    auto too_large = std::vector<std::byte>(valid.cbegin(), valid.cend());
+    too_large.push_back(std::byte{});
+
+    auto name_overrun = std::vector<std::byte>(valid.cbegin(), valid.cend());
+    name_overrun[ws::timestamp] = std::byte{200};
+
+    auto invalid_name = std::vector<std::byte>(valid.cbegin(), valid.cend());
+    invalid_name[ws::timestamp + ws::nlen] = std::byte{0xff};
+
+    const auto cases = std::vector<std::pair<std::vector<std::byte>, reader::decode_error>>{
+        {std::vector<std::byte>(ws::timestamp), reader::decode_error::too_small},
+        {name_overrun, reader::decode_error::name_overrun},
+        {too_large, reader::decode_error::unused_bytes},
+        {invalid_name, reader::decode_error::invalid_name},
+    };
+
+    for (const auto& [data, error] : cases) {
+        const auto view = reader::try_decode_view(asio::buffer(data));
+        ASSERT_FALSE(view);
+        EXPECT_EQ(error, view.error());
+
+        const auto message = reader::try_decode(asio::buffer(data));
+        ASSERT_FALSE(message);
+        EXPECT_EQ(error, message.error());
+    }
+}
+
+TEST_F(MessageWithDefaults, DescribeMatchesExceptions) {
+    const auto valid = fill_with(timestamp_ms, name, temperature_centi_K);
+
+    auto too_small = std::vector<std::byte>(ws::timestamp);
+    auto invalid_name = std::vector<std::byte>(valid.cbegin(), valid.cend());
+    invalid_name[ws::timestamp + ws::nlen + 1] = std::byte{0xc3};
+
+    for (const auto& data : {too_small, invalid_name}) {
+        const auto error = reader::try_decode_view(asio::buffer(data)).error();
+        try {
+            reader::MessageView{asio::buffer(data)};
+            ADD_FAILURE() << "expected an exception";
+        } catch (const std::exception& ex) {
+            EXPECT_EQ(ex.what(), reader::describe(asio::buffer(data), error));
+        }
+    }
+}
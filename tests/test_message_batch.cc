@@ -0,0 +1,268 @@
+#include "compat/asio.h"
+#include "message.h"
+#include "message_batch.h"
+#include "serializer.h"
+#include "test/isa.h"
+#include "wire.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using schema = reader::wire::message_schema;
+
+auto append_frame(std::vector<unsigned char>& frames, const reader::wire::message_fields& fields)
+    -> void {
+    const auto end = frames.size();
+    frames.resize(end + schema::length::size + reader::wire::payload_size(fields));
+    reader::wire::encode_frame(fields, frames.data() + end);
+}
+
+/// Frames with every combination of optional fields and names of varying size
+auto make_frames(std::size_t count) -> std::vector<unsigned char> {
+    auto rng = std::mt19937{count};
+    auto frames = std::vector<unsigned char>{};
+    auto names = std::vector<std::string>{};
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        names.push_back(std::string(i % 20, static_cast<char>('a' + i % 26)));
+    }
+
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        auto fields = reader::wire::message_fields{};
+        fields.timestamp = 1'600'000'000'000 + i;
+        fields.name = names[i];
+        if (i % 2 == 0) {
+            fields.temperature = static_cast<std::uint32_t>(rng()) & schema::temperature::max;
+        }
+        if (i % 3 != 0) {
+            fields.humidity = static_cast<std::uint16_t>(rng());
+        }
+        append_frame(frames, fields);
+    }
+    return frames;
+}
+
+/// Decodes each frame with MessageView
+auto decode_views(const std::vector<unsigned char>& frames) -> std::vector<reader::MessageView> {
+    auto views = std::vector<reader::MessageView>{};
+    auto data = asio::buffer(frames);
+    while (data.size() > 0) {
+        const auto header = asio::buffer(data, schema::length::size);
+        const auto length = reader::decode_message_length(header);
+        views.emplace_back(
+            asio::buffer(data + schema::length::size, length - schema::length::size));
+        data += length;
+    }
+    return views;
+}
+
+auto bits(float f) -> std::uint32_t {
+    auto b = std::uint32_t{};
+    std::memcpy(&b, &f, sizeof(b));
+    return b;
+}
+
+} // namespace
+
+TEST(MessageBatch, MatchesMessageView) {
+    const auto frames = make_frames(200);
+    const auto views = decode_views(frames);
+
+    for (const auto isa : test::supported_isas()) {
+        auto batch = reader::MessageBatch{isa};
+        ASSERT_EQ(frames.size(), batch.decode(asio::buffer(frames)));
+        ASSERT_EQ(views.size(), batch.size());
+
+        for (auto i = std::size_t{0}; i < views.size(); ++i) {
+            const auto row = batch[i];
+            EXPECT_EQ(views[i].timestamp(), row.timestamp()) << i;
+            EXPECT_EQ(views[i].name(), row.name()) << i;
+            EXPECT_EQ(views[i].temperature(), row.temperature()) << i;
+            EXPECT_EQ(views[i].humidity(), row.humidity()) << i;
+            EXPECT_EQ(views[i].temperature().has_value(), batch.has_temperature(i)) << i;
+            EXPECT_EQ(views[i].humidity().has_value(), batch.has_humidity(i)) << i;
+        }
+    }
+}
+
+TEST(MessageBatch, NamesReferToFrames) {
+    auto frames = std::vector<unsigned char>{};
+    append_frame(frames, {0, "abc", std::nullopt, std::nullopt});
+
+    auto batch = reader::MessageBatch{};
+    batch.decode(asio::buffer(frames));
+
+    ASSERT_EQ(1, batch.size());
+    EXPECT_EQ(reinterpret_cast<const char*>(frames.data()) + schema::length::size +
+                  schema::name_data_offset,
+              batch[0].name().data());
+}
+
+TEST(MessageBatch, StopsAtInvalidFrame) {
+    auto frames = std::vector<unsigned char>{};
+    append_frame(frames, {1, "abc", 27315, std::nullopt});
+    const auto valid_size = frames.size();
+    append_frame(frames, {2, "\xC0\x80", std::nullopt, std::nullopt});
+    append_frame(frames, {3, "def", std::nullopt, 500});
+
+    auto batch = reader::MessageBatch{};
+    EXPECT_EQ(valid_size, batch.decode(asio::buffer(frames)));
+    ASSERT_EQ(1, batch.size());
+    EXPECT_EQ(0.0f, batch[0].temperature());
+
+    // The invalid frame is described by `try_decode_view`
+    const auto payload = asio::buffer(asio::buffer(frames) + valid_size + schema::length::size,
+                                      schema::name_data_offset + 2);
+    EXPECT_EQ(reader::decode_error::invalid_name, reader::try_decode_view(payload).error());
+}
+
+TEST(MessageBatch, StopsAtBadLayout) {
+    auto frames = std::vector<unsigned char>{};
+    append_frame(frames, {1, "abc", std::nullopt, std::nullopt});
+
+    // A single byte after the name does not match any combination of fields
+    const auto valid_size = frames.size();
+    append_frame(frames, {2, "abcd", std::nullopt, std::nullopt});
+    frames[valid_size + schema::length::size + schema::name_offset] = 3;
+
+    auto batch = reader::MessageBatch{};
+    EXPECT_EQ(valid_size, batch.decode(asio::buffer(frames)));
+    EXPECT_EQ(1, batch.size());
+}
+
+TEST(MessageBatch, StopsAtIncompleteFrame) {
+    auto frames = std::vector<unsigned char>{};
+    append_frame(frames, {1, "abc", std::nullopt, std::nullopt});
+    const auto valid_size = frames.size();
+    append_frame(frames, {2, "abc", std::nullopt, std::nullopt});
+
+    auto batch = reader::MessageBatch{};
+    for (auto size = valid_size; size < frames.size(); ++size) {
+        EXPECT_EQ(valid_size, batch.decode(asio::buffer(frames.data(), size))) << size;
+        EXPECT_EQ(1, batch.size());
+    }
+    EXPECT_EQ(0, batch.decode(asio::buffer(frames.data(), valid_size - 1)));
+    EXPECT_TRUE(batch.empty());
+}
+
+TEST(MessageBatch, DecodeReplacesMessages) {
+    const auto many = make_frames(100);
+    const auto few = make_frames(3);
+
+    auto batch = reader::MessageBatch{};
+    batch.decode(asio::buffer(many));
+    batch.decode(asio::buffer(few));
+
+    const auto views = decode_views(few);
+    ASSERT_EQ(3, batch.size());
+    for (auto i = std::size_t{0}; i < views.size(); ++i) {
+        EXPECT_EQ(views[i].name(), batch[i].name());
+        EXPECT_EQ(views[i].temperature(), batch[i].temperature());
+        EXPECT_EQ(views[i].humidity(), batch[i].humidity());
+    }
+}
+
+TEST(MessageBatch, SerializesLikeMessageView) {
+    const auto frames = make_frames(10);
+    const auto views = decode_views(frames);
+
+    auto batch = reader::MessageBatch{};
+    batch.decode(asio::buffer(frames));
+
+    for (auto i = std::size_t{0}; i < views.size(); ++i) {
+        for (const auto format : {reader::json_format::compact, reader::json_format::pretty}) {
+            auto expected = std::string{};
+            auto actual = std::string{};
+            reader::write_json(expected, views[i], format);
+            reader::write_json(actual, batch[i], format);
+            EXPECT_EQ(expected, actual);
+
+            expected.clear();
+            actual.clear();
+            reader::write_json(expected, views[i], 7, format);
+            reader::write_json(actual, batch[i], 7, format);
+            EXPECT_EQ(expected, actual);
+        }
+    }
+}
+
+TEST(Conversion, EveryTemperature) {
+    // Converted in blocks, with a size which leaves a remainder for the scalar implementation
+    constexpr auto block = std::size_t{4099};
+
+    auto packed = std::vector<unsigned char>(3 * block);
+    auto expected = std::vector<float>(block);
+    auto actual = std::vector<float>(block);
+
+    for (auto first = std::uint32_t{0}; first <= schema::temperature::max; first += block) {
+        const auto count = std::min<std::size_t>(block, schema::temperature::max + 1 - first);
+        for (auto i = std::size_t{0}; i < count; ++i) {
+            schema::temperature::write(static_cast<std::uint32_t>(first + i), &packed[3 * i]);
+        }
+
+        reader::convert_temperatures(
+            packed.data(), count, expected.data(), reader::simd_isa::scalar);
+        for (const auto isa : test::supported_isas()) {
+            reader::convert_temperatures(packed.data(), count, actual.data(), isa);
+            for (auto i = std::size_t{0}; i < count; ++i) {
+                ASSERT_EQ(bits(expected[i]), bits(actual[i]))
+                    << "isa " << static_cast<int>(isa) << ", value " << first + i;
+            }
+        }
+    }
+}
+
+TEST(Conversion, EveryHumidity) {
+    constexpr auto count = std::size_t{schema::humidity::max} + 1;
+
+    auto packed = std::vector<unsigned char>(2 * count);
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        schema::humidity::write(static_cast<std::uint16_t>(i), &packed[2 * i]);
+    }
+
+    auto expected = std::vector<float>(count);
+    reader::convert_humidities(packed.data(), count, expected.data(), reader::simd_isa::scalar);
+
+    for (const auto isa : test::supported_isas()) {
+        auto actual = std::vector<float>(count);
+        reader::convert_humidities(packed.data(), count, actual.data(), isa);
+        for (auto i = std::size_t{0}; i < count; ++i) {
+            ASSERT_EQ(bits(expected[i]), bits(actual[i]))
+                << "isa " << static_cast<int>(isa) << ", value " << i;
+        }
+    }
+}
+
+TEST(Conversion, ScalarMatchesMessageView) {
+    auto payload = std::vector<unsigned char>{};
+    const auto view_of = [&payload](std::uint32_t temperature, std::uint16_t humidity) {
+        const auto fields = reader::wire::message_fields{0, "", temperature, humidity};
+        payload.resize(reader::wire::payload_size(fields));
+        reader::wire::encode(fields, payload.data());
+        return reader::MessageView{asio::buffer(payload)};
+    };
+
+    for (auto value = std::uint32_t{0}; value <= schema::temperature::max; value += 997) {
+        unsigned char packed[3];
+        schema::temperature::write(value, packed);
+        auto converted = 0.0f;
+        reader::convert_temperatures(packed, 1, &converted, reader::simd_isa::scalar);
+        ASSERT_EQ(view_of(value, 0).temperature(), converted) << value;
+    }
+
+    for (auto value = std::uint32_t{0}; value <= schema::humidity::max; ++value) {
+        unsigned char packed[2];
+        schema::humidity::write(static_cast<std::uint16_t>(value), packed);
+        auto converted = 0.0f;
+        reader::convert_humidities(packed, 1, &converted, reader::simd_isa::scalar);
+        ASSERT_EQ(view_of(0, static_cast<std::uint16_t>(value)).humidity(), converted) << value;
+    }
+}
@@ -0,0 +1,145 @@
+#include "metrics.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+TEST(Histogram, Empty) {
+    const auto histogram = logger::Histogram{};
+
+    EXPECT_EQ(0, histogram.count());
+    EXPECT_EQ(0, histogram.max());
+    EXPECT_EQ(0, histogram.percentile(0.5));
+}
+
+TEST(Histogram, SmallValuesAreExact) {
+    auto histogram = logger::Histogram{};
+    for (auto i = std::uint64_t{1}; i <= 10; ++i) {
+        histogram.record(i);
+    }
+
+    EXPECT_EQ(10, histogram.count());
+    EXPECT_EQ(10, histogram.max());
+    EXPECT_EQ(1, histogram.percentile(0.0));
+    EXPECT_EQ(5, histogram.percentile(0.5));
+    EXPECT_EQ(9, histogram.percentile(0.9));
+    EXPECT_EQ(10, histogram.percentile(1.0));
+}
+
+TEST(Histogram, LargeValuesAreWithinRelativeError) {
+    auto histogram = logger::Histogram{};
+    for (auto i = std::uint64_t{1}; i <= 1000; ++i) {
+        histogram.record(i * 1000);
+    }
+
+    // Percentiles are reported as the largest value in their bucket
+    const auto p50 = histogram.percentile(0.5);
+    EXPECT_LE(500'000, p50);
+    EXPECT_GE(500'000 + 500'000 / logger::Histogram::sub_buckets, p50);
+
+    const auto p99 = histogram.percentile(0.99);
+    EXPECT_LE(990'000, p99);
+    EXPECT_GE(990'000 + 990'000 / logger::Histogram::sub_buckets, p99);
+    EXPECT_EQ(1'000'000, histogram.percentile(1.0));
+}
+
+TEST(Histogram, LargestValue) {
+    auto histogram = logger::Histogram{};
+    histogram.record(UINT64_MAX);
+
+    EXPECT_EQ(UINT64_MAX, histogram.max());
+    EXPECT_EQ(UINT64_MAX, histogram.percentile(0.5));
+}
+
+TEST(Histogram, RecordsDurationsInNanoseconds) {
+    auto histogram = logger::Histogram{};
+    histogram.record(std::chrono::microseconds{3});
+    histogram.record(std::chrono::milliseconds{-1});
+
+    EXPECT_EQ(2, histogram.count());
+    EXPECT_EQ(3000, histogram.max());
+    EXPECT_EQ(0, histogram.percentile(0.5));
+}
+
+TEST(Histogram, RecordsValueRepeatedly) {
+    auto histogram = logger::Histogram{};
+    histogram.record(5, 3);
+    histogram.record(1000);
+
+    EXPECT_EQ(4, histogram.count());
+    EXPECT_EQ(5, histogram.percentile(0.75));
+    EXPECT_EQ(1000, histogram.max());
+}
+
+TEST(Histogram, Merge) {
+    auto a = logger::Histogram{};
+    auto b = logger::Histogram{};
+    a.record(1);
+    b.record(3, 2);
+    b.record(2000);
+    a.merge(b);
+
+    EXPECT_EQ(4, a.count());
+    EXPECT_EQ(3, a.percentile(0.75));
+    EXPECT_EQ(2000, a.max());
+}
+
+TEST(Metrics, ClosedConnectionsAreAddedToTotals) {
+    auto metrics = logger::Metrics{};
+
+    auto a = metrics.open("a:1");
+    auto b = metrics.open("b:2");
+    logger::increment(a->messages, 2);
+    logger::increment(b->messages, 3);
+    logger::increment(b->bytes, 100);
+    logger::increment(b->decode_errors);
+    logger::increment(a->filtered);
+    logger::increment(b->filtered, 2);
+    b.reset();
+
+    auto report = std::stringstream{};
+    metrics.report(report);
+
+    const auto report_str = report.str();
+    EXPECT_NE(std::string::npos, report_str.find("connections_open 1\n"));
+    EXPECT_NE(std::string::npos, report_str.find("connections_closed 1\n"));
+    EXPECT_NE(std::string::npos, report_str.find("messages 5\n"));
+    EXPECT_NE(std::string::npos, report_str.find("bytes 100\n"));
+    EXPECT_NE(std::string::npos, report_str.find("decode_errors 1\n"));
+    EXPECT_NE(std::string::npos, report_str.find("filtered 3\n"));
+    EXPECT_NE(std::string::npos, report_str.find("connection a:1 messages=2 bytes=0"));
+    EXPECT_NE(std::string::npos, report_str.find(" filtered=1 "));
+    EXPECT_EQ(std::string::npos, report_str.find("connection b:2"));
+}
+
+TEST(Metrics, MergesLatenciesOfAllConnections) {
+    auto metrics = logger::Metrics{};
+
+    auto a = metrics.open("a:1");
+    auto b = metrics.open("b:2");
+    a->latencies.decode_latency.record(10, 2);
+    b->latencies.decode_latency.record(20);
+    b->latencies.lag.record(30);
+    b.reset();
+
+    const auto latencies = metrics.latencies();
+    EXPECT_EQ(3, latencies->decode_latency.count());
+    EXPECT_EQ(20, latencies->decode_latency.max());
+    EXPECT_EQ(1, latencies->lag.count());
+
+    auto report = std::stringstream{};
+    metrics.report(report);
+    EXPECT_NE(std::string::npos, report.str().find("decode_ns count=3 "));
+}
+
+TEST(Metrics, ReportsGauges) {
+    auto metrics = logger::Metrics{};
+    metrics.gauge("queue_bytes", []() { return std::uint64_t{42}; });
+
+    auto report = std::stringstream{};
+    metrics.report(report);
+
+    EXPECT_NE(std::string::npos, report.str().find("queue_bytes 42\n"));
+}
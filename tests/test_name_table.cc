@@ -0,0 +1,134 @@
+#include "name_table.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Records the definitions made while interning names
+struct definitions {
+    auto operator()(logger::name_id id, std::string_view name) -> void {
+        const auto lock = std::lock_guard<std::mutex>{mutex};
+        defined.emplace_back(id, std::string{name});
+    }
+
+    std::mutex mutex;
+    std::vector<std::pair<logger::name_id, std::string>> defined;
+};
+
+} // namespace
+
+TEST(NameTable, AssignsIdsInOrder) {
+    auto table = logger::NameTable{16};
+    auto defs = definitions{};
+
+    EXPECT_EQ(0, table.intern("abc", std::ref(defs))->id);
+    EXPECT_EQ(1, table.intern("def", std::ref(defs))->id);
+    EXPECT_EQ(0, table.intern("abc", std::ref(defs))->id);
+
+    EXPECT_EQ(2, table.size());
+    EXPECT_EQ((std::vector<std::pair<logger::name_id, std::string>>{{0, "abc"}, {1, "def"}}),
+              defs.defined);
+}
+
+TEST(NameTable, FindDoesNotIntern) {
+    auto table = logger::NameTable{16};
+
+    EXPECT_EQ(std::nullopt, table.find("abc"));
+    EXPECT_EQ(0, table.size());
+
+    table.intern("abc", [](logger::name_id, std::string_view) {});
+    ASSERT_NE(std::nullopt, table.find("abc"));
+    EXPECT_EQ(0, table.find("abc")->id);
+}
+
+TEST(NameTable, InternedNameIsOwnedByTable) {
+    auto table = logger::NameTable{16};
+
+    auto name = std::string{"e74bb50f-5a1e-4742-8827-20bc80a17297"};
+    const auto interned = table.intern(name, [](logger::name_id, std::string_view) {});
+    name.assign(name.size(), 'x');
+
+    EXPECT_EQ("e74bb50f-5a1e-4742-8827-20bc80a17297", interned->name);
+    EXPECT_EQ(interned->name.data(), table.find(interned->name)->name.data());
+}
+
+TEST(NameTable, ListsNamesById) {
+    auto table = logger::NameTable{16};
+    EXPECT_TRUE(table.names().empty());
+
+    for (const auto* name : {"ghi", "abc", "def", "abc"}) {
+        table.intern(name, [](logger::name_id, std::string_view) {});
+    }
+
+    auto listed = std::vector<std::pair<logger::name_id, std::string>>{};
+    for (const auto& interned : table.names()) {
+        listed.emplace_back(interned.id, std::string{interned.name});
+    }
+    EXPECT_EQ((std::vector<std::pair<logger::name_id, std::string>>{
+                  {0, "ghi"}, {1, "abc"}, {2, "def"}}),
+              listed);
+}
+
+TEST(NameTable, FullTableDoesNotAssignIds) {
+    auto table = logger::NameTable{1};
+    auto defs = definitions{};
+
+    EXPECT_NE(std::nullopt, table.intern("abc", std::ref(defs)));
+    EXPECT_EQ(std::nullopt, table.intern("def", std::ref(defs)));
+    EXPECT_NE(std::nullopt, table.intern("abc", std::ref(defs)));
+
+    EXPECT_EQ(1, table.size());
+    EXPECT_EQ(1, defs.defined.size());
+}
+
+TEST(NameTable, ConcurrentInternDefinesEachNameOnce) {
+    constexpr auto thread_count = 4;
+    constexpr auto name_count = 1000;
+
+    auto table = logger::NameTable{name_count};
+    auto defs = definitions{};
+
+    // Each thread interns all names, starting at a different offset
+    auto ids = std::vector<std::vector<logger::name_id>>(thread_count);
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            auto& thread_ids = ids[static_cast<std::size_t>(t)];
+            thread_ids.resize(name_count);
+            for (auto i = 0; i < name_count; ++i) {
+                const auto n = (i + t * name_count / thread_count) % name_count;
+                thread_ids[static_cast<std::size_t>(n)] =
+                    table.intern("sensor-" + std::to_string(n), std::ref(defs))->id;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(name_count, table.size());
+    ASSERT_EQ(name_count, defs.defined.size());
+
+    // Every thread agrees on the IDs, which are defined once each
+    auto defined = std::map<logger::name_id, std::string>{};
+    for (const auto& [id, name] : defs.defined) {
+        EXPECT_TRUE(defined.emplace(id, name).second);
+    }
+    for (auto n = 0; n < name_count; ++n) {
+        const auto id = ids[0][static_cast<std::size_t>(n)];
+        EXPECT_EQ("sensor-" + std::to_string(n), defined[id]);
+        for (const auto& thread_ids : ids) {
+            EXPECT_EQ(id, thread_ids[static_cast<std::size_t>(n)]);
+        }
+    }
+    EXPECT_EQ(name_count - 1, defined.rbegin()->first);
+}
@@ -0,0 +1,98 @@
+#include "compat/asio.h"
+#include "handler_allocator.h"
+#include "pool.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct object {
+    std::array<char, 40> data;
+};
+
+} // namespace
+
+TEST(BlockPool, ReusesReleasedBlocks) {
+    using pool = logger::block_pool<40, 8>;
+
+    const auto first = pool::allocate();
+    pool::deallocate(first);
+
+    EXPECT_EQ(first, pool::allocate());
+    pool::deallocate(first);
+}
+
+TEST(BlockPool, GrowsBeyondASlab) {
+    using pool = logger::block_pool<24, 8>;
+
+    auto blocks = std::vector<void*>{};
+    for (auto i = std::size_t{}; i < 2 * pool::slab_blocks + 1; ++i) {
+        blocks.push_back(pool::allocate());
+        EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(blocks.back()) % 8);
+    }
+
+    auto sorted = blocks;
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(sorted.end(), std::adjacent_find(sorted.begin(), sorted.end()));
+
+    for (const auto block : blocks) {
+        pool::deallocate(block);
+    }
+}
+
+TEST(PoolAllocator, AllocateShared) {
+    auto first = std::allocate_shared<object>(logger::pool_allocator<object>{});
+    const auto address = first.get();
+    first.reset();
+
+    // The object and its control block are returned to the pool and reused
+    const auto second = std::allocate_shared<object>(logger::pool_allocator<object>{});
+    EXPECT_EQ(address, second.get());
+}
+
+TEST(HandlerMemory, ReusesStorage) {
+    auto memory = logger::handler_memory{};
+
+    const auto first = memory.allocate(64);
+    memory.deallocate(first);
+
+    const auto second = memory.allocate(64);
+    EXPECT_EQ(first, second);
+    memory.deallocate(second);
+}
+
+TEST(HandlerMemory, FallsBackToHeap) {
+    auto memory = logger::handler_memory{};
+
+    const auto inline_storage = memory.allocate(64);
+
+    // The storage is in use
+    const auto in_use = memory.allocate(64);
+    EXPECT_NE(inline_storage, in_use);
+    memory.deallocate(in_use);
+
+    // The storage is too small
+    const auto large = memory.allocate(4096);
+    EXPECT_NE(inline_storage, large);
+    memory.deallocate(large);
+
+    memory.deallocate(inline_storage);
+}
+
+TEST(HandlerAllocator, AssociatedWithWrappedHandler) {
+    auto memory = logger::handler_memory{};
+    auto called = false;
+
+    auto handler = logger::make_custom_alloc_handler(memory, [&called]() { called = true; });
+
+    using allocator_type = logger::handler_allocator<int>;
+    EXPECT_EQ(allocator_type{memory}, allocator_type{asio::get_associated_allocator(handler)});
+
+    handler();
+    EXPECT_TRUE(called);
+}
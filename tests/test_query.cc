@@ -0,0 +1,170 @@
+#include "compat/asio.h"
+#include "index.h"
+#include "message.h"
+#include "query.h"
+#include "serializer.h"
+#include "test/encode.h"
+#include "wire.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using time_point_t = logger::record_info::time_point_t;
+
+auto at(std::int64_t ms) -> time_point_t {
+    return time_point_t{std::chrono::milliseconds{ms}};
+}
+
+/// Writes a log and its index in compact format, as `logger --dictionary --index` does
+class LogBuilder {
+  public:
+    /// @brief Writes the definition of a name
+    auto define(std::uint32_t id, std::string_view name) -> void {
+        auto record = std::string{};
+        reader::write_name_definition(record, id, name, reader::json_format::compact);
+        append(record, {name, std::nullopt});
+    }
+
+    /// @brief Writes a message referring to its name by ID
+    /// @return The record
+    auto message(std::uint32_t id, std::string_view name, std::uint64_t timestamp)
+        -> std::string {
+        const auto fields = reader::wire::message_fields{timestamp, name, 29815, 455};
+        const auto payload = test::encode(fields);
+        const auto view = reader::try_decode_view(asio::buffer(payload));
+
+        auto record = std::string{};
+        reader::write_json(record, *view, id, reader::json_format::compact);
+        append(record, {name, view->timestamp()});
+        return record;
+    }
+
+    auto log() const -> const std::string& { return log_; }
+
+    auto index() -> logger::Index {
+        builder_.finish(log_.size());
+        auto encoded = std::string{};
+        builder_.take(encoded);
+        return logger::Index{encoded};
+    }
+
+  private:
+    auto append(const std::string& record, const logger::record_info& info) -> void {
+        builder_.add(log_.size(), info);
+        log_.append(record).push_back('\n');
+    }
+
+    std::string log_;
+
+    /// Small blocks, so that records of different times are in different blocks
+    logger::IndexBuilder builder_{128};
+};
+
+/// Lines of a query result
+auto lines(const std::string& out) -> std::vector<std::string> {
+    auto stream = std::istringstream{out};
+    auto result = std::vector<std::string>{};
+    for (auto line = std::string{}; std::getline(stream, line);) {
+        result.push_back(line);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(Query, ResolvesDictionaryNamesOutsideTimeRange) {
+    auto builder = LogBuilder{};
+    builder.define(0, "kitchen");
+    for (auto i = 0; i < 4; ++i) {
+        builder.message(0, "kitchen", 1000);
+    }
+    builder.define(1, "garage");
+    for (auto i = 0; i < 4; ++i) {
+        builder.message(1, "garage", 2000);
+    }
+    const auto late = builder.message(0, "kitchen", 3000);
+
+    const auto& log = builder.log();
+    const auto index = builder.index();
+    ASSERT_GT(index.blocks().size(), 3);
+
+    auto options = logger::query_options{};
+    options.name = "kitchen";
+    options.from = at(2500);
+
+    auto out = std::ostringstream{};
+    auto err = std::ostringstream{};
+    logger::Query{log, index, options, out, err}.run();
+
+    const auto result = lines(out.str());
+    ASSERT_EQ(2, result.size());
+    EXPECT_EQ(R"({"id":0,"name":"kitchen"})", result[0]);
+    EXPECT_EQ(late, result[1]);
+
+    // Only the block defining the name and the block of the matching record are scanned
+    EXPECT_EQ(0, err.str().find("Scanned 2 of "));
+}
+
+TEST(Query, SelectsByTimeWithoutName) {
+    auto builder = LogBuilder{};
+    builder.define(0, "kitchen");
+    for (auto i = 0; i < 4; ++i) {
+        builder.message(0, "kitchen", 1000);
+    }
+    builder.define(1, "garage");
+    for (auto i = 0; i < 4; ++i) {
+        builder.message(1, "garage", 2000);
+    }
+    const auto late = builder.message(0, "kitchen", 3000);
+
+    const auto& log = builder.log();
+    const auto index = builder.index();
+    ASSERT_GT(index.blocks().size(), 3);
+
+    auto options = logger::query_options{};
+    options.from = at(2500);
+    options.to = at(3500);
+
+    auto out = std::ostringstream{};
+    auto err = std::ostringstream{};
+    logger::Query{log, index, options, out, err}.run();
+
+    // The definition of the name of the record is found, but not of other names
+    const auto result = lines(out.str());
+    ASSERT_EQ(2, result.size());
+    EXPECT_EQ(R"({"id":0,"name":"kitchen"})", result[0]);
+    EXPECT_EQ(late, result[1]);
+}
+
+TEST(Query, SkipsMalformedRecords) {
+    const auto log = std::string{R"({"id":"0","name":"kitchen"})"
+                                 "\n"
+                                 R"({"id":0,"name":7})"
+                                 "\n"
+                                 R"({"name_id":-1,"timestamp":"2020-06-28T16:51:50.000+0200"})"
+                                 "\n"
+                                 R"({"name":["kitchen"],"timestamp":5})"
+                                 "\n"};
+    auto builder = logger::IndexBuilder{};
+    builder.add(0, {"kitchen", std::nullopt});
+    builder.finish(log.size());
+    auto encoded = std::string{};
+    builder.take(encoded);
+    const auto index = logger::Index{encoded};
+
+    auto options = logger::query_options{};
+    options.name = "kitchen";
+
+    auto out = std::ostringstream{};
+    auto err = std::ostringstream{};
+    logger::Query{log, index, options, out, err}.run();
+
+    EXPECT_TRUE(out.str().empty());
+}
@@ -0,0 +1,166 @@
+#include "record_ring.h"
+
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using chunks = std::vector<logger::RecordRing::chunk>;
+
+auto options(std::size_t chunk_size, std::size_t capacity) -> logger::record_ring_options {
+    auto opts = logger::record_ring_options{};
+    opts.chunk_size = chunk_size;
+    opts.capacity = capacity;
+    return opts;
+}
+
+/// Concatenates the records of chunks
+auto join(const chunks& read) -> std::string {
+    auto records = std::string{};
+    for (const auto& c : read) {
+        records += *c;
+    }
+    return records;
+}
+
+auto no_wait() -> logger::RecordRing::waiter {
+    return []() { FAIL() << "unexpected wait"; };
+}
+
+} // namespace
+
+TEST(RecordRing, BatchesRecordsIntoChunks) {
+    auto ring = logger::RecordRing{options(8, 16)};
+    auto cursor = ring.end();
+
+    ring.publish("abc");
+    ring.publish("def");
+    ring.publish("g");
+
+    auto read = chunks{};
+    EXPECT_EQ(0, ring.read(cursor, read, 16, no_wait()));
+    ASSERT_EQ(2, read.size());
+    EXPECT_EQ("abc\ndef\n", *read[0]);
+    EXPECT_EQ("g\n", *read[1]);
+    EXPECT_EQ(2, cursor);
+}
+
+TEST(RecordRing, ReadersShareChunks) {
+    auto ring = logger::RecordRing{options(8, 16)};
+    auto first = ring.end();
+    auto second = ring.end();
+
+    ring.publish("abcdefgh");
+
+    auto a = chunks{};
+    auto b = chunks{};
+    ring.read(first, a, 16, no_wait());
+    ring.read(second, b, 16, no_wait());
+    ASSERT_EQ(1, a.size());
+    ASSERT_EQ(1, b.size());
+    EXPECT_EQ(a[0].get(), b[0].get());
+}
+
+TEST(RecordRing, NewReadersOnlyReadLaterRecords) {
+    auto ring = logger::RecordRing{options(1024, 16)};
+
+    ring.publish("before");
+    auto cursor = ring.end();
+    ring.publish("after");
+
+    auto read = chunks{};
+    ring.read(cursor, read, 16, no_wait());
+    EXPECT_EQ("after\n", join(read));
+}
+
+TEST(RecordRing, WakesWaitingReaders) {
+    auto ring = logger::RecordRing{options(1024, 16)};
+    auto cursor = ring.end();
+
+    auto woken = 0;
+    auto read = chunks{};
+    ring.read(cursor, read, 16, [&woken]() { ++woken; });
+    EXPECT_TRUE(read.empty());
+
+    // The chunk is sealed at once, as a reader is waiting
+    ring.publish("abc");
+    EXPECT_EQ(1, woken);
+    ring.publish("def");
+    EXPECT_EQ(1, woken);
+
+    ring.read(cursor, read, 16, no_wait());
+    EXPECT_EQ("abc\ndef\n", join(read));
+}
+
+TEST(RecordRing, LimitsChunksRead) {
+    auto ring = logger::RecordRing{options(1, 16)};
+    auto cursor = ring.end();
+
+    for (const auto record : {"a", "b", "c"}) {
+        ring.publish(record);
+    }
+
+    auto read = chunks{};
+    ring.read(cursor, read, 2, no_wait());
+    EXPECT_EQ("a\nb\n", join(read));
+    ring.read(cursor, read, 2, no_wait());
+    EXPECT_EQ("a\nb\nc\n", join(read));
+}
+
+TEST(RecordRing, SlowReadersSkipAhead) {
+    auto ring = logger::RecordRing{options(1, 2)};
+    auto cursor = ring.end();
+
+    for (const auto record : {"a", "b", "c", "d", "e"}) {
+        ring.publish(record);
+    }
+
+    auto read = chunks{};
+    EXPECT_EQ(3, ring.read(cursor, read, 16, no_wait()));
+    EXPECT_EQ("d\ne\n", join(read));
+    EXPECT_EQ(3, ring.skipped());
+}
+
+TEST(RecordRing, SkipsChunkDroppedBySealingOpenChunk) {
+    auto ring = logger::RecordRing{options(1024, 1)};
+    auto cursor = ring.end();
+
+    // Sealed by a new reader, filling the ring
+    ring.publish("a");
+    ring.end();
+
+    // Sealed by the read, dropping the chunk at the cursor
+    ring.publish("b");
+
+    auto read = chunks{};
+    EXPECT_EQ(1, ring.read(cursor, read, 16, no_wait()));
+    EXPECT_EQ("b\n", join(read));
+    EXPECT_EQ(2, cursor);
+    EXPECT_EQ(1, ring.skipped());
+}
+
+TEST(RecordRing, PublishesConcurrently) {
+    auto ring = logger::RecordRing{options(64, 1 << 16)};
+    auto cursor = ring.end();
+
+    constexpr auto records = 1000;
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&ring]() {
+            for (auto j = 0; j < records; ++j) {
+                ring.publish("record");
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto read = chunks{};
+    ring.read(cursor, read, 1 << 16, no_wait());
+    EXPECT_EQ(4 * records * std::string{"record\n"}.size(), join(read).size());
+}
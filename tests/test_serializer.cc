@@ -0,0 +1,127 @@
+#include "compat/asio.h"
+#include "message.h"
+#include "serializer.h"
+#include "test/encode.h"
+#include "wire.h"
+
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+auto serialize(const reader::MessageView& message, reader::json_format format) {
+    auto out = std::string{};
+    reader::write_json(out, message, format);
+    return out;
+}
+
+} // namespace
+
+TEST(Serializer, Pretty) {
+    const auto data =
+        test::encode({1593355910240, "e74bb50f-5a1e-4742-8827-20bc80a17297", 343428, 808});
+    const auto message = reader::MessageView{asio::buffer(data)};
+
+    EXPECT_EQ(message.as_json().dump(4), serialize(message, reader::json_format::pretty));
+}
+
+TEST(Serializer, Compact) {
+    const auto data =
+        test::encode({1593355910240, "e74bb50f-5a1e-4742-8827-20bc80a17297", 343428, 808});
+    const auto message = reader::MessageView{asio::buffer(data)};
+
+    EXPECT_EQ(message.as_json().dump(), serialize(message, reader::json_format::compact));
+}
+
+TEST(Serializer, OptionalFields) {
+    const auto name_only = test::encode({0, "abc", std::nullopt, std::nullopt});
+    const auto temperature_only = test::encode({0, "abc", 27315, std::nullopt});
+    const auto humidity_only = test::encode({0, "abc", std::nullopt, 10});
+
+    for (const auto& data : {name_only, temperature_only, humidity_only}) {
+        const auto message = reader::MessageView{asio::buffer(data)};
+
+        EXPECT_EQ(message.as_json().dump(4), serialize(message, reader::json_format::pretty));
+        EXPECT_EQ(message.as_json().dump(), serialize(message, reader::json_format::compact));
+    }
+}
+
+TEST(Serializer, EscapedName) {
+    const auto data = test::encode({0, "héllö \"\\\b\f\n\r\t\x01\x1f\x7f", std::nullopt, 10});
+    const auto message = reader::MessageView{asio::buffer(data)};
+
+    EXPECT_EQ(message.as_json().dump(4), serialize(message, reader::json_format::pretty));
+}
+
+TEST(Serializer, MessageAndViewAreEqual) {
+    const auto data = test::encode({1593355910240, "abc", 343428, 808});
+    const auto view = reader::MessageView{asio::buffer(data)};
+    const auto message = reader::Message{view};
+
+    auto out = std::string{};
+    reader::write_json(out, message, reader::json_format::pretty);
+
+    EXPECT_EQ(serialize(view, reader::json_format::pretty), out);
+}
+
+TEST(Serializer, AppendsToBuffer) {
+    const auto data = test::encode({0, "abc", std::nullopt, std::nullopt});
+    const auto message = reader::MessageView{asio::buffer(data)};
+
+    auto out = std::string{"prefix"};
+    reader::write_json(out, message, reader::json_format::compact);
+
+    EXPECT_EQ("prefix" + message.as_json().dump(), out);
+}
+
+TEST(Serializer, RandomValues) {
+    auto gen = std::mt19937{0};
+    auto temperature = std::uniform_int_distribution<uint32_t>{0, 0xFFFFFF};
+    auto humidity = std::uniform_int_distribution<uint16_t>{};
+
+    for (auto i = 0; i < 10000; ++i) {
+        const auto data = test::encode({1593355910240 + static_cast<uint64_t>(i) * 997,
+                                        "sensor",
+                                        temperature(gen),
+                                        humidity(gen)});
+        const auto message = reader::MessageView{asio::buffer(data)};
+
+        ASSERT_EQ(message.as_json().dump(4), serialize(message, reader::json_format::pretty));
+    }
+}
+
+TEST(Serializer, NameId) {
+    const auto data =
+        test::encode({1593355910240, "e74bb50f-5a1e-4742-8827-20bc80a17297", 343428, 808});
+    const auto message = reader::MessageView{asio::buffer(data)};
+
+    for (const auto id : {0u, 7u, 4294967295u}) {
+        auto json = message.as_json();
+        json.erase("name");
+        json["name_id"] = id;
+
+        for (const auto format : {reader::json_format::compact, reader::json_format::pretty}) {
+            auto out = std::string{};
+            reader::write_json(out, message, id, format);
+
+            EXPECT_EQ(json.dump(format == reader::json_format::pretty ? 4 : -1), out);
+        }
+    }
+}
+
+TEST(Serializer, NameDefinition) {
+    const auto name = std::string{"héllö \"\\"};
+    const auto json = nlohmann::json{{"id", 42}, {"name", name}};
+
+    auto out = std::string{};
+    reader::write_name_definition(out, 42, name, reader::json_format::compact);
+    EXPECT_EQ(json.dump(), out);
+
+    out.clear();
+    reader::write_name_definition(out, 42, name, reader::json_format::pretty);
+    EXPECT_EQ(json.dump(4), out);
+}
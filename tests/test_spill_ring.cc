@@ -0,0 +1,76 @@
+#include "compat/asio.h"
+#include "spill_ring.h"
+
+#include "gtest/gtest.h"
+#include <string>
+#include <system_error>
+
+namespace {
+
+const auto spill_path = ::testing::TempDir() + "test_spill_ring.spill";
+
+/// Copies the data at the front of a ring
+auto front_string(const reader::SpillRing& ring, std::size_t max) -> std::string {
+    auto out = std::string{};
+    for (const auto& buffer : ring.front(max)) {
+        out.append(static_cast<const char*>(buffer.data()), buffer.size());
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(SpillRing, InitiallyEmpty) {
+    const auto ring = reader::SpillRing{spill_path, 16};
+
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(16, ring.capacity());
+    EXPECT_EQ("", front_string(ring, 16));
+}
+
+TEST(SpillRing, PushPop) {
+    auto ring = reader::SpillRing{spill_path, 16};
+
+    EXPECT_TRUE(ring.push(asio::buffer(std::string{"abcdef"})));
+    EXPECT_TRUE(ring.push(asio::buffer(std::string{"ghi"})));
+    EXPECT_EQ(9, ring.size());
+    EXPECT_EQ("abcdefghi", front_string(ring, 16));
+    EXPECT_EQ("abcd", front_string(ring, 4));
+
+    ring.pop(4);
+    EXPECT_EQ("efghi", front_string(ring, 16));
+
+    ring.pop(5);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpillRing, WrapsAround) {
+    auto ring = reader::SpillRing{spill_path, 8};
+
+    ASSERT_TRUE(ring.push(asio::buffer(std::string{"abcdef"})));
+    ring.pop(4);
+    ASSERT_TRUE(ring.push(asio::buffer(std::string{"ghijk"})));
+
+    const auto buffers = ring.front(8);
+    EXPECT_EQ(4, buffers[0].size());
+    EXPECT_EQ(3, buffers[1].size());
+    EXPECT_EQ("efghijk", front_string(ring, 8));
+
+    ring.pop(5);
+    EXPECT_EQ("jk", front_string(ring, 8));
+}
+
+TEST(SpillRing, RejectsDataWhenFull) {
+    auto ring = reader::SpillRing{spill_path, 8};
+
+    ASSERT_TRUE(ring.push(asio::buffer(std::string{"abcdef"})));
+    EXPECT_FALSE(ring.push(asio::buffer(std::string{"ghi"})));
+    EXPECT_EQ("abcdef", front_string(ring, 8));
+
+    EXPECT_TRUE(ring.push(asio::buffer(std::string{"gh"})));
+    EXPECT_EQ("abcdefgh", front_string(ring, 8));
+}
+
+TEST(SpillRing, InvalidPath) {
+    EXPECT_THROW((reader::SpillRing{"/nonexistent/test_spill_ring.spill", 8}), std::system_error);
+}
@@ -0,0 +1,138 @@
+#include "timestamp.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using time_point_t = std::chrono::system_clock::time_point;
+
+auto format(time_point_t timestamp) -> std::string {
+    char buffer[reader::max_timestamp_size];
+    const auto end = reader::format_timestamp(timestamp, buffer);
+    return {buffer, end};
+}
+
+/// Formats a timestamp with the standard library
+auto reference_format(time_point_t timestamp) -> std::string {
+    const auto time = std::chrono::system_clock::to_time_t(timestamp);
+    const auto localtime = std::localtime(&time);
+
+    const auto milliseconds =
+        std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()) % 1000;
+
+    auto ss = std::stringstream{};
+    ss << std::put_time(localtime, "%FT%T");
+    ss << '.' << std::setfill('0') << std::setw(3) << milliseconds.count();
+    ss << std::put_time(localtime, "%z");
+    return ss.str();
+}
+
+auto from_milliseconds(std::int64_t ms) -> time_point_t {
+    return time_point_t{std::chrono::milliseconds{ms}};
+}
+
+} // namespace
+
+TEST(Timestamp, Epoch) {
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    EXPECT_EQ("1970-01-01T00:00:00.000+0000", format(from_milliseconds(0)));
+    EXPECT_EQ("1970-01-01T00:00:00.123+0000", format(from_milliseconds(123)));
+    EXPECT_EQ("1970-01-01T00:00:01.000+0000", format(from_milliseconds(1000)));
+}
+
+TEST(Timestamp, SameSecond) {
+    const auto base = std::int64_t{1593355910000};
+
+    for (auto ms = 0; ms < 1000; ms += 7) {
+        const auto timestamp = from_milliseconds(base + ms);
+        EXPECT_EQ(reference_format(timestamp), format(timestamp));
+    }
+}
+
+TEST(Timestamp, MatchesStandardLibrary) {
+    auto gen = std::mt19937_64{0};
+    // 1970 up to 2100
+    auto dist = std::uniform_int_distribution<std::int64_t>{0, 4102444800000};
+
+    for (auto i = 0; i < 10000; ++i) {
+        const auto timestamp = from_milliseconds(dist(gen));
+        EXPECT_EQ(reference_format(timestamp), format(timestamp));
+    }
+}
+
+TEST(Timestamp, ConcurrentFormatting) {
+    auto threads = std::vector<std::thread>{};
+    auto results = std::vector<std::string>(4);
+
+    for (auto i = 0u; i < results.size(); ++i) {
+        threads.emplace_back([&result = results[i], i]() {
+            for (auto ms = 0; ms < 10000; ++ms) {
+                result = format(from_milliseconds(1593355910000 + i * 1000 + ms));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (auto i = 0u; i < results.size(); ++i) {
+        EXPECT_EQ(reference_format(from_milliseconds(1593355910000 + i * 1000 + 9999)),
+                  results[i]);
+    }
+}
+
+TEST(Timestamp, ParseRoundTripsFormat) {
+    auto gen = std::mt19937_64{1};
+    auto dist = std::uniform_int_distribution<std::int64_t>{0, 4102444800000};
+
+    for (auto i = 0; i < 10000; ++i) {
+        const auto timestamp = from_milliseconds(dist(gen));
+        EXPECT_EQ(timestamp, reader::parse_timestamp(format(timestamp)));
+    }
+}
+
+TEST(Timestamp, ParseUtcOffsets) {
+    const auto expected = from_milliseconds(1593355910240);
+
+    EXPECT_EQ(expected, reader::parse_timestamp("2020-06-28T14:51:50.240Z"));
+    EXPECT_EQ(expected, reader::parse_timestamp("2020-06-28T16:51:50.240+0200"));
+    EXPECT_EQ(expected, reader::parse_timestamp("2020-06-28T16:51:50.240+02:00"));
+    EXPECT_EQ(expected, reader::parse_timestamp("2020-06-28T09:21:50.240-0530"));
+    EXPECT_EQ(expected - std::chrono::milliseconds{240},
+              reader::parse_timestamp("2020-06-28T14:51:50Z"));
+    EXPECT_EQ(expected - std::chrono::milliseconds{40},
+              reader::parse_timestamp("2020-06-28T14:51:50.2Z"));
+}
+
+TEST(Timestamp, ParseLocalTime) {
+    const auto timestamp = from_milliseconds(1593355910240);
+    const auto formatted = format(timestamp);
+
+    // Drop the UTC offset
+    EXPECT_EQ(timestamp, reader::parse_timestamp(formatted.substr(0, 23)));
+}
+
+TEST(Timestamp, ParseInvalid) {
+    for (const auto s : {"",
+                         "2020-06-28",
+                         "2020-06-28 14:51:50Z",
+                         "2020-13-28T14:51:50Z",
+                         "2020-06-28T24:51:50Z",
+                         "2020-06-28T14:51:50.Z",
+                         "2020-06-28T14:51:50+2",
+                         "2020-06-28T14:51:50Zjunk"}) {
+        EXPECT_EQ(std::nullopt, reader::parse_timestamp(s)) << s;
+    }
+}
@@ -0,0 +1,158 @@
+#include "test/isa.h"
+#include "utf8.h"
+
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Validates a string with nlohmann::json, which is the reference for the logger output
+auto nlohmann_valid(const std::string& s) -> bool {
+    try {
+        nlohmann::json(s).dump();
+        return true;
+    } catch (const nlohmann::json::type_error&) {
+        return false;
+    }
+}
+
+auto expect_all_agree(const std::string& s) -> void {
+    const auto expected = nlohmann_valid(s);
+    for (const auto isa : test::supported_isas()) {
+        ASSERT_EQ(expected, reader::is_valid_utf8(s, isa))
+            << "isa " << static_cast<int>(isa) << ", size " << s.size();
+    }
+}
+
+} // namespace
+
+TEST(Utf8, ScalarIsAlwaysSupported) {
+    EXPECT_TRUE(reader::supported(reader::simd_isa::scalar));
+    EXPECT_TRUE(reader::supported(reader::best_simd_isa()));
+}
+
+TEST(Utf8, Empty) {
+    for (const auto isa : test::supported_isas()) {
+        EXPECT_TRUE(reader::is_valid_utf8("", isa));
+    }
+    EXPECT_EQ("", reader::describe_invalid_utf8(""));
+}
+
+TEST(Utf8, AllOneAndTwoByteStrings) {
+    for (auto i = 0; i < 256; ++i) {
+        expect_all_agree(std::string(1, static_cast<char>(i)));
+
+        for (auto j = 0; j < 256; ++j) {
+            expect_all_agree({static_cast<char>(i), static_cast<char>(j)});
+        }
+    }
+}
+
+TEST(Utf8, ThreeAndFourByteSequences) {
+    // Lead bytes of multi-byte sequences with continuation bytes around the valid ranges
+    const auto continuations = std::vector<char>{
+        '\x00', '\x41', '\x7f', '\x80', '\x8f', '\x90', '\x9f', '\xa0', '\xbf', '\xc0', '\xff'};
+
+    for (auto lead = 0xE0; lead <= 0xF7; ++lead) {
+        for (const auto b1 : continuations) {
+            for (const auto b2 : continuations) {
+                expect_all_agree({static_cast<char>(lead), b1, b2});
+
+                for (const auto b3 : continuations) {
+                    expect_all_agree({static_cast<char>(lead), b1, b2, b3});
+                }
+            }
+        }
+    }
+}
+
+TEST(Utf8, SequencesAcrossBlockBoundaries) {
+    // Multi-byte sequences starting at every offset around the 16 and 32 byte blocks
+    const auto sequences = std::vector<std::string>{
+        "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\xa0\x80", "\xf4\x90\x80\x80"};
+
+    for (const auto& sequence : sequences) {
+        for (auto offset = std::size_t{0}; offset < 70; ++offset) {
+            auto s = std::string(offset, 'a') + sequence + std::string(3, 'b');
+            expect_all_agree(s);
+
+            // Truncated at the end of the string
+            s = std::string(offset, 'a') + sequence.substr(0, sequence.size() - 1);
+            expect_all_agree(s);
+        }
+    }
+}
+
+TEST(Utf8, RandomStrings) {
+    auto gen = std::mt19937{42};
+    auto byte = std::uniform_int_distribution<int>{0, 255};
+    auto code_point = std::uniform_int_distribution<std::uint32_t>{0, 0x10FFFF};
+    auto length = std::uniform_int_distribution<std::size_t>{0, 255};
+
+    const auto append = [](std::string& s, std::uint32_t c) {
+        if (c < 0x80) {
+            s.push_back(static_cast<char>(c));
+        } else if (c < 0x800) {
+            s.push_back(static_cast<char>(0xC0 | (c >> 6)));
+            s.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        } else if (c < 0x10000) {
+            s.push_back(static_cast<char>(0xE0 | (c >> 12)));
+            s.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            s.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        } else {
+            s.push_back(static_cast<char>(0xF0 | (c >> 18)));
+            s.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+            s.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            s.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+    };
+
+    for (auto i = 0; i < 2000; ++i) {
+        // Mostly valid strings, including surrogates, with a single random byte replaced
+        auto s = std::string{};
+        const auto size = length(gen);
+        while (s.size() < size) {
+            append(s, code_point(gen));
+        }
+        expect_all_agree(s);
+
+        if (!s.empty()) {
+            s[std::uniform_int_distribution<std::size_t>{0, s.size() - 1}(gen)] =
+                static_cast<char>(byte(gen));
+            expect_all_agree(s);
+        }
+    }
+}
+
+TEST(Utf8, DescribeMatchesNlohmann) {
+    const auto names = std::vector<std::string>{
+        "valid",
+        "h\xc3\xa9ll\xc3\xb6",
+        "\xff\xff\xff",
+        "ab\xc3",
+        "ab\xc3\x41",
+        "\xe0\x80\x80",
+        "\xed\xa0\x80",
+        "\xf0\x9f\x98",
+        "\xf4\x90\x80\x80",
+        "\xc0\xaf",
+        "0123456789abcdef0123456789abcdef\x80",
+    };
+
+    for (const auto& name : names) {
+        auto expected = std::string{};
+        try {
+            nlohmann::json(name).dump();
+        } catch (const nlohmann::json::type_error& ex) {
+            expected = ex.what();
+            expected.erase(0, std::string{"[json.exception.type_error.316] "}.size());
+        }
+
+        EXPECT_EQ(expected, reader::describe_invalid_utf8(name));
+    }
+}
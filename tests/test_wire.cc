@@ -0,0 +1,123 @@
+#include "compat/asio.h"
+#include "message.h"
+#include "test/encode.h"
+#include "wire.h"
+
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+using schema = reader::wire::message_schema;
+
+constexpr unsigned char three_bytes[] = {0x12, 0x34, 0x56};
+static_assert(reader::wire::big_endian<3>::read(three_bytes) == 0x123456);
+static_assert(reader::wire::big_endian<3>::max == 0xFFFFFF);
+static_assert(reader::wire::big_endian<8>::max == 0xFFFFFFFFFFFFFFFF);
+static_assert(schema::trailing_fields::max_size == 5);
+
+} // namespace
+
+TEST(Wire, BigEndian) {
+    auto bytes = std::array<unsigned char, 8>{};
+
+    EXPECT_EQ(bytes.data() + 3, reader::wire::big_endian<3>::write(0xAB123456, bytes.data()));
+    EXPECT_EQ((std::array<unsigned char, 8>{0x12, 0x34, 0x56}), bytes);
+    EXPECT_EQ(0x123456u, reader::wire::big_endian<3>::read(bytes.data()));
+
+    reader::wire::big_endian<8>::write(0x0102030405060708, bytes.data());
+    EXPECT_EQ((std::array<unsigned char, 8>{1, 2, 3, 4, 5, 6, 7, 8}), bytes);
+    EXPECT_EQ(0x0102030405060708u, reader::wire::big_endian<8>::read(bytes.data()));
+}
+
+TEST(Wire, TrailingFields) {
+    using trailing = schema::trailing_fields;
+
+    EXPECT_EQ(0b00, trailing::present(0));
+    EXPECT_EQ(0b10, trailing::present(2));
+    EXPECT_EQ(0b01, trailing::present(3));
+    EXPECT_EQ(0b11, trailing::present(5));
+
+    for (const auto size : {1, 4, 6, 255}) {
+        EXPECT_FALSE(trailing::present(static_cast<std::size_t>(size))) << size;
+    }
+
+    EXPECT_EQ(0, trailing::offset<schema::humidity_field>(0b10));
+    EXPECT_EQ(3, trailing::offset<schema::humidity_field>(0b11));
+    EXPECT_EQ(3, trailing::size(0b01));
+    EXPECT_EQ(5, trailing::size(0b11));
+}
+
+TEST(Wire, Encode) {
+    const auto fields = reader::wire::message_fields{0x0102030405060708, "abc", 0x0A0B0C, 0x0D0E};
+
+    auto data = std::vector<unsigned char>(reader::wire::payload_size(fields));
+    EXPECT_EQ(data.data() + data.size(), reader::wire::encode(fields, data.data()));
+
+    EXPECT_EQ((std::vector<unsigned char>{
+                  0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, // timestamp
+                  0x03,                                           // nlen
+                  'a',  'b',  'c',                                // name
+                  0x0A, 0x0B, 0x0C,                               // temperature
+                  0x0D, 0x0E,                                     // humidity
+              }),
+              data);
+}
+
+TEST(Wire, EncodeFrame) {
+    const auto fields = reader::wire::message_fields{123, "abc", std::nullopt, 808};
+
+    auto frame = std::vector<unsigned char>(schema::length::size +
+                                            reader::wire::payload_size(fields));
+    EXPECT_EQ(frame.data() + frame.size(), reader::wire::encode_frame(fields, frame.data()));
+
+    EXPECT_EQ(reader::wire::payload_size(fields),
+              reader::decode_message_payload_length(asio::buffer(frame.data(), 4)));
+    EXPECT_EQ(test::encode(fields),
+              std::vector<unsigned char>(frame.cbegin() + schema::length::size, frame.cend()));
+}
+
+TEST(Wire, EncodeTruncatesName) {
+    const auto name = std::string(300, 'a');
+    const auto data = test::encode({0, name, std::nullopt, std::nullopt});
+
+    const auto message = reader::MessageView{asio::buffer(data)};
+    EXPECT_EQ(name.substr(0, 255), message.name());
+}
+
+TEST(Wire, DecodesEveryCombinationOfFields) {
+    for (const auto temperature : {std::optional<std::uint32_t>{}, std::optional{27315u}}) {
+        for (const auto humidity : {std::optional<std::uint16_t>{}, std::optional<uint16_t>{10}}) {
+            const auto data = test::encode({123, "handdata", temperature, humidity});
+            const auto message = reader::MessageView{asio::buffer(data)};
+
+            EXPECT_EQ(reader::MessageView::time_point_t{std::chrono::milliseconds{123}},
+                      message.timestamp());
+            EXPECT_EQ("handdata", message.name());
+            EXPECT_EQ(temperature ? std::optional{0.0f} : std::nullopt, message.temperature());
+            EXPECT_EQ(humidity ? std::optional{1.0f} : std::nullopt, message.humidity());
+        }
+    }
+}
+
+TEST(Wire, Validate) {
+    auto data = test::encode({0, "abc", 1, 2});
+    auto layout = reader::wire::message_layout{};
+
+    EXPECT_EQ(std::nullopt, reader::wire::validate(data.data(), data.size(), layout));
+    EXPECT_EQ(3, layout.name_size);
+    EXPECT_EQ(0b11, layout.present);
+
+    EXPECT_EQ(reader::wire::layout_error::too_small,
+              reader::wire::validate(data.data(), schema::min_payload - 1, layout));
+    EXPECT_EQ(reader::wire::layout_error::unused_bytes,
+              reader::wire::validate(data.data(), data.size() - 1, layout));
+
+    data[schema::name_offset] = 200;
+    EXPECT_EQ(reader::wire::layout_error::name_overrun,
+              reader::wire::validate(data.data(), data.size(), layout));
+}
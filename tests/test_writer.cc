@@ -0,0 +1,129 @@
+#include "writer.h"
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+/// A stringbuf which can be read while the writer thread writes to it
+class synchronized_stringbuf : public std::stringbuf {
+  public:
+    auto contents() -> std::string {
+        const auto lock = std::lock_guard<std::recursive_mutex>{mutex_};
+        return str();
+    }
+
+  protected:
+    auto xsputn(const char* s, std::streamsize n) -> std::streamsize override {
+        const auto lock = std::lock_guard<std::recursive_mutex>{mutex_};
+        return std::stringbuf::xsputn(s, n);
+    }
+
+    auto overflow(int_type c) -> int_type override {
+        const auto lock = std::lock_guard<std::recursive_mutex>{mutex_};
+        return std::stringbuf::overflow(c);
+    }
+
+  private:
+    std::recursive_mutex mutex_;
+};
+
+/// Polls `buf` until it is not empty or the timeout expires
+auto wait_for_output(synchronized_stringbuf& buf, std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (buf.contents().empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    return buf.contents();
+}
+
+} // namespace
+
+TEST(Writer, FlushWritesRecords) {
+    auto out = std::stringstream{};
+    auto writer = logger::Writer{out, 1024, 1h};
+
+    writer.write("first");
+    writer.write("second");
+    writer.flush();
+
+    EXPECT_EQ("first\nsecond\n", out.str());
+}
+
+TEST(Writer, DestructorWritesRecords) {
+    auto out = std::stringstream{};
+    {
+        auto writer = logger::Writer{out, 1024, 1h};
+        writer.write("record");
+    }
+
+    EXPECT_EQ("record\n", out.str());
+}
+
+TEST(Writer, WritesOnSizeThreshold) {
+    auto buf = synchronized_stringbuf{};
+    auto out = std::ostream{&buf};
+    auto writer = logger::Writer{out, 8, 1h};
+
+    writer.write("0123456789");
+
+    EXPECT_EQ("0123456789\n", wait_for_output(buf, 5s));
+}
+
+TEST(Writer, WritesOnTimeThreshold) {
+    auto buf = synchronized_stringbuf{};
+    auto out = std::ostream{&buf};
+    auto writer = logger::Writer{out, 1024, 10ms};
+
+    writer.write("record");
+
+    EXPECT_EQ("record\n", wait_for_output(buf, 5s));
+}
+
+TEST(Writer, BuffersBelowThresholds) {
+    auto buf = synchronized_stringbuf{};
+    auto out = std::ostream{&buf};
+    auto writer = logger::Writer{out, 1024, 1h};
+
+    writer.write("record");
+    std::this_thread::sleep_for(10ms);
+
+    EXPECT_EQ("", buf.contents());
+}
+
+TEST(Writer, IndexesRecords) {
+    auto out = std::stringstream{};
+    auto index_out = std::stringstream{};
+    auto builder = logger::IndexBuilder{4};
+    {
+        auto writer = logger::Writer{out, index_out, builder, 1024, 1h};
+
+        writer.write("unindexed");
+        writer.write("first", {"abc", std::chrono::system_clock::time_point{1s}});
+        writer.write("second", {"def", std::chrono::system_clock::time_point{2s}});
+        writer.flush();
+
+        // The index is written after the records it refers to
+        const auto flushed = logger::Index{index_out.str()};
+        ASSERT_EQ(1, flushed.blocks().size());
+        EXPECT_EQ(10, flushed.blocks()[0].offset);
+        EXPECT_EQ(6, flushed.blocks()[0].size);
+    }
+
+    EXPECT_EQ("unindexed\nfirst\nsecond\n", out.str());
+
+    // The last block is written when the Writer is destroyed
+    const auto index = logger::Index{index_out.str()};
+    ASSERT_EQ(2, index.blocks().size());
+    EXPECT_EQ(16, index.blocks()[1].offset);
+    EXPECT_EQ(7, index.blocks()[1].size);
+    EXPECT_EQ(2000, index.blocks()[1].min_timestamp);
+    EXPECT_EQ(out.str().size(), index.end());
+}